@@ -48,6 +48,10 @@ This file contains modifications for XawPlus, Roland Krause 2002
 #include <stdlib.h>
 #endif
 #include <X11/Xfuncs.h>
+#if defined(_POSIX_MAPPED_FILES) && (_POSIX_MAPPED_FILES > 0)
+#include <sys/mman.h>
+#define USE_MMAP 1
+#endif
 #include <X11/XawPlus/XawInit.h>
 #include <X11/XawPlus/AsciiSrcP.h>
 #include <X11/Xmu/Misc.h>
@@ -79,12 +83,16 @@ static XtResource resources[] = {
        offset(data_compression), XtRImmediate, (XtPointer) TRUE},
     {XtNpieceSize, XtCPieceSize, XtRInt, sizeof (XawTextPosition),
        offset(piece_size), XtRImmediate, (XtPointer) BUFSIZ},
+    {XtNpieceTable, XtCPieceTable, XtRBoolean, sizeof (Boolean),
+       offset(piece_table), XtRImmediate, (XtPointer) FALSE},
     {XtNcallback, XtCCallback, XtRCallback, sizeof(XtPointer),
        offset(callback), XtRCallback, (XtPointer)NULL},
     {XtNuseStringInPlace, XtCUseStringInPlace, XtRBoolean, sizeof (Boolean),
        offset(use_string_in_place), XtRImmediate, (XtPointer) FALSE},
     {XtNlength, XtCLength, XtRInt, sizeof (int),
        offset(ascii_length), XtRInt, (XtPointer) &magic_value},
+    {XtNmmapFile, XtCMmapFile, XtRBoolean, sizeof (Boolean),
+       offset(mmap_file), XtRImmediate, (XtPointer) FALSE},
 
 #ifdef ASCII_DISK
     {XtNfile, XtCFile, XtRString, sizeof (String),
@@ -99,11 +107,35 @@ static XawTextPosition ReadText(Widget, XawTextPosition, XawTextBlock *, int);
 static int ReplaceText(Widget, XawTextPosition, XawTextPosition, XawTextBlock *);
 static Piece * FindPiece(AsciiSrcObject, XawTextPosition, XawTextPosition *);
 static Piece * AllocNewPiece(AsciiSrcObject, Piece *);
+static Piece * NewPiece(void);
+static Piece * PrependPiece(AsciiSrcObject);
+static void LinkPiece(AsciiSrcObject, Piece *, Piece *, Boolean);
+static Piece * SplitPiece(AsciiSrcObject, XawTextPosition);
+static char * AppendText(AsciiSrcObject, char *, int);
+static void ReplacePieces(AsciiSrcObject, XawTextPosition, XawTextPosition, XawTextBlock *);
+static void FreeTextBuffers(AsciiSrcObject);
+static void UpdatePiece(AsciiSrcObject, Piece *);
+static void UpdateTotals(Piece *);
+static void SumPiece(Piece *);
+static void SumSubtree(Piece *);
+static XawTextPosition CountLines(char *, XawTextPosition);
+static void IndexLines(AsciiSrcObject);
+static XawTextPosition FindNewline(AsciiSrcObject, XawTextPosition);
+static XawTextPosition LinesBefore(AsciiSrcObject, XawTextPosition);
+static XawTextPosition ScanLines(AsciiSrcObject, XawTextPosition, XawTextScanDirection, int, Bool);
+static XawTextPosition ScanChars(AsciiSrcObject, XawTextPosition, XawTextScanDirection, int, int *);
+static XawTextPosition SearchText(AsciiSrcObject, XawTextPosition, XawTextScanDirection, XawTextBlock *, Boolean);
+static Boolean MatchText(Piece *, XawTextPosition, char *, int, XawTextScanDirection, Boolean);
+static XawTextPosition SearchHorspool(AsciiSrcObject, XawTextPosition, XawTextScanDirection, char *, int, Boolean);
+static int CompareText(char *, char *, int, Boolean);
+static void RotatePiece(AsciiSrcObject, Piece *);
 static FILE * InitStringOrFile(AsciiSrcObject, Boolean);
 static void FreeAllPieces(AsciiSrcObject);
 static void RemovePiece(AsciiSrcObject, Piece *);
 static void BreakPiece(AsciiSrcObject, Piece *);
 static void LoadPieces(AsciiSrcObject, FILE *, char *);
+static Boolean MapPieces(AsciiSrcObject, FILE *);
+static void UnmapPieces(AsciiSrcObject);
 static void RemoveOldStringOrFile(AsciiSrcObject, Boolean);
 static void CvtStringToAsciiType(XrmValuePtr, Cardinal*, XrmValuePtr, XrmValuePtr);
 static void ClassInitialize(void);
@@ -126,6 +158,36 @@ extern int errno;
 #define Size_t size_t
 #endif
 
+#define PieceTotal(p)		((p) != NULL ? (p)->total : 0)
+#define PieceLines(p)		((p) != NULL ? (p)->line_total : 0)
+
+/*
+ * The kinds of characters that ScanChars() looks for.
+ */
+
+#define SCAN_NEWLINE	0	/* a newline. */
+#define SCAN_SPACE	1	/* any white space. */
+#define SCAN_NONSPACE	2	/* anything but white space. */
+#define SCAN_BREAK	3	/* a newline, or anything but white space. */
+
+#define ScanMatch(c, what) \
+	((what) == SCAN_NEWLINE ? (c) == '\n' : \
+	 (what) == SCAN_SPACE ? isspace(c) != 0 : \
+	 (what) == SCAN_NONSPACE ? isspace(c) == 0 : \
+	 ((c) == '\n' || isspace(c) == 0))
+
+#define HORSPOOL_MIN	4	/* shortest string for SearchHorspool(). */
+
+#define FoldChar(c, fold)	((fold) ? tolower(c) : (c))
+
+/*
+ * Pieces own their text unless it belongs to the application's string,
+ * to a file mapping or to the buffers of a piece table.
+ */
+#define PiecesOwnText(src)	(!(src)->ascii_src.use_string_in_place && \
+				 ((src)->ascii_src.mapped_text == NULL) && \
+				 !(src)->ascii_src.piece_table)
+
 #define superclass		(&textSrcClassRec)
 AsciiSrcClassRec asciiSrcClassRec = {
   {
@@ -241,6 +303,14 @@ Initialize(
 
     src->ascii_src.changes = FALSE;
     src->ascii_src.allocated_string = FALSE;
+    src->ascii_src.mapped_text = NULL;
+    src->ascii_src.mapped_length = 0;
+    src->ascii_src.original_text = NULL;
+    src->ascii_src.add_buffer = NULL;
+    src->ascii_src.lines_indexed = FALSE;
+
+    if (src->ascii_src.use_string_in_place)
+	src->ascii_src.piece_table = FALSE;
 
     file = InitStringOrFile(src, src->ascii_src.type == XawAsciiFile);
     LoadPieces(src, file, NULL);
@@ -303,6 +373,12 @@ ReplaceText(
     if (src->text_src.edit_mode == XawtextRead)
 	return (XawEditError);
 
+    if (src->ascii_src.piece_table) {
+	ReplacePieces(src, startPos, endPos, text);
+	XtCallCallbacks(w, XtNcallback, NULL);
+	return (XawEditDone);
+    }
+
     start_piece = FindPiece(src, startPos, &start_first);
     end_piece = FindPiece(src, endPos, &end_first);
 
@@ -319,7 +395,9 @@ ReplaceText(
  * If empty and not the only piece then remove it.
  */
 
-	if (((start_piece->used = startPos - start_first) == 0) &&
+	start_piece->used = startPos - start_first;
+	UpdatePiece(src, start_piece);
+	if ((start_piece->used == 0) &&
 	    !((start_piece->next == NULL) && (start_piece->prev == NULL)))
 	    RemovePiece(src, start_piece);
 
@@ -331,10 +409,14 @@ ReplaceText(
 	if (end_piece->used != 0)
 	    MyStrncpy(end_piece->text, (end_piece->text + endPos - end_first),
 		      (int) end_piece->used);
+	UpdatePiece(src, end_piece);
     } else {			/* We are fully in one piece. */
-	if ((start_piece->used -= endPos - startPos) == 0) {
+	start_piece->used -= endPos - startPos;
+	if (start_piece->used == 0) {
 	    if (!((start_piece->next == NULL) && (start_piece->prev == NULL)))
 		RemovePiece(src, start_piece);
+	    else
+		UpdatePiece(src, start_piece);
 	} else {
 	    MyStrncpy(start_piece->text + (startPos - start_first),
 		      start_piece->text + (endPos - start_first),
@@ -344,6 +426,7 @@ ReplaceText(
 		 (src->ascii_src.piece_size - 1)))
 		start_piece->text[src->ascii_src.length - (endPos -
 		    startPos)] = '\0';
+	    UpdatePiece(src, start_piece);
 	}
     }
 
@@ -373,6 +456,7 @@ ReplaceText(
 		    start_piece->used = src->ascii_src.length =
 			src->ascii_src.piece_size - 1;
 		    start_piece->text[src->ascii_src.length] = '\0';
+		    UpdatePiece(src, start_piece);
 		    return (XawEditError);
 		}
 	    }
@@ -393,6 +477,7 @@ ReplaceText(
 	    startPos += fill;
 	    firstPos += fill;
 	    start_piece->used += fill;
+	    UpdatePiece(src, start_piece);
 	    length -= fill;
 	}
     }
@@ -438,7 +523,8 @@ Scan(
     Piece *piece;
     XawTextPosition first = 0;
     XawTextPosition first_eol_position = 0;
-    char *ptr;
+    XawTextPosition found;
+    int c;
 
     if (type == XawstAll) {	/* Optomize this common case. */
 	if (dir == XawsdRight)
@@ -449,6 +535,9 @@ Scan(
     if (position > src->ascii_src.length)
 	position = src->ascii_src.length;
 
+    if ((type == XawstEOL) && (count > 1))
+	return (ScanLines(src, position, dir, count, include));
+
     if (dir == XawsdRight) {
 	if (position == src->ascii_src.length)
 /*
@@ -472,54 +561,40 @@ Scan(
     if (piece->used == 0)
 	return (0);
 
-    ptr = (position - first) + piece->text;
+/*
+ * Each step looks for the next interesting character with ScanChars(),
+ * which works through whole pieces at a time.  Afterwards position is
+ * one beyond the character that ended the step, in the scan direction.
+ */
 
     switch (type) {
     case XawstEOL:
     case XawstParagraph:
     case XawstWhiteSpace:
 	for (; count > 0; count--) {
-	    Boolean non_space = FALSE, first_eol = TRUE;
-	    /* CONSTCOND */
-	    while (TRUE) {
-		unsigned char c = (unsigned char) *ptr;
-
-		ptr += inc;
-		position += inc;
-
-		if (type == XawstWhiteSpace) {
-		    if (isspace(c)) {
-			if (non_space)
-			    break;
-		    } else
-			non_space = TRUE;
-		} else if (type == XawstEOL) {
-		    if (c == '\n')
+	    if (type == XawstEOL) {
+		found = ScanChars(src, position, dir, SCAN_NEWLINE, &c);
+	    } else if (type == XawstWhiteSpace) {
+		found = ScanChars(src, position, dir, SCAN_NONSPACE, &c);
+		if (found >= 0)
+		    found = ScanChars(src, found + inc, dir, SCAN_SPACE, &c);
+	    } else {		/* XawstParagraph */
+		do {
+		    found = ScanChars(src, position, dir, SCAN_NEWLINE, &c);
+		    if (found < 0)
 			break;
-		} else {	/* XawstParagraph */
-		    if (first_eol) {
-			if (c == '\n') {
-			    first_eol_position = position;
-			    first_eol = FALSE;
-			}
-		    } else if (c == '\n')
-			break;
-		    else if (!isspace(c))
-			first_eol = TRUE;
-		}
-
-		if (ptr < piece->text) {
-		    piece = piece->prev;
-		    if (piece == NULL)	/* Begining of text. */
-			return (0);
-		    ptr = piece->text + piece->used - 1;
-		} else if (ptr >= (piece->text + piece->used)) {
-		    piece = piece->next;
-		    if (piece == NULL)	/* End of text. */
-			return (src->ascii_src.length);
-		    ptr = piece->text;
-		}
+		    first_eol_position = found + inc;
+		    found = ScanChars(src, found + inc, dir, SCAN_BREAK, &c);
+		    if (found >= 0)
+			position = found + inc;
+		} while (found >= 0 && c != '\n');
 	    }
+	    if (found < 0) {
+		if (dir == XawsdRight)	/* End of text. */
+		    return (src->ascii_src.length);
+		return (0);	/* Begining of text. */
+	    }
+	    position = found + inc;
 	}
 	if (!include) {
 	    if (type == XawstParagraph)
@@ -561,69 +636,85 @@ Search(
 	  XawTextScanDirection dir,
 	  XawTextBlock * text)
 {
-    AsciiSrcObject src = (AsciiSrcObject) w;
-    int inc, count = 0;
-    char *ptr;
+    return (SearchText((AsciiSrcObject) w, position, dir, text, False));
+}
+
+/*	Function Name: SearchText
+ *	Description: Searchs the text source for the text block passed,
+ *                   for Search() and _XawAsciiSourceSearchIgnoreCase().
+ *	Arguments: src - the AsciiSource Widget.
+ *                 position - the position to start scanning.
+ *                 dir - direction to scan.
+ *                 text - the text block to search for.
+ *                 fold - True to ignore the case of letters.
+ *	Returns: the position of the item found.
+ */
+
+static XawTextPosition
+SearchText(
+	      AsciiSrcObject src,
+	      XawTextPosition position,
+	      XawTextScanDirection dir,
+	      XawTextBlock * text,
+	      Boolean fold)
+{
     Piece *piece;
-    char *buf;
-    XawTextPosition first;
+    char *buf, *ptr, *end;
+    XawTextPosition first, i;
+    int length = text->length;
 
-    if (dir == XawsdRight)
-	inc = 1;
-    else {
-	inc = -1;
+    if (position > src->ascii_src.length)
+	position = src->ascii_src.length;
+    if (dir == XawsdLeft) {
 	if (position == 0)
 	    return (XawTextSearchError);	/* scanning left from 0??? */
 	position--;
     }
+    if ((length <= 0) || (position < 0) ||
+	(position >= src->ascii_src.length))
+	return (XawTextSearchError);
 
-    buf = XtMalloc((unsigned) sizeof(unsigned char) * (unsigned) text->length);
-    strncpy(buf, (text->ptr + text->firstPos), (size_t) text->length);
-    piece = FindPiece(src, position, &first);
-    ptr = (position - first) + piece->text;
+    buf = text->ptr + text->firstPos;
+    if (fold || (length >= HORSPOOL_MIN))
+	return (SearchHorspool(src, position, dir, buf, length, fold));
 
-    /* CONSTCOND */
-    while (TRUE) {
-	if (*ptr == ((dir == XawsdRight) ? *(buf + count)
-		     : *(buf + text->length - count - 1))) {
-	    if (count == (text->length - 1))
-		break;
-	    else
-		count++;
-	} else {
-	    if (count != 0) {
-		position -= inc * count;
-		ptr -= inc * count;
-	    }
-	    count = 0;
-	}
-
-	ptr += inc;
-	position += inc;
+    piece = FindPiece(src, position, &first);
 
-	while (ptr < piece->text) {
-	    piece = piece->prev;
-	    if (piece == NULL) {	/* Begining of text. */
-		XtFree(buf);
-		return (XawTextSearchError);
-	    }
-	    ptr = piece->text + piece->used - 1;
-	}
+/*
+ * Short strings gain little from skipping, so the candidates are found
+ * by looking for the first (or, to the left, the last) character of the
+ * string a piece at a time, and only there the whole string is compared.
+ */
 
-	while (ptr >= (piece->text + piece->used)) {
-	    piece = piece->next;
-	    if (piece == NULL) {	/* End of text. */
-		XtFree(buf);
-		return (XawTextSearchError);
+    if (dir == XawsdRight) {
+	ptr = piece->text + (position - first);
+	for (;;) {
+	    end = piece->text + piece->used;
+	    while (ptr < end &&
+		   (ptr = memchr(ptr, buf[0], (size_t) (end - ptr))) != NULL) {
+		if (MatchText(piece, ptr - piece->text, buf, length, dir, False))
+		    return (first + (ptr - piece->text));
+		ptr++;
 	    }
+	    first += piece->used;
+	    if ((piece = piece->next) == NULL)
+		break;
 	    ptr = piece->text;
 	}
+    } else {
+	i = position - first;
+	for (;;) {
+	    for (; i >= 0; i--)
+		if ((piece->text[i] == buf[length - 1]) &&
+		    MatchText(piece, i, buf, length, dir, False))
+		    return (first + i - (length - 1));
+	    if ((piece = piece->prev) == NULL)
+		break;
+	    first -= piece->used;
+	    i = piece->used - 1;
+	}
     }
-
-    XtFree(buf);
-    if (dir == XawsdLeft)
-	return (position);
-    return (position - (text->length - 1));
+    return (XawTextSearchError);
 }
 
 /*	Function Name: SetValues
@@ -655,6 +746,12 @@ SetValues(
 	    old_src->ascii_src.use_string_in_place;
     }
 
+    if (old_src->ascii_src.piece_table != src->ascii_src.piece_table) {
+	XtAppWarning(XtWidgetToApplicationContext(new),
+		     "AsciiSrc: The XtNpieceTable resource may not be changed.");
+	src->ascii_src.piece_table = old_src->ascii_src.piece_table;
+    }
+
     for (i = 0; (Cardinal) i < *num_args; i++)
 	if (streq(args[i].name, XtNstring)) {
 	    string_set = TRUE;
@@ -663,6 +760,10 @@ SetValues(
 
     if (string_set || (old_src->ascii_src.type != src->ascii_src.type)) {
 	RemoveOldStringOrFile(old_src, string_set);	/* remove old info. */
+	src->ascii_src.mapped_text = NULL;
+	src->ascii_src.mapped_length = 0;
+	src->ascii_src.original_text = NULL;
+	src->ascii_src.add_buffer = NULL;
 	file = InitStringOrFile(src, string_set);	/* Init new info. */
 	LoadPieces(src, file, NULL);	/* load new info into internal buffers. */
 	if (file != NULL)
@@ -675,7 +776,19 @@ SetValues(
     if (old_src->ascii_src.ascii_length != src->ascii_src.ascii_length)
 	src->ascii_src.piece_size = src->ascii_src.ascii_length;
 
-    if (!total_reset &&
+/*
+ * A mapped file is read-only; copy it into ordinary pieces as soon as
+ * the source becomes editable.
+ */
+
+    if (!total_reset && (src->ascii_src.mapped_text != NULL) &&
+	(src->text_src.edit_mode != XawtextRead)) {
+	FreeAllPieces(src);
+	LoadPieces(src, NULL, src->ascii_src.mapped_text);
+	UnmapPieces(src);
+    }
+
+    if (!total_reset && (src->ascii_src.mapped_text == NULL) &&
 	(old_src->ascii_src.piece_size != src->ascii_src.piece_size)) {
 	char *string = StorePiecesInString(old_src);
 	FreeAllPieces(old_src);
@@ -878,6 +991,63 @@ XawAsciiSourceChanged(Widget w)
     return (True);		/* for gcc -Wall */
 }
 
+/*	Function Name: _XawAsciiSourceLineToPosition
+ *	Description: Finds the start of a line, for XawTextSourceLineToPosition.
+ *	Arguments: w - the ascii source widget.
+ *                 line - the line number, counting from 0.
+ *	Returns: the position, or the end of the text if there are
+ *               fewer lines.
+ */
+
+XawTextPosition
+_XawAsciiSourceLineToPosition(Widget w, long line)
+{
+    AsciiSrcObject src = (AsciiSrcObject) w;
+    XawTextPosition newline;
+
+    if (line <= 0)
+	return (0);
+    if ((newline = FindNewline(src, (XawTextPosition) line)) < 0)
+	return (src->ascii_src.length);
+    return (newline + 1);
+}
+
+/*	Function Name: _XawAsciiSourcePositionToLine
+ *	Description: Finds the line of a position, for
+ *                   XawTextSourcePositionToLine.
+ *	Arguments: w - the ascii source widget.
+ *                 position - the position.
+ *	Returns: the line number, counting from 0.
+ */
+
+long
+_XawAsciiSourcePositionToLine(Widget w, XawTextPosition position)
+{
+    AsciiSrcObject src = (AsciiSrcObject) w;
+
+    if (position > src->ascii_src.length)
+	position = src->ascii_src.length;
+    return ((long) LinesBefore(src, position));
+}
+
+/*	Function Name: _XawAsciiSourceSearchIgnoreCase
+ *	Description: Searchs the text source for the text block passed,
+ *                   ignoring the case of letters.  This is used by
+ *                   XawTextSourceSearchCompiled().
+ *	Arguments: w - the ascii source widget.
+ *                 position - the position to start scanning.
+ *                 dir - direction to scan.
+ *                 text - the text block to search for.
+ *	Returns: the position of the item found.
+ */
+
+XawTextPosition
+_XawAsciiSourceSearchIgnoreCase(Widget w, XawTextPosition position,
+				XawTextScanDirection dir, XawTextBlock * text)
+{
+    return (SearchText((AsciiSrcObject) w, position, dir, text, True));
+}
+
 /************************************************************
  *
  * Private Functions.
@@ -890,6 +1060,7 @@ RemoveOldStringOrFile(
 			 Boolean checkString)
 {
     FreeAllPieces(src);
+    UnmapPieces(src);
 
     if (checkString && src->ascii_src.allocated_string) {
 	XtFree(src->ascii_src.string);
@@ -950,7 +1121,7 @@ StorePiecesInString(
  * This will refill all pieces to capacity.
  */
 
-    if (src->ascii_src.data_compression) {
+    if (src->ascii_src.data_compression && (src->ascii_src.mapped_text == NULL)) {
 	FreeAllPieces(src);
 	LoadPieces(src, NULL, string);
     }
@@ -1072,7 +1243,11 @@ LoadPieces(
     Piece *piece = NULL;
     XawTextPosition left;
 
+    src->ascii_src.lines_indexed = FALSE;
+
     if (string == NULL) {
+	if (MapPieces(src, file))
+	    return;
 	if (src->ascii_src.type == XawAsciiFile) {
 	    local_str = XtMalloc((unsigned) (src->ascii_src.length + 1)
 				 * sizeof(unsigned char));
@@ -1104,6 +1279,38 @@ LoadPieces(
 	piece = AllocNewPiece(src, piece);
 	piece->used = Min(src->ascii_src.length, src->ascii_src.piece_size);
 	piece->text = src->ascii_src.string;
+	UpdatePiece(src, piece);
+	return;
+    }
+
+/*
+ * A piece table keeps the text in one buffer, and the pieces describe
+ * parts of it.  A file was read into a buffer of our own already.
+ */
+
+    if (src->ascii_src.piece_table) {
+	if ((src->ascii_src.type != XawAsciiFile) || (string != NULL)) {
+	    char *copy = XtMalloc((unsigned) (src->ascii_src.length + 1));
+
+	    if (src->ascii_src.length != 0)
+		memcpy(copy, local_str, (size_t) src->ascii_src.length);
+	    copy[src->ascii_src.length] = '\0';
+	    local_str = copy;
+	}
+	src->ascii_src.original_text = local_str;
+	src->ascii_src.add_buffer = NULL;
+
+	ptr = local_str;
+	left = src->ascii_src.length;
+	do {
+	    piece = AllocNewPiece(src, piece);
+	    piece->text = ptr;
+	    piece->used = Min(left, src->ascii_src.piece_size);
+	    UpdatePiece(src, piece);
+
+	    left -= piece->used;
+	    ptr += piece->used;
+	} while (left > 0);
 	return;
     }
 
@@ -1118,6 +1325,7 @@ LoadPieces(
 	piece->used = Min(left, src->ascii_src.piece_size);
 	if (piece->used != 0)
 	    strncpy(piece->text, ptr, (size_t) piece->used);
+	UpdatePiece(src, piece);
 
 	left -= piece->used;
 	ptr += piece->used;
@@ -1127,6 +1335,76 @@ LoadPieces(
 	XtFree(local_str);
 }
 
+/*	Function Name: MapPieces
+ *	Description: Maps a read-only file into memory and points the
+ *                   pieces into the mapping, rather than copying it.
+ *	Arguments: src - The AsciiSrc Widget.
+ *                 file - the file to map.
+ *	Returns: TRUE if the file was mapped.
+ */
+
+static Boolean
+MapPieces(
+	     AsciiSrcObject src,
+	     FILE *file)
+{
+#ifdef USE_MMAP
+    char *addr;
+    Piece *piece = NULL;
+    XawTextPosition left;
+
+    if (!src->ascii_src.mmap_file ||
+	(src->ascii_src.type != XawAsciiFile) ||
+	(src->text_src.edit_mode != XawtextRead) ||
+	(file == NULL) ||
+	(src->ascii_src.length <= 0))
+	return (FALSE);
+
+    addr = (char *) mmap(NULL, (Size_t) src->ascii_src.length, PROT_READ,
+			 MAP_SHARED, fileno(file), (Off_t) 0);
+    if (addr == (char *) MAP_FAILED)
+	return (FALSE);
+
+    src->ascii_src.mapped_text = addr;
+    src->ascii_src.mapped_length = src->ascii_src.length;
+
+    left = src->ascii_src.length;
+    do {
+	piece = AllocNewPiece(src, piece);
+	piece->text = addr;
+	piece->used = Min(left, src->ascii_src.piece_size);
+	UpdatePiece(src, piece);
+
+	left -= piece->used;
+	addr += piece->used;
+    } while (left > 0);
+
+    return (TRUE);
+#else
+    (void) src;
+    (void) file;
+    return (FALSE);
+#endif
+}
+
+/*	Function Name: UnmapPieces
+ *	Description: Releases the file mapping, if any.
+ *	Arguments: src - The AsciiSrc Widget.
+ *	Returns: none.
+ */
+
+static void
+UnmapPieces(
+	       AsciiSrcObject src)
+{
+#ifdef USE_MMAP
+    if (src->ascii_src.mapped_text != NULL)
+	munmap(src->ascii_src.mapped_text, (Size_t) src->ascii_src.mapped_length);
+#endif
+    src->ascii_src.mapped_text = NULL;
+    src->ascii_src.mapped_length = 0;
+}
+
 /*	Function Name: AllocNewPiece
  *	Description: Allocates a new piece of memory.
  *	Arguments: src - The AsciiSrc Widget.
@@ -1139,16 +1417,27 @@ AllocNewPiece(
 		 AsciiSrcObject src,
 		 Piece * prev)
 {
-    Piece *piece = XtNew(Piece);
+    Piece *piece = NewPiece();
 
     if (prev == NULL) {
 	src->ascii_src.first_piece = piece;
+	src->ascii_src.root_piece = piece;
 	piece->next = NULL;
+	piece->parent = NULL;
     } else {
 	if (prev->next != NULL)
 	    (prev->next)->prev = piece;
 	piece->next = prev->next;
 	prev->next = piece;
+
+	/*
+	 * The successor of prev is either its right child, or the leftmost
+	 * piece of its right subtree.
+	 */
+	if (prev->right == NULL)
+	    LinkPiece(src, piece, prev, FALSE);
+	else
+	    LinkPiece(src, piece, piece->next, TRUE);
     }
 
     piece->prev = prev;
@@ -1156,6 +1445,79 @@ AllocNewPiece(
     return (piece);
 }
 
+/*	Function Name: PrependPiece
+ *	Description: Allocates a new piece in front of the first one.
+ *	Arguments: src - The AsciiSrc Widget.
+ *	Returns: the allocated piece.
+ */
+
+static Piece *
+PrependPiece(
+		AsciiSrcObject src)
+{
+    Piece *piece = NewPiece();
+    Piece *first = src->ascii_src.first_piece;
+
+    piece->prev = NULL;
+    piece->next = first;
+    first->prev = piece;
+    src->ascii_src.first_piece = piece;
+    LinkPiece(src, piece, first, TRUE);
+
+    return (piece);
+}
+
+/*	Function Name: NewPiece
+ *	Description: Allocates an empty piece, which is not yet linked.
+ *	Arguments: none.
+ *	Returns: the allocated piece.
+ */
+
+static Piece *
+NewPiece(void)
+{
+    static unsigned long seed = 1;
+    Piece *piece = XtNew(Piece);
+
+    piece->text = NULL;
+    piece->used = 0;
+    piece->total = 0;
+    piece->lines = 0;
+    piece->line_total = 0;
+    piece->left = piece->right = NULL;
+    seed = seed * 1103515245L + 12345;
+    piece->weight = seed >> 8;
+
+    return (piece);
+}
+
+/*	Function Name: LinkPiece
+ *	Description: Adds an empty piece to the position index as a child
+ *                   of the given piece, and restores the heap order.
+ *	Arguments: src - The AsciiSrc Widget.
+ *                 piece - the new piece.
+ *                 parent - the piece that has no child on that side.
+ *                 left - TRUE to become the left child of parent.
+ *	Returns: none.
+ */
+
+static void
+LinkPiece(
+	     AsciiSrcObject src,
+	     Piece * piece,
+	     Piece * parent,
+	     Boolean left)
+{
+    if (left)
+	parent->left = piece;
+    else
+	parent->right = piece;
+    piece->parent = parent;
+
+    while (piece->parent != NULL && piece->parent->weight < piece->weight)
+	RotatePiece(src, piece);
+}
+
 /*	Function Name: FreeAllPieces
  *	Description: Frees all the pieces
  *	Arguments: src - The AsciiSrc Widget.
@@ -1176,6 +1538,7 @@ FreeAllPieces(
 	next = first->next;
 	RemovePiece(src, first);
     }
+    FreeTextBuffers(src);
 }
 
 /*	Function Name: RemovePiece
@@ -1190,6 +1553,25 @@ RemovePiece(
 	       AsciiSrcObject src,
 	       Piece * piece)
 {
+    Piece *child;
+
+    while (piece->left != NULL && piece->right != NULL) {
+	if (piece->left->weight > piece->right->weight)
+	    RotatePiece(src, piece->left);
+	else
+	    RotatePiece(src, piece->right);
+    }
+    child = (piece->left != NULL) ? piece->left : piece->right;
+    if (child != NULL)
+	child->parent = piece->parent;
+    if (piece->parent == NULL)
+	src->ascii_src.root_piece = child;
+    else if (piece->parent->left == piece)
+	piece->parent->left = child;
+    else
+	piece->parent->right = child;
+    UpdateTotals(piece->parent);
+
     if (piece->prev == NULL)
 	src->ascii_src.first_piece = piece->next;
     else
@@ -1198,7 +1580,7 @@ RemovePiece(
     if (piece->next != NULL)
 	(piece->next)->prev = piece->prev;
 
-    if (!src->ascii_src.use_string_in_place)
+    if (PiecesOwnText(src))
 	XtFree(piece->text);
 
     XtFree((char *) piece);
@@ -1210,6 +1592,10 @@ RemovePiece(
  *                 position - the position that we are searching for.
  * RETURNED        first - the position of the first character in this piece.
  *	Returns: piece - the piece that contains this position.
+ *
+ * The pieces are kept in a treap ordered like the linked list, where each
+ * node knows the number of characters in its subtree, so that the lookup
+ * costs O(log pieces) rather than a walk from the first piece.
  */
 
 static Piece *
@@ -1217,19 +1603,709 @@ FindPiece(
 	     AsciiSrcObject src,
 	     XawTextPosition position, XawTextPosition * first)
 {
-    Piece *old_piece = NULL;
-    Piece *piece = src->ascii_src.first_piece;
-    XawTextPosition temp;
+    Piece *piece = src->ascii_src.root_piece;
+    XawTextPosition base = 0;
+
+    if (position < 0)
+	position = 0;
+
+    while (piece != NULL) {
+	if (position < base + PieceTotal(piece->left)) {
+	    piece = piece->left;
+	} else {
+	    base += PieceTotal(piece->left);
+	    if (position < base + piece->used) {
+		*first = base;
+		return (piece);
+	    }
+	    base += piece->used;
+	    piece = piece->right;
+	}
+    }
+
+/*
+ * If we run off the end then return the last piece.
+ */
+
+    for (piece = src->ascii_src.root_piece;
+	 piece->right != NULL;
+	 piece = piece->right) ;
+    *first = src->ascii_src.root_piece->total - piece->used;
+    return (piece);
+}
+
+/*	Function Name: UpdatePiece
+ *	Description: Updates the position index after the text or the used
+ *                   count of a piece has changed.
+ *	Arguments: src - The AsciiSrc Widget.
+ *                 piece - the piece that was changed.
+ *	Returns: none.
+ */
+
+static void
+UpdatePiece(
+	       AsciiSrcObject src,
+	       Piece * piece)
+{
+    if (src->ascii_src.lines_indexed)
+	piece->lines = CountLines(piece->text, piece->used);
+    UpdateTotals(piece);
+}
+
+/*	Function Name: UpdateTotals
+ *	Description: Recomputes the subtree totals from a piece up to the
+ *                   root of the position index.
+ *	Arguments: piece - the lowest piece whose subtree has changed.
+ *	Returns: none.
+ */
+
+static void
+UpdateTotals(
+		Piece * piece)
+{
+    for (; piece != NULL; piece = piece->parent)
+	SumPiece(piece);
+}
+
+/*	Function Name: SumPiece
+ *	Description: Recomputes the totals of one piece from its children.
+ *	Arguments: piece - the piece.
+ *	Returns: none.
+ */
+
+static void
+SumPiece(
+	    Piece * piece)
+{
+    piece->total = (PieceTotal(piece->left) + piece->used +
+		    PieceTotal(piece->right));
+    piece->line_total = (PieceLines(piece->left) + piece->lines +
+			 PieceLines(piece->right));
+}
+
+/*	Function Name: RotatePiece
+ *	Description: Rotates a piece of the position index above its parent.
+ *	Arguments: src - The AsciiSrc Widget.
+ *                 piece - the piece to move up.
+ *	Returns: none.
+ */
+
+static void
+RotatePiece(
+	       AsciiSrcObject src,
+	       Piece * piece)
+{
+    Piece *parent = piece->parent;
+    Piece *grand = parent->parent;
+
+    if (parent->left == piece) {
+	parent->left = piece->right;
+	if (piece->right != NULL)
+	    piece->right->parent = parent;
+	piece->right = parent;
+    } else {
+	parent->right = piece->left;
+	if (piece->left != NULL)
+	    piece->left->parent = parent;
+	piece->left = parent;
+    }
+    parent->parent = piece;
+    piece->parent = grand;
+
+    if (grand == NULL)
+	src->ascii_src.root_piece = piece;
+    else if (grand->left == parent)
+	grand->left = piece;
+    else
+	grand->right = piece;
+
+    SumPiece(parent);
+    SumPiece(piece);
+}
+
+/*	Function Name: CountLines
+ *	Description: Counts the newlines in a buffer.
+ *	Arguments: text - the buffer.
+ *                 length - the number of characters.
+ *	Returns: the number of newlines.
+ */
+
+static XawTextPosition
+CountLines(
+	      char *text,
+	      XawTextPosition length)
+{
+    XawTextPosition lines = 0;
+    char *end = text + length;
+
+    while ((text < end) &&
+	   (text = memchr(text, '\n', (size_t) (end - text))) != NULL) {
+	lines++;
+	text++;
+    }
+    return (lines);
+}
+
+/*	Function Name: IndexLines
+ *	Description: Counts the newlines of every piece, the first time
+ *                   that the line index is needed.  After that the
+ *                   counts are kept up to date by UpdatePiece.
+ *	Arguments: src - The AsciiSrc Widget.
+ *	Returns: none.
+ */
+
+static void
+IndexLines(
+	      AsciiSrcObject src)
+{
+    Piece *piece;
+
+    if (src->ascii_src.lines_indexed)
+	return;
+
+    for (piece = src->ascii_src.first_piece; piece != NULL; piece = piece->next)
+	piece->lines = CountLines(piece->text, piece->used);
+    SumSubtree(src->ascii_src.root_piece);
+
+    src->ascii_src.lines_indexed = TRUE;
+}
+
+static void
+SumSubtree(
+	      Piece * piece)
+{
+    if (piece != NULL) {
+	SumSubtree(piece->left);
+	SumSubtree(piece->right);
+	SumPiece(piece);
+    }
+}
+
+/*	Function Name: FindNewline
+ *	Description: Finds a newline by its number.
+ *	Arguments: src - The AsciiSrc Widget.
+ *                 number - the number of the newline, counting from 1.
+ *	Returns: the position of the newline, or -1 if there is none.
+ */
+
+static XawTextPosition
+FindNewline(
+	       AsciiSrcObject src,
+	       XawTextPosition number)
+{
+    Piece *piece;
+    XawTextPosition base = 0;
+
+    IndexLines(src);
+
+    piece = src->ascii_src.root_piece;
+    if ((number < 1) || (number > piece->line_total))
+	return (-1);
+
+    while (piece != NULL) {
+	if (number <= PieceLines(piece->left)) {
+	    piece = piece->left;
+	} else {
+	    number -= PieceLines(piece->left);
+	    base += PieceTotal(piece->left);
+	    if (number <= piece->lines) {
+		char *ptr = piece->text;
+
+		for (;;) {
+		    ptr = memchr(ptr, '\n',
+				 (size_t) (piece->text + piece->used - ptr));
+		    if (--number == 0)
+			return (base + (ptr - piece->text));
+		    ptr++;
+		}
+	    }
+	    number -= piece->lines;
+	    base += piece->used;
+	    piece = piece->right;
+	}
+    }
+    return (-1);
+}
+
+/*	Function Name: LinesBefore
+ *	Description: Counts the newlines in front of a position.
+ *	Arguments: src - The AsciiSrc Widget.
+ *                 position - the position.
+ *	Returns: the number of newlines.
+ */
+
+static XawTextPosition
+LinesBefore(
+	       AsciiSrcObject src,
+	       XawTextPosition position)
+{
+    Piece *piece;
+    XawTextPosition base = 0, lines = 0;
+
+    IndexLines(src);
+
+    piece = src->ascii_src.root_piece;
+    while (piece != NULL) {
+	if (position < base + PieceTotal(piece->left)) {
+	    piece = piece->left;
+	} else {
+	    base += PieceTotal(piece->left);
+	    lines += PieceLines(piece->left);
+	    if (position < base + piece->used)
+		return (lines + CountLines(piece->text, position - base));
+	    base += piece->used;
+	    lines += piece->lines;
+	    piece = piece->right;
+	}
+    }
+    return (lines);
+}
+
+/*	Function Name: ScanLines
+ *	Description: Scans for several ends of line using the line index,
+ *                   giving the same result as Scan.
+ *	Arguments: src - The AsciiSrc Widget.
+ *                 position - the position to start scanning.
+ *                 dir - direction to scan.
+ *                 count - the number of lines.
+ *                 include - whether to include the newline found.
+ *	Returns: the position of the item found.
+ */
 
-    for (temp = 0; piece != NULL; temp += piece->used, piece = piece->next) {
-	*first = temp;
-	old_piece = piece;
+static XawTextPosition
+ScanLines(
+	     AsciiSrcObject src,
+	     XawTextPosition position,
+	     XawTextScanDirection dir,
+	     int count,
+	     Bool include)
+{
+    XawTextPosition newline;
 
-	if ((temp + piece->used) > position)
-	    return (piece);
+    if (dir == XawsdRight) {
+	if (position >= src->ascii_src.length)
+	    return (src->ascii_src.length);
+	newline = FindNewline(src, LinesBefore(src, position) + count);
+	if (newline < 0)
+	    return (src->ascii_src.length);
+	position = include ? newline + 1 : newline;
+    } else {
+	if (position <= 0)
+	    return (0);
+	newline = FindNewline(src, LinesBefore(src, position) - count + 1);
+	if (newline < 0)
+	    return (0);
+	position = include ? newline : newline + 1;
     }
-    *first = position;
-    return (old_piece);		/* if we run off the end the return the last piece */
+
+    if (position >= src->ascii_src.length)
+	return (src->ascii_src.length);
+    return (position);
+}
+
+/*	Function Name: ScanChars
+ *	Description: Finds the next character of a kind, working through
+ *                   whole pieces instead of checking the piece bounds
+ *                   for every character.
+ *	Arguments: src - The AsciiSrc Widget.
+ *                 position - the position to start at, it is included.
+ *                 dir - direction to scan.
+ *                 what - the kind of character, one of SCAN_NEWLINE,
+ *                        SCAN_SPACE, SCAN_NONSPACE or SCAN_BREAK.
+ * RETURNED        found - the character that was found.
+ *	Returns: the position of the character, or -1 if the scan ran off
+ *               the text.
+ */
+
+static XawTextPosition
+ScanChars(
+	     AsciiSrcObject src,
+	     XawTextPosition position,
+	     XawTextScanDirection dir,
+	     int what,
+	     int *found)
+{
+    Piece *piece;
+    XawTextPosition first, i;
+    unsigned char *text;
+    char *ptr;
+
+    if ((position < 0) || (position >= src->ascii_src.length))
+	return (-1);
+
+    piece = FindPiece(src, position, &first);
+    i = position - first;
+
+    for (;;) {
+	text = (unsigned char *) piece->text;
+	if (dir == XawsdRight) {
+	    if (what == SCAN_NEWLINE) {
+		ptr = memchr(piece->text + i, '\n', (size_t) (piece->used - i));
+		i = (ptr != NULL) ? ptr - piece->text : piece->used;
+	    } else {
+		while (i < piece->used && !ScanMatch(text[i], what))
+		    i++;
+	    }
+	    if (i < piece->used)
+		break;
+	    first += piece->used;
+	    if ((piece = piece->next) == NULL)
+		return (-1);
+	    i = 0;
+	} else {
+	    while (i >= 0 && !ScanMatch(text[i], what))
+		i--;
+	    if (i >= 0)
+		break;
+	    if ((piece = piece->prev) == NULL)
+		return (-1);
+	    first -= piece->used;
+	    i = piece->used - 1;
+	}
+    }
+
+    *found = text[i];
+    return (first + i);
+}
+
+/*	Function Name: MatchText
+ *	Description: Compares the text at an offset with a string, following
+ *                   the pieces as needed.
+ *	Arguments: piece - the piece to start in.
+ *                 offset - the offset of the first character to compare.
+ *                 buf - the string.
+ *                 length - the length of the string.
+ *                 dir - XawsdRight to compare forward from the start of
+ *                       the string, XawsdLeft to compare backward from
+ *                       its end.
+ *                 fold - True to ignore the case of letters.
+ *	Returns: True if the text matches the string.
+ */
+
+static Boolean
+MatchText(
+	     Piece * piece,
+	     XawTextPosition offset,
+	     char *buf,
+	     int length,
+	     XawTextScanDirection dir,
+	     Boolean fold)
+{
+    int n;
+
+    while (length > 0) {
+	if (dir == XawsdRight) {
+	    n = (int) Min(length, piece->used - offset);
+	    if (CompareText(piece->text + offset, buf, n, fold) != 0)
+		return (False);
+	    buf += n;
+	    length -= n;
+	    if (length > 0) {
+		if ((piece = piece->next) == NULL)
+		    return (False);
+		offset = 0;
+	    }
+	} else {
+	    n = (int) Min(length, offset + 1);
+	    if (CompareText(piece->text + offset - n + 1, buf + length - n,
+			    n, fold) != 0)
+		return (False);
+	    length -= n;
+	    if (length > 0) {
+		if ((piece = piece->prev) == NULL)
+		    return (False);
+		offset = piece->used - 1;
+	    }
+	}
+    }
+    return (True);
+}
+
+/*	Function Name: CompareText
+ *	Description: Compares two strings like memcmp().
+ *	Arguments: a, b - the strings.
+ *                 n - the number of characters.
+ *                 fold - True to ignore the case of letters.
+ *	Returns: zero if the strings are equal.
+ */
+
+static int
+CompareText(
+	       char *a,
+	       char *b,
+	       int n,
+	       Boolean fold)
+{
+    if (!fold)
+	return (memcmp(a, b, (size_t) n));
+
+    for (; n > 0; n--, a++, b++)
+	if (tolower((unsigned char) *a) != tolower((unsigned char) *b))
+	    return (1);
+    return (0);
+}
+
+/*	Function Name: SearchHorspool
+ *	Description: Searches for a string with the Boyer-Moore-Horspool
+ *                   algorithm, which skips ahead by up to the length of
+ *                   the string after each mismatch.
+ *	Arguments: src - The AsciiSrc Widget.
+ *                 position - the first position where the string may
+ *                            start, or to the left the last position
+ *                            where it may end.
+ *                 dir - direction to search.
+ *                 buf - the string.
+ *                 length - the length of the string.
+ *                 fold - True to ignore the case of letters.
+ *	Returns: the position of the string or XawTextSearchError.
+ */
+
+static XawTextPosition
+SearchHorspool(
+		  AsciiSrcObject src,
+		  XawTextPosition position,
+		  XawTextScanDirection dir,
+		  char *buf,
+		  int length,
+		  Boolean fold)
+{
+    int shift[256];
+    Piece *piece;
+    XawTextPosition first, pos;
+    int c, i;
+
+/*
+ * To the right the window is moved by the distance of its last character
+ * from the end of the string, to the left by the distance of its first
+ * character from the start of the string.
+ */
+
+    for (i = 0; i < 256; i++)
+	shift[i] = length;
+    if (dir == XawsdRight) {
+	for (i = 0; i < length - 1; i++)
+	    shift[FoldChar((unsigned char) buf[i], fold)] = length - 1 - i;
+	pos = position + length - 1;
+    } else {
+	for (i = length - 1; i > 0; i--)
+	    shift[FoldChar((unsigned char) buf[i], fold)] = i;
+	pos = position - (length - 1);
+    }
+    if ((pos < 0) || (pos >= src->ascii_src.length))
+	return (XawTextSearchError);
+
+    piece = FindPiece(src, pos, &first);
+
+    /* CONSTCOND */
+    while (TRUE) {
+	c = FoldChar((unsigned char) piece->text[pos - first], fold);
+	if (dir == XawsdRight) {
+	    if ((c == FoldChar((unsigned char) buf[length - 1], fold)) &&
+		MatchText(piece, pos - first, buf, length, XawsdLeft, fold))
+		return (pos - (length - 1));
+	    pos += shift[c];
+	    while (pos >= first + piece->used) {
+		first += piece->used;
+		if ((piece = piece->next) == NULL)	/* End of text. */
+		    return (XawTextSearchError);
+	    }
+	} else {
+	    if ((c == FoldChar((unsigned char) buf[0], fold)) &&
+		MatchText(piece, pos - first, buf, length, XawsdRight, fold))
+		return (pos);
+	    pos -= shift[c];
+	    while (pos < first) {
+		if ((piece = piece->prev) == NULL)	/* Begining of text. */
+		    return (XawTextSearchError);
+		first -= piece->used;
+	    }
+	}
+    }
+}
+
+/*	Function Name: SplitPiece
+ *	Description: Splits the piece of a piece table which contains the
+ *                   position, so that a piece starts there.
+ *	Arguments: src - The AsciiSrc Widget.
+ *                 position - the position to split at.
+ *	Returns: the piece starting at position, or NULL at the end.
+ */
+
+static Piece *
+SplitPiece(
+	      AsciiSrcObject src,
+	      XawTextPosition position)
+{
+    XawTextPosition first;
+    Piece *piece, *new;
+
+    if (position >= src->ascii_src.length)
+	return (NULL);
+
+    piece = FindPiece(src, position, &first);
+    if (position == first)
+	return (piece);
+
+    new = AllocNewPiece(src, piece);
+    new->text = piece->text + (position - first);
+    new->used = piece->used - (position - first);
+    piece->used = position - first;
+    UpdatePiece(src, piece);
+    UpdatePiece(src, new);
+
+    return (new);
+}
+
+/*	Function Name: AppendText
+ *	Description: Appends text to the add buffer of a piece table.
+ *	Arguments: src - The AsciiSrc Widget.
+ *                 text - the text to append.
+ *                 length - the number of characters.
+ *	Returns: the location of the copy, which is never moved.
+ */
+
+static char *
+AppendText(
+	      AsciiSrcObject src,
+	      char *text,
+	      int length)
+{
+    AddBuffer *buffer = src->ascii_src.add_buffer;
+    char *result;
+
+    if ((buffer == NULL) || (buffer->size - buffer->used < length)) {
+	buffer = XtNew(AddBuffer);
+	buffer->size = Max(src->ascii_src.piece_size * 8, length);
+	buffer->text = XtMalloc((unsigned) buffer->size);
+	buffer->used = 0;
+	buffer->next = src->ascii_src.add_buffer;
+	src->ascii_src.add_buffer = buffer;
+    }
+
+    result = buffer->text + buffer->used;
+    memcpy(result, text, (size_t) length);
+    buffer->used += length;
+
+    return (result);
+}
+
+/*	Function Name: ReplacePieces
+ *	Description: Replaces a block of text in a piece table.  Only the
+ *                   piece descriptors change; the original text and the
+ *                   add buffer are never moved.
+ *	Arguments: src - The AsciiSrc Widget.
+ *                 startPos, endPos - ends of text that will be removed.
+ *                 text - new text to be inserted into buffer at startPos.
+ *	Returns: none.
+ */
+
+static void
+ReplacePieces(
+		 AsciiSrcObject src,
+		 XawTextPosition startPos, XawTextPosition endPos,
+		 XawTextBlock * text)
+{
+    Piece *piece, *end_piece, *prev;
+    XawTextPosition first;
+    char *ptr;
+    int length;
+
+    src->ascii_src.changes = TRUE;
+
+/*
+ * Remove Old Stuff.
+ */
+
+    if (endPos > startPos) {
+	end_piece = SplitPiece(src, endPos);
+	piece = SplitPiece(src, startPos);
+	while (piece != end_piece) {
+	    Piece *next = piece->next;
+
+	    if (src->ascii_src.first_piece == piece && next == NULL) {
+		piece->used = 0;	/* keep the only piece */
+		UpdatePiece(src, piece);
+		break;
+	    }
+	    RemovePiece(src, piece);
+	    piece = next;
+	}
+	src->ascii_src.length -= endPos - startPos;
+    }
+
+    if ((length = text->length) <= 0)
+	return;
+
+/*
+ * Put in the New Stuff.  Typing at the end of the text which was the last
+ * one inserted simply extends the piece describing it.
+ */
+
+    ptr = AppendText(src, text->ptr + text->firstPos, length);
+
+    prev = NULL;
+    if (startPos > 0) {
+	prev = FindPiece(src, startPos - 1, &first);
+	if ((first + prev->used == startPos) &&
+	    (ptr != src->ascii_src.add_buffer->text) &&
+	    (prev->text + prev->used == ptr) &&
+	    (prev->used + length <= src->ascii_src.piece_size)) {
+	    prev->used += length;
+	    UpdatePiece(src, prev);
+	    src->ascii_src.length += length;
+	    return;
+	}
+	if (first + prev->used != startPos) {
+	    SplitPiece(src, startPos);
+	    prev = FindPiece(src, startPos - 1, &first);
+	}
+    }
+
+    if (src->ascii_src.first_piece->used == 0) {
+	piece = src->ascii_src.first_piece;	/* the text is empty */
+    } else if (prev == NULL) {
+	piece = PrependPiece(src);
+    } else {
+	piece = AllocNewPiece(src, prev);
+    }
+
+    /* CONSTCOND */
+    while (TRUE) {
+	piece->text = ptr;
+	piece->used = Min(length, src->ascii_src.piece_size);
+	UpdatePiece(src, piece);
+
+	ptr += piece->used;
+	length -= (int) piece->used;
+	src->ascii_src.length += piece->used;
+	if (length <= 0)
+	    break;
+	piece = AllocNewPiece(src, piece);
+    }
+}
+
+/*	Function Name: FreeTextBuffers
+ *	Description: Frees the original text and the add buffers of a
+ *                   piece table.
+ *	Arguments: src - The AsciiSrc Widget.
+ *	Returns: none.
+ */
+
+static void
+FreeTextBuffers(
+		   AsciiSrcObject src)
+{
+    AddBuffer *buffer, *next;
+
+    for (buffer = src->ascii_src.add_buffer; buffer != NULL; buffer = next) {
+	next = buffer->next;
+	XtFree(buffer->text);
+	XtFree((char *) buffer);
+    }
+    src->ascii_src.add_buffer = NULL;
+
+    XtFree(src->ascii_src.original_text);
+    src->ascii_src.original_text = NULL;
 }
 
 /*	Function Name: MyStrncpy
@@ -1286,6 +2362,8 @@ BreakPiece(
 	    (size_t) (src->ascii_src.piece_size - HALF_PIECE));
     piece->used = HALF_PIECE;
     new->used = src->ascii_src.piece_size - HALF_PIECE;
+    UpdatePiece(src, piece);
+    UpdatePiece(src, new);
 }
 
 /* ARGSUSED */
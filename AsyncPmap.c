@@ -0,0 +1,511 @@
+/******************************************************************************************
+ *
+ * AsyncPmap.c: Loading pixmaps without blocking the main loop.
+ *
+ * Widgets start a load with _XawLoadPixmap(), see AsyncPmap.h. The files of a pixmap
+ * are searched for and decoded into an XpmImage by a worker thread, which touches
+ * no Xlib data. It hands finished loads back through a pipe, which the main loop
+ * watches with XtAppAddInput(). There the pixmap is created with the colors of the
+ * color cache and set on the widget with XtSetValues().
+ *
+ * If configure finds no POSIX threads, or is run --without-pthread, a work procedure
+ * loads one pixmap each time it is called, so the main loop is blocked for one file
+ * at a time only.
+ *
+ * Copyright (c) Roland Krause 2002, roland_krause@freenet.de
+ *
+ * This module is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ ******************************************************************************************/
+
+#include "private.h"
+
+#include <X11/IntrinsicP.h>
+#include <X11/StringDefs.h>
+#include <X11/Xos.h>		/* for access(), read() and write() */
+#include <X11/Xmu/Drawing.h>
+#include <X11/xpm.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+
+#ifdef HAVE_LIBPTHREADS
+#include <pthread.h>
+#define USE_THREADS 1
+#endif
+
+#include <X11/XawPlus/StrToPmap.h>
+#include "AsyncPmap.h"
+
+/******************************************************************************************
+ *
+ * A load: One for each pixmap resource of a widget with a pixmap name. It owns the
+ * pixmaps shown by the widget for this resource. The worker only uses the fields
+ * behind `state', and only while the state is LOAD_RUNNING.
+ *
+ ******************************************************************************************/
+
+#define LOAD_QUEUED	0		/* Waiting for the worker		*/
+#define LOAD_RUNNING	1		/* Being decoded by the worker		*/
+#define LOAD_DONE	2		/* Decoded, waiting for the main loop	*/
+#define LOAD_APPLIED	3		/* Set on the widget			*/
+
+typedef struct _Context Context;
+
+typedef struct _Load {
+    struct _Load	*next;		/* All loads				*/
+    struct _Load	*queue;		/* The queue or the list of done loads	*/
+    Context		*context;
+    Widget		w;
+    Display		*dpy;
+    String		pixmap_resource;
+    String		mask_resource;
+    char		*name;		/* The name with its color overrides	*/
+    Pixmap		placeholder;
+    Pixmap		pixmap, mask;
+    Boolean		cancelled;	/* The widget does not want it anymore	*/
+    int			state;
+    char		**candidates;	/* The files to try			*/
+    char		*found;		/* The file decoded, NULL if none	*/
+    Boolean		readable;	/* A file could be read, if not found	*/
+    XpmImage		image;
+} Load;
+
+/* Each application context has its own queue, and its own pipe */
+
+struct _Context {
+    Context		*next;
+    XtAppContext	app;
+    Load		*queue;		/* Loads waiting for the worker		*/
+    Load		*done;		/* Loads waiting for the main loop	*/
+    int			fds[2];
+    Boolean		threaded;	/* False: loaded by a work procedure	*/
+};
+
+static Load    *loads = NULL;
+static Context *contexts = NULL;
+
+#ifdef USE_THREADS
+static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  wakeup = PTHREAD_COND_INITIALIZER;
+static Boolean         workerRunning = False;
+#define LOCK()		pthread_mutex_lock(&mutex)
+#define UNLOCK()	pthread_mutex_unlock(&mutex)
+#else
+#define LOCK()		/* nothing */
+#define UNLOCK()	/* nothing */
+#endif
+
+static Boolean LoadStep(XtPointer closure);
+
+/******************************************************************************************
+ *
+ * Decode(): Search the files of a load and decode the first one that can be read.
+ *	     This runs on the worker thread, and must not use Xlib.
+ *
+ ******************************************************************************************/
+
+static void Decode(Load *load)
+{
+    int i;
+
+    load->found = NULL;
+    load->readable = False;
+    for (i = 0; load->candidates && load->candidates[i]; i++)
+    {
+       if (access(load->candidates[i], R_OK) != 0) continue;
+       load->readable = True;
+       if (XpmReadFileToXpmImage(load->candidates[i], &load->image, NULL) == XpmSuccess)
+       {
+	  load->found = load->candidates[i];
+	  break;
+       }
+    }
+}
+
+#ifdef USE_THREADS
+/******************************************************************************************
+ *
+ * Worker(): The worker thread. Decodes the queued loads of all contexts.
+ *
+ ******************************************************************************************/
+
+static void *Worker(void *arg GCC_UNUSED)
+{
+    Context *context;
+    Load    *load, **tail;
+
+    LOCK();
+    for (;;)
+    {
+       for (context = contexts; context != NULL; context = context->next)
+	  if (context->threaded && context->queue != NULL) break;
+       if (context == NULL)
+       {
+	  pthread_cond_wait(&wakeup, &mutex);
+	  continue;
+       }
+       load = context->queue;
+       context->queue = load->queue;
+       load->state = LOAD_RUNNING;
+       UNLOCK();
+
+       Decode(load);
+
+       LOCK();
+       load->state = LOAD_DONE;
+       load->queue = NULL;
+       for (tail = &context->done; *tail != NULL; tail = &(*tail)->queue) ;
+       *tail = load;
+       /* The pipe does not block: if it is full, the main loop wakes up anyway */
+
+       while (write(context->fds[1], "", 1) < 0 && errno == EINTR) ;
+    }
+    /* NOTREACHED */
+    return NULL;
+}
+#endif
+
+/******************************************************************************************
+ *
+ * Release(): Remove a load and free its pixmaps.
+ *
+ ******************************************************************************************/
+
+static void Release(Load *load)
+{
+    Load **prev;
+
+    for (prev = &loads; *prev != NULL; prev = &(*prev)->next)
+       if (*prev == load)
+       {
+	  *prev = load->next;
+	  break;
+       }
+    if (load->placeholder != None) XFreePixmap(load->dpy, load->placeholder);
+    if (load->pixmap != None) XFreePixmap(load->dpy, load->pixmap);
+    if (load->mask != None) XFreePixmap(load->dpy, load->mask);
+    free(load->candidates);
+    XtFree(load->name);
+    XtFree((char *)load);
+}
+
+/******************************************************************************************
+ *
+ * FreeLoad(): Release a load the widget does not show anymore. Loads the worker
+ *	       has taken are only marked, and released by the main loop when they
+ *	       come back.
+ *
+ ******************************************************************************************/
+
+static void FreeLoad(Load *load)
+{
+    Load **prev;
+
+    LOCK();
+    if (load->state == LOAD_RUNNING || load->state == LOAD_DONE)
+    {
+       load->cancelled = True;
+       UNLOCK();
+       for (prev = &loads; *prev != NULL; prev = &(*prev)->next)
+	  if (*prev == load)
+	  {
+	     *prev = load->next;
+	     break;
+	  }
+       return;
+    }
+    if (load->state == LOAD_QUEUED)
+    {
+       for (prev = &load->context->queue; *prev != NULL; prev = &(*prev)->queue)
+	  if (*prev == load)
+	  {
+	     *prev = load->queue;
+	     break;
+	  }
+    }
+    UNLOCK();
+    Release(load);
+}
+
+/******************************************************************************************
+ *
+ * Apply(): Create the pixmap of a decoded load and set it on the widget.
+ *
+ ******************************************************************************************/
+
+static void Apply(Load *load)
+{
+    Widget   w = load->w, win = w;
+    Display  *dpy = load->dpy;
+    Pixmap   placeholder = load->placeholder;
+    char     *file;
+    size_t   len = strcspn(load->name, " \t\n");
+
+    if (load->cancelled)
+    {
+       if (load->found != NULL) XpmFreeXpmImage(&load->image);
+       Release(load);
+       return;
+    }
+    while (!XtIsWidget(win)) win = XtParent(win);	/* objects have no colormap */
+
+    if (load->found != NULL)
+    {
+       load->pixmap = _XawCreateXpmPixmap(XtScreenOfObject(w), win->core.colormap,
+					  load->name, &load->image,
+					  load->mask_resource ? &load->mask : NULL);
+       XpmFreeXpmImage(&load->image);
+    }
+    /* Files that could not be decoded are tried again next time */
+
+    if (load->found != NULL || !load->readable)
+    {
+       file = XtMalloc((Cardinal)(len + 1));
+       strncpy(file, load->name, len);
+       file[len] = '\0';
+       _XawRememberPixmapFile(dpy, file, load->found);
+       XtFree(file);
+    }
+    if (load->pixmap == None) XtStringConversionWarning(load->name, "Pixmap");
+
+    load->state = LOAD_APPLIED;
+    load->placeholder = None;
+    if (load->mask_resource)
+       XtVaSetValues(w, load->pixmap_resource, load->pixmap,
+			load->mask_resource, load->mask, NULL);
+    else
+       XtVaSetValues(w, load->pixmap_resource, load->pixmap, NULL);
+    if (placeholder != None) XFreePixmap(dpy, placeholder);
+}
+
+#ifdef USE_THREADS
+/******************************************************************************************
+ *
+ * ReadDone(): The input callback of the pipe. Applies the loads done by the worker.
+ *
+ ******************************************************************************************/
+
+static void ReadDone(XtPointer closure, int *fd, XtInputId *id GCC_UNUSED)
+{
+    Context *context = (Context *)closure;
+    Load    *load;
+    char    buffer[64];
+
+    while (read(*fd, buffer, sizeof(buffer)) < 0 && errno == EINTR) ;
+    LOCK();
+    load = context->done;
+    context->done = NULL;
+    UNLOCK();
+
+    while (load != NULL)
+    {
+       Load *next = load->queue;
+
+       Apply(load);
+       load = next;
+    }
+}
+#endif
+
+/******************************************************************************************
+ *
+ * LoadStep(): The work procedure used without threads. Loads one pixmap.
+ *
+ ******************************************************************************************/
+
+static Boolean LoadStep(XtPointer closure)
+{
+    Context *context = (Context *)closure;
+    Load    *load = context->queue;
+
+    if (load == NULL) return True;
+    context->queue = load->queue;
+    load->state = LOAD_RUNNING;
+    Decode(load);
+    load->state = LOAD_DONE;
+    Apply(load);
+    return (context->queue == NULL);
+}
+
+/******************************************************************************************
+ *
+ * GetContext(): Find or create the context of an application, starting the worker
+ *		 thread the first time.
+ *
+ ******************************************************************************************/
+
+static Context *GetContext(XtAppContext app)
+{
+    Context *context;
+
+    for (context = contexts; context != NULL; context = context->next)
+       if (context->app == app) return context;
+
+    context = XtNew(Context);
+    context->app = app;
+    context->queue = context->done = NULL;
+    context->threaded = False;
+#ifdef USE_THREADS
+    if (pipe(context->fds) == 0)
+    {
+       pthread_t thread;
+
+       context->threaded = True;
+       (void)fcntl(context->fds[0], F_SETFL, O_NONBLOCK);
+       (void)fcntl(context->fds[1], F_SETFL, O_NONBLOCK);
+       if (!workerRunning)
+       {
+	  if (pthread_create(&thread, NULL, Worker, NULL) == 0)
+	  {
+	     (void)pthread_detach(thread);
+	     workerRunning = True;
+	  }
+	  else context->threaded = False;
+       }
+       if (context->threaded)
+	  (void)XtAppAddInput(app, context->fds[0], (XtPointer)XtInputReadMask,
+			      ReadDone, (XtPointer)context);
+       else
+       {
+	  (void)close(context->fds[0]);
+	  (void)close(context->fds[1]);
+       }
+    }
+#endif
+    LOCK();
+    context->next = contexts;
+    contexts = context;
+    UNLOCK();
+    return context;
+}
+
+/******************************************************************************************
+ *
+ * DestroyLoads(): Destroy callback, frees the loads of a widget.
+ *
+ ******************************************************************************************/
+
+static void DestroyLoads(Widget w, XtPointer closure GCC_UNUSED, XtPointer data GCC_UNUSED)
+{
+    Load *load, *next;
+
+    for (load = loads; load != NULL; load = next)
+    {
+       next = load->next;
+       if (load->w == w) FreeLoad(load);
+    }
+}
+
+/******************************************************************************************
+ *
+ * _XawLoadPixmap(): Start to load a pixmap for a widget, see AsyncPmap.h.
+ *
+ ******************************************************************************************/
+
+void _XawLoadPixmap(Widget w, char *name, String pixmap_resource, String mask_resource,
+		    Dimension width, Dimension height,
+		    Pixmap *pixmap_return, Pixmap *mask_return)
+{
+    Screen   *screen = XtScreenOfObject(w);
+    Display  *dpy = XtDisplayOfObject(w);
+    Widget   win = w;
+    Boolean  known = False;
+    Context  *context;
+    Load     *load, *next;
+    char     *file;
+    size_t   len;
+    int      bw, bh;
+
+    /* Release the previous pixmap of this resource */
+
+    for (load = loads; load != NULL; load = next)
+    {
+       next = load->next;
+       if (load->w == w)
+       {
+	  known = True;
+	  if (load->pixmap_resource == pixmap_resource) FreeLoad(load);
+       }
+    }
+    *pixmap_return = None;
+    if (mask_return) *mask_return = None;
+    if (name == NULL || *name == '\0') return;
+
+    if (!known) XtAddCallback(w, XtNdestroyCallback, DestroyLoads, NULL);
+
+    load = XtNew(Load);
+    memset(load, 0, sizeof(Load));
+    load->w = w;
+    load->dpy = dpy;
+    load->pixmap_resource = pixmap_resource;
+    load->mask_resource = mask_resource;
+    load->name = XtNewString(name);
+    load->next = loads;
+    loads = load;
+
+    /* Pixmaps of the bundle and bitmap files are loaded at once */
+
+    while (!XtIsWidget(win)) win = XtParent(win);
+    load->pixmap = _XawBundledPixmap(screen, win->core.colormap, name, &bw, &bh,
+				     mask_resource ? &load->mask : NULL);
+    if (load->pixmap == None && strstr(name, ".xpm") == NULL)
+    {
+       load->pixmap = XmuLocateBitmapFile(screen, name, NULL, 0, NULL, NULL, NULL, NULL);
+       if (load->pixmap == None) XtStringConversionWarning(name, "Pixmap");
+    }
+    if (load->pixmap != None || strstr(name, ".xpm") == NULL)
+    {
+       load->state = LOAD_APPLIED;
+       *pixmap_return = load->pixmap;
+       if (mask_return) *mask_return = load->mask;
+       return;
+    }
+
+    /* Show a blank bitmap of the declared size meanwhile */
+
+    if (width > 0 && height > 0)
+    {
+       GC gc;
+
+       load->placeholder = XCreatePixmap(dpy, RootWindowOfScreen(screen), width, height, 1);
+       gc = XCreateGC(dpy, load->placeholder, 0, NULL);
+       XFillRectangle(dpy, load->placeholder, gc, 0, 0, width, height);
+       XFreeGC(dpy, gc);
+       *pixmap_return = load->placeholder;
+    }
+
+    len = strcspn(name, " \t\n");
+    file = XtMalloc((Cardinal)(len + 1));
+    strncpy(file, name, len);
+    file[len] = '\0';
+    load->candidates = _XawPixmapCandidates(dpy, file);
+    XtFree(file);
+
+    context = GetContext(XtWidgetToApplicationContext(w));
+    load->context = context;
+    load->state = LOAD_QUEUED;
+    LOCK();
+    if (context->queue == NULL && !context->threaded)
+       (void)XtAppAddWorkProc(context->app, LoadStep, (XtPointer)context);
+    for (next = context->queue; next != NULL && next->queue != NULL; next = next->queue) ;
+    if (next != NULL) next->queue = load;
+    else context->queue = load;
+#ifdef USE_THREADS
+    pthread_cond_signal(&wakeup);
+#endif
+    UNLOCK();
+}
@@ -0,0 +1,97 @@
+/**********************************************************************
+ *
+ * AsyncPmap.h: Loading pixmaps without blocking the main loop.
+ *
+ * Label, Command and SmeBSB load the pixmaps named by their
+ * bitmapName resources with these functions. The XPM files are
+ * searched for and decoded by a worker thread, or by a work
+ * procedure where POSIX threads are not available. The pixmap is
+ * created on the main thread and given to the widget with
+ * XtSetValues(), so that the widget resizes and redraws itself.
+ *
+ * void _XawLoadPixmap()	Start to load a pixmap for a widget
+ *
+ * The functions of LocPixmap.c used by the loader and the converters:
+ *
+ * Pixmap _XawBundledPixmap()	Create a pixmap of the pixmap bundle
+ * char **_XawPixmapCandidates() The files to try for a pixmap name
+ * void _XawRememberPixmapFile() Remember where a pixmap was found
+ * char *_XawResolvePixmapName() The file a pixmap name is read from
+ * XrmQuark _XawPixmapSearchKey() Changes when names may resolve anew
+ * Pixmap _XawCreateXpmPixmap()	Create a pixmap from a decoded file
+ *
+ * Copyright (c) Roland Krause 2002, roland_krause@freenet.de
+ *
+ * This module is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ **********************************************************************/
+
+#ifndef _AsyncPmap_h
+#define _AsyncPmap_h
+
+#include <X11/Intrinsic.h>
+#include <X11/xpm.h>
+
+/* Start to load the pixmap "name" for the resources pixmap_resource
+ * and mask_resource (which may be NULL) of w. *pixmap_return and
+ * *mask_return get what the widget shows until the pixmap is loaded:
+ * the pixmap itself if it is in the pixmap bundle, else a blank
+ * bitmap of width x height, or None if the size is 0. The loader
+ * owns these pixmaps and those it sets later, and frees them when
+ * the widget is destroyed or loads another pixmap for the resource.
+ * A NULL name only releases the previous pixmap.
+ */
+void _XawLoadPixmap(
+	Widget,			/* w */
+	char *,			/* name */
+	String,			/* pixmap_resource */
+	String,			/* mask_resource */
+	Dimension,		/* width */
+	Dimension,		/* height */
+	Pixmap *,		/* pixmap_return */
+	Pixmap *);		/* mask_return */
+
+Pixmap _XawBundledPixmap(
+	Screen *,		/* screen */
+	Colormap,		/* colormap */
+	char *,			/* PixmapName */
+	int *,			/* widthp - RETURN */
+	int *,			/* heightp - RETURN */
+	Pixmap *);		/* clipmask - RETURN */
+
+char **_XawPixmapCandidates(
+	Display *,		/* dpy */
+	char *);		/* name, without color overrides */
+
+void _XawRememberPixmapFile(
+	Display *,		/* dpy */
+	char *,			/* name, without color overrides */
+	char *);		/* path, NULL if not found */
+
+char *_XawResolvePixmapName(
+	Display *,		/* dpy */
+	char *);		/* name, with color overrides */
+
+XrmQuark _XawPixmapSearchKey(
+	Display *);		/* dpy */
+
+Pixmap _XawCreateXpmPixmap(
+	Screen *,		/* screen */
+	Colormap,		/* colormap */
+	char *,			/* PixmapName */
+	XpmImage *,		/* image */
+	Pixmap *);		/* clipmask - RETURN */
+
+#endif /* _AsyncPmap_h */
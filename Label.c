@@ -60,6 +60,7 @@ This file contains modifications for XawPlus, Roland Krause 2002
 #include "private.h"
 
 #include "UTF8.h"
+#include "AsyncPmap.h"
 
 #include <X11/IntrinsicP.h>
 #include <X11/StringDefs.h>
@@ -121,6 +122,15 @@ static XtResource resources[] = {
        offset(label.left_bitmap), XtRImmediate, (XtPointer)None},
     {XtNleftClipMask, XtCLeftBitmap, XtRClipMask, sizeof(Pixmap),
        offset(label.left_clipMask), XtRImmediate, (XtPointer)None},
+
+    {XtNbitmapName, XtCBitmapName, XtRString, sizeof(String),
+       offset(label.bitmap_name), XtRString, NULL},
+    {XtNleftBitmapName, XtCLeftBitmapName, XtRString, sizeof(String),
+       offset(label.left_bitmap_name), XtRString, NULL},
+    {XtNplaceholderWidth, XtCPlaceholderWidth, XtRDimension, sizeof(Dimension),
+       offset(label.placeholder_width), XtRImmediate, (XtPointer)0},
+    {XtNplaceholderHeight, XtCPlaceholderHeight, XtRDimension, sizeof(Dimension),
+       offset(label.placeholder_height), XtRImmediate, (XtPointer)0},
 };
 #undef offset
 
@@ -518,6 +528,16 @@ Initialize(
     GetnormalGC(lw);
     GetgrayGCs(lw);
 
+    if (lw->label.bitmap_name)
+	_XawLoadPixmap(new, lw->label.bitmap_name, XtNbitmap, XtNclipMask,
+		       lw->label.placeholder_width, lw->label.placeholder_height,
+		       &lw->label.pixmap, &lw->label.clipMask);
+    if (lw->label.left_bitmap_name)
+	_XawLoadPixmap(new, lw->label.left_bitmap_name, XtNleftBitmap,
+		       XtNleftClipMask, lw->label.placeholder_width,
+		       lw->label.placeholder_height, &lw->label.left_bitmap,
+		       &lw->label.left_clipMask);
+
     SetTextWidthAndHeight(lw);
     lw->label.label_full_len = NULL;
 
@@ -1065,6 +1085,21 @@ SetValues(
     if (newlw->label.label == NULL)
 	newlw->label.label = DeConst(newlw->core.name);
 
+    /*
+     * start loading pixmaps given by name
+     */
+    if (curlw->label.bitmap_name != newlw->label.bitmap_name) {
+	_XawLoadPixmap(new, newlw->label.bitmap_name, XtNbitmap, XtNclipMask,
+		       newlw->label.placeholder_width, newlw->label.placeholder_height,
+		       &newlw->label.pixmap, &newlw->label.clipMask);
+	checks[PIXMAP] = TRUE;
+    }
+    if (curlw->label.left_bitmap_name != newlw->label.left_bitmap_name)
+	_XawLoadPixmap(new, newlw->label.left_bitmap_name, XtNleftBitmap,
+		       XtNleftClipMask, newlw->label.placeholder_width,
+		       newlw->label.placeholder_height, &newlw->label.left_bitmap,
+		       &newlw->label.left_clipMask);
+
     /*
      * resize on bitmap change or change of font style
      */
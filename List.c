@@ -47,11 +47,13 @@ in this Software without prior written authorization from The Open Group.
 
 #include <X11/IntrinsicP.h>
 #include <X11/StringDefs.h>
+#include <X11/keysym.h>
 
 #include <X11/Xmu/Drawing.h>
 
 #include <X11/XawPlus/XawInit.h>
 #include <X11/XawPlus/ListP.h>
+#include <X11/XawPlus/ViewportP.h>
 /* *INDENT-OFF* */
 /* These added so widget knows whether its height, width are user selected.
 I also added the freedoms member of the list widget part. */
@@ -64,6 +66,26 @@ I also added the freedoms member of the list widget part. */
 #define WidthFree( w )   !(((ListWidget)(w))->list.freedoms & WidthLock )
 #define LongestFree( w ) !(((ListWidget)(w))->list.freedoms & LongestLock )
 
+/* A virtual list fetches its items with the fetchCallback. It may have more
+rows than fit into a window, whose position and size are 16 bit values. */
+
+#define MaxListHeight	32767
+
+#define IsVirtual( w )	(((ListWidget)(w))->list.is_virtual)
+#define UsesIcons( w )	(((ListWidget)(w))->list.iconList || \
+			 (IsVirtual(w) && ((ListWidget)(w))->list.icon_width))
+
+/* The selection of a multiSelect list is a bitset, one bit per item. */
+
+#define IsSelected( lw, i ) \
+	((((i) >> 3) < (lw)->list.selected_size) && \
+	 ((lw)->list.selected[(i) >> 3] & (1 << ((i) & 7))))
+
+/* Keystrokes of a type-ahead search more than SearchTimeout milliseconds
+apart start a new prefix. */
+
+#define SearchTimeout	1000
+
 /*
  * Default Translation table.
  */
@@ -72,6 +94,18 @@ static char defaultTranslations[] =
   "<Btn1Down>:   Set()\n\
    <Btn1Up>:     Notify()";
 
+/*
+ * Added by InstallTranslations() to lists that select more than one
+ * item, and to lists with a type-ahead search.
+ */
+
+static char multiTranslations[] =
+  "Shift<Btn1Down>: Extend()\n\
+   Ctrl<Btn1Down>: Toggle()";
+
+static char searchTranslations[] =
+  "<KeyPress>:   Search()";
+
 /****************************************************************
  *
  * Full class record constant
@@ -123,6 +157,16 @@ static XtResource resources[] = {
 	offset(list.row_space), XtRImmediate, (XtPointer)2},
     {XtNcallback, XtCCallback, XtRCallback, sizeof(XtPointer),
         offset(list.callback), XtRCallback, NULL},
+    {XtNfetchCallback, XtCCallback, XtRCallback, sizeof(XtPointer),
+        offset(list.fetch_callback), XtRCallback, NULL},
+    {XtNlongestSample, XtCLongestSample, XtRInt,  sizeof(int),
+	offset(list.longest_sample), XtRImmediate, (XtPointer)64},
+    {XtNcaseSensitive, XtCCaseSensitive, XtRBoolean,  sizeof(Boolean),
+	offset(list.case_sensitive), XtRImmediate, (XtPointer) False},
+    {XtNmultiSelect, XtCBoolean, XtRBoolean,  sizeof(Boolean),
+	offset(list.multi_select), XtRImmediate, (XtPointer) False},
+    {XtNtypeAhead, XtCBoolean, XtRBoolean,  sizeof(Boolean),
+	offset(list.type_ahead), XtRImmediate, (XtPointer) False},
 };
 
 static void Initialize(Widget junk, Widget new, ArgList args, Cardinal *num_args);
@@ -136,11 +180,19 @@ static Boolean SetValues(Widget current, Widget request, Widget new, ArgList arg
 static void Notify(Widget w, XEvent * event, String * params, Cardinal *num_params);
 static void Set(Widget w, XEvent * event, String * params, Cardinal *num_params);
 static void Unset(Widget w, XEvent * event, String * params, Cardinal *num_params);
+static void Search(Widget w, XEvent * event, String * params, Cardinal *num_params);
+static void Extend(Widget w, XEvent * event, String * params, Cardinal *num_params);
+static void Toggle(Widget w, XEvent * event, String * params, Cardinal *num_params);
+static void VirtualMoved(Widget w, XtPointer closure, XEvent *event, Boolean *cont);
+static void ForgetAtlas(Widget w);
 
 static XtActionsRec actions[] = {
       {"Notify",         Notify},
       {"Set",            Set},
       {"Unset",          Unset},
+      {"Search",         Search},
+      {"Extend",         Extend},
+      {"Toggle",         Toggle},
 };
 
 ListClassRec listClassRec = {
@@ -241,6 +293,238 @@ GetGCs(Widget w)
 	lw->list.graygc = XtGetGC(w, GCFont | GCTile | GCFillStyle, &values);
 }
 
+/*	Function Name: StringWidth
+ *	Description: Measures a string in the font of the list.
+ *	Arguments: w - the list widget.
+ *                 str - the string.
+ *	Returns: the width of the string in pixels.
+ */
+
+static int
+StringWidth(
+	       Widget w,
+	       String str)
+{
+    ListWidget lw = (ListWidget) w;
+
+    if (lw->simple.international == True)
+	return (XmbTextEscapement(lw->list.fontset, str, (int) strlen(str)));
+    return (XTextWidth(lw->list.font, str, (int) strlen(str)));
+}
+
+/*	Function Name: GetItem
+ *	Description: Gets the text and the icon of an item.
+ *	Arguments: w - the list widget.
+ *                 item - the item.
+ *                 ret - the item ** RETURNED **.
+ *	Returns: none.
+ *      NOTE:      The items of a virtual list are fetched with the
+ *                 fetchCallback, the string is only valid until the
+ *                 next item is fetched.
+ */
+
+static void
+GetItem(
+	   Widget w,
+	   int item,
+	   XawListFetchStruct * ret)
+{
+    ListWidget lw = (ListWidget) w;
+
+    ret->list_index = item;
+    ret->bitmap = ret->clipMask = XtUnspecifiedPixmap;
+
+    if (lw->list.is_virtual) {
+	ret->string = NULL;
+	XtCallCallbackList(w, lw->list.fetch_callback, (XtPointer) ret);
+	if (ret->string == NULL)
+	    ret->string = DeConst("");
+    } else if (lw->list.iconList) {
+	ret->string = DeConst(lw->list.iconList[item].string);
+	ret->bitmap = lw->list.iconList[item].bitmap;
+	ret->clipMask = lw->list.iconList[item].clipMask;
+    } else
+	ret->string = DeConst(lw->list.list[item]);
+}
+
+/*	Function Name: CountWidth
+ *	Description: Counts an item of the given width in or out of the
+ *                   width_count table and updates longest.
+ *	Arguments: w - the list widget.
+ *                 width - the width of the item.
+ *                 n - 1 to count it in, -1 to count it out.
+ *	Returns: none.
+ *      NOTE:      The table counts the items of each width in pixels.
+ *                 When the last of the longest items goes, the next
+ *                 longest is found in the table, without measuring
+ *                 the items again.
+ */
+
+static void
+CountWidth(
+	      Widget w,
+	      int width,
+	      int n)
+{
+    ListWidget lw = (ListWidget) w;
+    int size;
+
+    if (width >= lw->list.width_size) {
+	size = (lw->list.width_size > 0) ? lw->list.width_size : 256;
+	while (size <= width)
+	    size *= 2;
+	lw->list.width_count = (int *) XtRealloc((char *) lw->list.width_count,
+						 (Cardinal) (size * sizeof(int)));
+	memset(lw->list.width_count + lw->list.width_size, 0,
+	       (size_t) (size - lw->list.width_size) * sizeof(int));
+	lw->list.width_size = size;
+    }
+    lw->list.width_count[width] += n;
+
+    if ((n > 0) && (width > lw->list.longest))
+	lw->list.longest = width;
+    else if ((n < 0) && (width == lw->list.longest))
+	while ((lw->list.longest > 0) &&
+	       (lw->list.width_count[lw->list.longest] == 0))
+	    lw->list.longest--;
+}
+
+/*	Function Name: MeasureItems
+ *	Description: Measures items into the widths table and counts them.
+ *	Arguments: w - the list widget.
+ *                 first - the first item.
+ *                 count - the number of items.
+ *	Returns: none.
+ */
+
+static void
+MeasureItems(
+		Widget w,
+		int first,
+		int count)
+{
+    ListWidget lw = (ListWidget) w;
+    int i, len;
+
+    for (i = first; i < first + count; i++) {
+	if (lw->list.iconList)
+	    len = StringWidth(w, lw->list.iconList[i].string);
+	else
+	    len = StringWidth(w, lw->list.list[i]);
+	if (len > 0xffff)
+	    len = 0xffff;
+	lw->list.widths[i] = (Dimension) len;
+	CountWidth(w, len, 1);
+    }
+}
+
+/*	Function Name: ForgetWidths
+ *	Description: Frees the widths of the items.
+ *	Arguments: w - the list widget.
+ *	Returns: none.
+ */
+
+static void
+ForgetWidths(Widget w)
+{
+    ListWidget lw = (ListWidget) w;
+
+    XtFree((char *) lw->list.widths);
+    XtFree((char *) lw->list.width_count);
+    lw->list.widths = NULL;
+    lw->list.width_count = NULL;
+    lw->list.widths_size = lw->list.width_size = 0;
+}
+
+/*	Function Name: CompareText
+ *	Description: Compares two strings, or the first n characters of
+ *                   them, with or without case as the caseSensitive
+ *                   resource says.
+ *	Arguments: lw - the list widget.
+ *                 a, b - the strings.
+ *                 n - the characters to compare.
+ *	Returns: less than, equal to or greater than zero, as strncmp().
+ */
+
+static int
+CompareText(
+	       ListWidget lw,
+	       const char *a,
+	       const char *b,
+	       size_t n)
+{
+    int ca, cb;
+
+    if (lw->list.case_sensitive)
+	return (strncmp(a, b, n));
+    for (; n > 0; a++, b++, n--) {
+	ca = tolower((unsigned char) *a);
+	cb = tolower((unsigned char) *b);
+	if ((ca != cb) || (ca == '\0'))
+	    return (ca - cb);
+    }
+    return (0);
+}
+
+static ListWidget sort_widget;	/* the list sorted by SortItems() */
+
+/*	Function Name: CompareItems
+ *	Description: Sorts items by their strings for qsort(). Equal
+ *                   strings are kept in the order of the list.
+ */
+
+static int
+CompareItems(
+		const void *a,
+		const void *b)
+{
+    XawListFetchStruct ia, ib;
+    int result;
+
+    GetItem((Widget) sort_widget, *(const int *) a, &ia);
+    GetItem((Widget) sort_widget, *(const int *) b, &ib);
+    result = CompareText(sort_widget, ia.string, ib.string, (size_t) -1);
+    if (result == 0)
+	result = *(const int *) a - *(const int *) b;
+    return (result);
+}
+
+/*	Function Name: SortItems
+ *	Description: Builds the index of the items sorted by their strings,
+ *                   which the type-ahead search looks into.
+ *	Arguments: w - the list widget.
+ *	Returns: none.
+ */
+
+static void
+SortItems(Widget w)
+{
+    ListWidget lw = (ListWidget) w;
+    int i;
+
+    lw->list.sorted = (int *) XtMalloc((Cardinal) ((lw->list.nitems + 1) * sizeof(int)));
+    for (i = 0; i < lw->list.nitems; i++)
+	lw->list.sorted[i] = i;
+    sort_widget = lw;
+    qsort(lw->list.sorted, (size_t) lw->list.nitems, sizeof(int), CompareItems);
+}
+
+/*	Function Name: ForgetSorted
+ *	Description: Frees the sorted index, when the items have changed.
+ *                   It is built again by the next search.
+ *	Arguments: w - the list widget.
+ *	Returns: none.
+ */
+
+static void
+ForgetSorted(Widget w)
+{
+    ListWidget lw = (ListWidget) w;
+
+    XtFree((char *) lw->list.sorted);
+    lw->list.sorted = NULL;
+}
+
 /* CalculatedValues()
  *
  * does routine checks/computations that must be done after data changes
@@ -258,6 +542,37 @@ CalculatedValues(Widget w)
 
     ListWidget lw = (ListWidget) w;
 
+    ForgetWidths(w);
+    ForgetAtlas(w);
+    ForgetSorted(w);
+
+    /* A virtual list has as many items as it is told. Its longest item
+       is estimated from a sample spread evenly over the list, because
+       fetching and measuring millions of items takes too long. */
+
+    if (lw->list.is_virtual) {
+	XawListFetchStruct item;
+	int n = lw->list.longest_sample;
+
+	if (lw->list.nitems < 0)
+	    lw->list.nitems = 0;
+	if (LongestFree(lw)) {
+	    lw->list.longest = 0;
+	    if ((n <= 0) || (n > lw->list.nitems))
+		n = lw->list.nitems;
+	    for (i = 0; i < n; i++) {
+		GetItem(w, (n > 1) ? (int) ((double) i * (lw->list.nitems - 1)
+					    / (n - 1)) : 0, &item);
+		len = StringWidth(w, item.string);
+		if (len > lw->list.longest)
+		    lw->list.longest = len;
+	    }
+	}
+	lw->list.col_width = lw->list.longest + lw->list.column_space
+	    + lw->list.icon_width;
+	return;
+    }
+
     /* If both lists are NULL then the list will just be the name of the widget. */
 
     if ((lw->list.list == NULL) && (lw->list.iconList == NULL)) {
@@ -279,35 +594,16 @@ CalculatedValues(Widget w)
 
     /* Get column width. */
 
+    /* The widths are kept, so that the longest item can be found again
+       when items are inserted or deleted. */
+
     if (LongestFree(lw)) {
 	lw->list.longest = 0;	/* so it will accumulate real longest below */
 
-	if (lw->list.iconList) {
-	    for (i = 0; i < lw->list.nitems; i++) {
-		if (lw->simple.international == True)
-		    len = XmbTextEscapement(lw->list.fontset,
-					    lw->list.iconList[i].string,
-					    (int)
-							 strlen(lw->list.iconList[i].string));
-		else
-		    len = XTextWidth(lw->list.font, lw->list.iconList[i].string,
-				     (int) strlen(lw->list.iconList[i].string));
-		if (len > lw->list.longest)
-		    lw->list.longest = len;
-	    }
-	} else {
-	    for (i = 0; i < lw->list.nitems; i++) {
-		if (lw->simple.international == True)
-		    len = XmbTextEscapement(lw->list.fontset,
-					    lw->list.list[i], (int)
-									   strlen(lw->list.list[i]));
-		else
-		    len = XTextWidth(lw->list.font, lw->list.list[i], (int)
-				     strlen(lw->list.list[i]));
-		if (len > lw->list.longest)
-		    lw->list.longest = len;
-	    }
-	}
+	lw->list.widths_size = lw->list.nitems;
+	lw->list.widths = (Dimension *) XtMalloc((Cardinal)
+						 (lw->list.widths_size * sizeof(Dimension)));
+	MeasureItems(w, 0, lw->list.nitems);
     }
     lw->list.col_width = lw->list.longest + lw->list.column_space;
     if (lw->list.iconList)
@@ -390,6 +686,37 @@ ChangeSize(
     }
 }
 
+/*	Function Name: InstallTranslations
+ *	Description: Adds the translations for Extend() and Toggle() to a
+ *                   multiSelect list, ahead of those for Set(), and the
+ *                   one for Search() to a list with typeAhead, behind
+ *                   those of the application. Other lists keep the
+ *                   translations of the Xaw List. Translations are not
+ *                   taken away again when a resource is turned off;
+ *                   the actions then work like Set() or do nothing.
+ *	Arguments: w - the list widget.
+ *                 old - the list before XtSetValues(), or NULL.
+ *	Returns: none.
+ */
+
+static void
+InstallTranslations(Widget w, Widget old)
+{
+    static XtTranslations multi, search;	/* initially 0 */
+    ListWidget lw = (ListWidget) w, ol = (ListWidget) old;
+
+    if (lw->list.multi_select && ((ol == NULL) || !ol->list.multi_select)) {
+	if (!multi)
+	    multi = XtParseTranslationTable(multiTranslations);
+	XtOverrideTranslations(w, multi);
+    }
+    if (lw->list.type_ahead && ((ol == NULL) || !ol->list.type_ahead)) {
+	if (!search)
+	    search = XtParseTranslationTable(searchTranslations);
+	XtAugmentTranslations(w, search);
+    }
+}
+
 /*	Function Name: Initialize
  *	Description: Function that initilizes the widget instance.
  *	Arguments: junk - NOT USED.
@@ -415,6 +742,24 @@ Initialize(
 	(lw->core.height != 0) * HeightLock +
 	(lw->list.longest != 0) * LongestLock;
 
+    lw->list.is_virtual = (XtHasCallbacks(new, XtNfetchCallback) == XtCallbackHasSome);
+    lw->list.virtual_height = 0.0;
+    lw->list.row_offset = lw->list.pixel_offset = 0;
+    lw->list.mapped_top = -1;
+    lw->list.widths = NULL;
+    lw->list.width_count = NULL;
+    lw->list.widths_size = lw->list.width_size = 0;
+    lw->list.atlas = NULL;
+    lw->list.sorted = NULL;
+    lw->list.prefix = NULL;
+    lw->list.prefix_length = lw->list.prefix_size = 0;
+    lw->list.prefix_time = 0;
+    lw->list.selected = NULL;
+    lw->list.selected_size = 0;
+    lw->list.anchor = NO_HIGHLIGHT;
+    XtAddEventHandler(new, StructureNotifyMask, FALSE, VirtualMoved, NULL);
+    InstallTranslations(new, NULL);
+
     GetGCs(new);
 
     /* Set row height. based on font or fontset */
@@ -424,7 +769,7 @@ Initialize(
     else
 	lw->list.row_height = lw->list.font->max_bounds.ascent + lw->list.font->max_bounds.descent;
 
-    if (lw->list.iconList && (lw->list.row_height < lw->list.icon_height))
+    if (UsesIcons(lw) && (lw->list.row_height < lw->list.icon_height))
 	lw->list.row_height = lw->list.icon_height + lw->list.row_space;
     else
 	lw->list.row_height += lw->list.row_space;
@@ -434,6 +779,59 @@ Initialize(
 
 }				/* Initialize */
 
+/*	Function Name: RowAt
+ *	Description: Converts a y coordinate to the row containing it.
+ *	Arguments: lw - the list widget.
+ *                 yloc - the y location.
+ *	Returns: the row number, not checked against the number of rows.
+ */
+
+static int
+RowAt(
+	 ListWidget lw,
+	 int yloc)
+{
+    return ((yloc - (int) lw->list.internal_height + lw->list.pixel_offset)
+	    / lw->list.row_height + lw->list.row_offset);
+}
+
+/*	Function Name: RowY
+ *	Description: Converts a row to the y coordinate of its top.
+ *	Arguments: lw - the list widget.
+ *                 row - the row number.
+ *	Returns: the y location.
+ *      NOTE:      The rows above row_offset are mapped away in long
+ *                 virtual lists, see SetVirtualOffset().
+ */
+
+static int
+RowY(
+	ListWidget lw,
+	int row)
+{
+    return (lw->list.row_height * (row - lw->list.row_offset)
+	    + (int) lw->list.internal_height - lw->list.pixel_offset);
+}
+
+/*	Function Name: RowInWindow
+ *	Description: Checks if a row may be in the window. Most rows of a
+ *                   long virtual list are not, and are not fetched.
+ *	Arguments: lw - the list widget.
+ *                 row - the row number.
+ *	Returns: TRUE if the row may be in the window.
+ */
+
+static Boolean
+RowInWindow(
+	       ListWidget lw,
+	       int row)
+{
+    if (!lw->list.is_virtual)
+	return (TRUE);
+    return ((row >= lw->list.row_offset - 1) &&
+	    (row <= lw->list.row_offset + (int) lw->core.height / lw->list.row_height + 1));
+}
+
 /*	Function Name: CvtToItem
  *	Description: Converts Xcoord to item number of item containing that
  *                   point.
@@ -456,16 +854,14 @@ CvtToItem(
     if (lw->list.vertical_cols) {
 	one = lw->list.nrows * ((xloc - (int) lw->list.internal_width)
 				/ lw->list.col_width);
-	another = (yloc - (int) lw->list.internal_height)
-	    / lw->list.row_height;
+	another = RowAt(lw, yloc);
 	/* If out of range, return minimum possible value. */
 	if (another >= lw->list.nrows) {
 	    another = lw->list.nrows - 1;
 	    ret_val = OUT_OF_RANGE;
 	}
     } else {
-	one = (lw->list.ncols * ((yloc - (int) lw->list.internal_height)
-				 / lw->list.row_height));
+	one = lw->list.ncols * RowAt(lw, yloc);
 	/* If in right margin handle things right. */
 	another = (xloc - (int) lw->list.internal_width) / lw->list.col_width;
 	if (another >= lw->list.ncols) {
@@ -485,87 +881,510 @@ CvtToItem(
     return (ret_val);
 }
 
-/*	Function Name: FindCornerItems.
- *	Description: Find the corners of the rectangle in item space.
+/* The icon atlas: the icons with a clip mask, each painted once on the
+   background and once on the highlighted background of the list. They
+   are drawn with one XCopyArea() and no change of the clip mask. Each
+   slot is a row of the pixmap: the icon on the background on the left,
+   on the highlighted background on the right. The pixmap costs server
+   memory besides the icons themselves, so it has at most MaxAtlasPixels
+   pixels (256 KB at 32 bits per pixel); the icons that do not fit in
+   are drawn with their clip masks. */
+
+#define MaxAtlasPixels	65536
+
+typedef struct _ListAtlas {
+    Pixmap pixmap;
+    GC gc;			/* to paint into the pixmap */
+    int nslots,			/* slots used so far */
+        nfree,			/* of these, slots freed again */
+        size;			/* slots in the pixmap */
+    Pixmap *bitmaps,		/* the icon in each slot, None if free */
+           *masks;		/* and its clip mask */
+    int *hash,			/* slot + 1 by icon, 0 if empty */
+        hash_size;		/* a power of 2 */
+} ListAtlas;
+
+#define AtlasHash(bitmap, mask)	((unsigned long) (bitmap) * 31 + (unsigned long) (mask))
+
+/*	Function Name: ForgetAtlas
+ *	Description: Frees the icon atlas, when the icons or the colors
+ *                   may have changed.
  *	Arguments: w - the list widget.
- *                 event - the event structure that has the rectangle it it.
- *                 ul_ret, lr_ret - the corners ** RETURNED **.
  *	Returns: none.
  */
 
 static void
-FindCornerItems(
-		   Widget w,
-		   XEvent *event,
-		   int *ul_ret,
-		   int *lr_ret)
+ForgetAtlas(Widget w)
+{
+    ListWidget lw = (ListWidget) w;
+    ListAtlas *atlas = lw->list.atlas;
+
+    if (atlas == NULL)
+	return;
+    if (atlas->pixmap != None)
+	XFreePixmap(XtDisplay(w), atlas->pixmap);
+    if (atlas->gc != NULL)
+	XFreeGC(XtDisplay(w), atlas->gc);
+    XtFree((char *) atlas->bitmaps);
+    XtFree((char *) atlas->masks);
+    XtFree((char *) atlas->hash);
+    XtFree((char *) atlas);
+    lw->list.atlas = NULL;
+}
+
+/*	Function Name: HashAtlas
+ *	Description: Enters the icons of the atlas into its hash table.
+ *	Arguments: atlas - the icon atlas.
+ *	Returns: none.
+ */
+
+static void
+HashAtlas(ListAtlas * atlas)
 {
-    int xloc, yloc;
+    int i, h;
+
+    memset(atlas->hash, 0, (size_t) atlas->hash_size * sizeof(int));
+    for (i = 0; i < atlas->nslots; i++) {
+	if (atlas->bitmaps[i] == None)
+	    continue;
+	h = (int) (AtlasHash(atlas->bitmaps[i], atlas->masks[i])
+		   & (unsigned long) (atlas->hash_size - 1));
+	while (atlas->hash[h] != 0)
+	    h = (h + 1) & (atlas->hash_size - 1);
+	atlas->hash[h] = i + 1;
+    }
+}
 
-    xloc = event->xexpose.x;
-    yloc = event->xexpose.y;
-    CvtToItem(w, xloc, yloc, ul_ret);
-    xloc += event->xexpose.width;
-    yloc += event->xexpose.height;
-    CvtToItem(w, xloc, yloc, lr_ret);
+/*	Function Name: FindAtlasSlot
+ *	Description: Finds an icon with a clip mask in the atlas.
+ *	Arguments: atlas - the icon atlas, may be NULL.
+ *                 bitmap, mask - the icon and its clip mask.
+ *	Returns: the slot of the icon, -1 if it is not in the atlas.
+ */
+
+static int
+FindAtlasSlot(
+		 ListAtlas * atlas,
+		 Pixmap bitmap,
+		 Pixmap mask)
+{
+    int h, slot;
+
+    if ((atlas == NULL) || (atlas->hash_size == 0))
+	return (-1);
+    h = (int) (AtlasHash(bitmap, mask) & (unsigned long) (atlas->hash_size - 1));
+    while ((slot = atlas->hash[h] - 1) >= 0) {
+	if ((atlas->bitmaps[slot] == bitmap) && (atlas->masks[slot] == mask))
+	    return (slot);
+	h = (h + 1) & (atlas->hash_size - 1);
+    }
+    return (-1);
 }
 
-/*	Function Name: ItemInRectangle
- *	Description: returns TRUE if the item passed is in the given rectangle.
+/*	Function Name: ForgetIcons
+ *	Description: Frees the slots of the icons of some items, which
+ *                   may have been changed in place, or may reuse the
+ *                   ID of a pixmap freed before.
  *	Arguments: w - the list widget.
- *                 ul, lr - corners of the rectangle in item space.
- *                 item - item to check.
- *	Returns: TRUE if the item passed is in the given rectangle.
+ *                 first - the first item.
+ *                 count - the number of items.
+ *	Returns: none.
+ *      NOTE:      The items of a virtual list are not fetched for this:
+ *                 if there are more than one, the atlas is dropped.
  */
 
-static Boolean
-ItemInRectangle(
-		   Widget w,
-		   int ul,
-		   int lr,
-		   int item)
+static void
+ForgetIcons(
+	       Widget w,
+	       int first,
+	       int count)
 {
     ListWidget lw = (ListWidget) w;
-    int mod_item;
-    int things;
+    ListAtlas *atlas = lw->list.atlas;
+    XawListFetchStruct entry;
+    int item, slot, nfree;
+
+    if (atlas == NULL)
+	return;
+    if (lw->list.is_virtual && (count > 1)) {
+	ForgetAtlas(w);
+	return;
+    }
+    nfree = atlas->nfree;
+    for (item = first; item < first + count; item++) {
+	GetItem(w, item, &entry);
+	if ((slot = FindAtlasSlot(atlas, entry.bitmap, entry.clipMask)) >= 0) {
+	    atlas->bitmaps[slot] = atlas->masks[slot] = None;
+	    atlas->nfree++;
+	}
+    }
+    if (atlas->nfree != nfree)
+	HashAtlas(atlas);
+}
 
-    if (item < ul || item > lr)
+/*	Function Name: GrowAtlas
+ *	Description: Makes room for more icons in the atlas.
+ *	Arguments: w - the list widget.
+ *	Returns: FALSE if the atlas is as large as it may be.
+ */
+
+static Boolean
+GrowAtlas(Widget w)
+{
+    ListWidget lw = (ListWidget) w;
+    ListAtlas *atlas = lw->list.atlas;
+    int size, max = MaxListHeight / (int) lw->list.icon_height;
+    Pixmap pixmap;
+
+    if (max > MaxAtlasPixels / (2 * (int) lw->list.icon_width
+				* (int) lw->list.icon_height))
+	max = MaxAtlasPixels / (2 * (int) lw->list.icon_width
+				* (int) lw->list.icon_height);
+    size = (atlas->size > 0) ? 2 * atlas->size : 16;
+    if (size > max)
+	size = max;
+    if (size <= atlas->size)
 	return (FALSE);
-    if (lw->list.vertical_cols)
-	things = lw->list.nrows;
+
+    pixmap = XCreatePixmap(XtDisplay(w), XtWindow(w),
+			   2 * (unsigned) lw->list.icon_width,
+			   (unsigned) (size * lw->list.icon_height),
+			   (unsigned) lw->list.icon_depth);
+    if (atlas->gc == NULL)
+	atlas->gc = XCreateGC(XtDisplay(w), pixmap, 0, NULL);
+    if (atlas->pixmap != None) {
+	XCopyArea(XtDisplay(w), atlas->pixmap, pixmap, atlas->gc, 0, 0,
+		  2 * (unsigned) lw->list.icon_width,
+		  (unsigned) (atlas->size * lw->list.icon_height), 0, 0);
+	XFreePixmap(XtDisplay(w), atlas->pixmap);
+    }
+    atlas->pixmap = pixmap;
+    atlas->size = size;
+    atlas->bitmaps = (Pixmap *) XtRealloc((char *) atlas->bitmaps,
+					  (Cardinal) (size * sizeof(Pixmap)));
+    atlas->masks = (Pixmap *) XtRealloc((char *) atlas->masks,
+					(Cardinal) (size * sizeof(Pixmap)));
+
+    /* Hash the icons again, into a table at least twice as large */
+
+    XtFree((char *) atlas->hash);
+    for (atlas->hash_size = 32; atlas->hash_size < 2 * size; atlas->hash_size *= 2) ;
+    atlas->hash = (int *) XtMalloc((Cardinal) (atlas->hash_size * sizeof(int)));
+    HashAtlas(atlas);
+    return (TRUE);
+}
+
+/*	Function Name: AtlasSlot
+ *	Description: Finds an icon with a clip mask in the atlas, or puts
+ *                   it there.
+ *	Arguments: w - the list widget.
+ *                 bitmap, mask - the icon and its clip mask.
+ *	Returns: the slot of the icon, -1 if it has to be drawn with its
+ *               clip mask.
+ *      NOTE:      The icons are known by their pixmap IDs: the slots of
+ *                 items that are updated or inserted are freed by
+ *                 ForgetIcons(). Icons on a background pixmap can't be
+ *                 painted in advance.
+ */
+
+static int
+AtlasSlot(
+	     Widget w,
+	     Pixmap bitmap,
+	     Pixmap mask)
+{
+    ListWidget lw = (ListWidget) w;
+    ListAtlas *atlas = lw->list.atlas;
+    Display *dpy = XtDisplay(w);
+    int h, slot, v, x, y;
+
+    if (lw->core.background_pixmap != XtUnspecifiedPixmap)
+	return (-1);
+    if (atlas == NULL)
+	atlas = lw->list.atlas = (ListAtlas *) XtCalloc(1, sizeof(ListAtlas));
+
+    if ((slot = FindAtlasSlot(atlas, bitmap, mask)) >= 0)
+	return (slot);
+
+    /* Take a freed slot, or a new one */
+
+    if (atlas->nfree > 0) {
+	for (slot = 0; atlas->bitmaps[slot] != None; slot++) ;
+	atlas->nfree--;
+    } else if ((atlas->nslots < atlas->size) || GrowAtlas(w))
+	slot = atlas->nslots++;
     else
-	things = lw->list.ncols;
+	return (-1);
+
+    /* Paint the icon on both backgrounds */
+
+    atlas->bitmaps[slot] = bitmap;
+    atlas->masks[slot] = mask;
+    y = slot * (int) lw->list.icon_height;
+    for (v = 0; v < 2; v++) {
+	x = v * (int) lw->list.icon_width;
+	XSetForeground(dpy, atlas->gc, v ? lw->list.foreground : lw->core.background_pixel);
+	XFillRectangle(dpy, atlas->pixmap, atlas->gc, x, y,
+		       lw->list.icon_width, lw->list.icon_height);
+	XSetClipMask(dpy, atlas->gc, mask);
+	XSetClipOrigin(dpy, atlas->gc, x, y);
+	XCopyArea(dpy, bitmap, atlas->pixmap, atlas->gc, 0, 0,
+		  lw->list.icon_width, lw->list.icon_height, x, y);
+	XSetClipMask(dpy, atlas->gc, None);
+    }
 
-    mod_item = item % things;
-    if ((mod_item >= ul % things) && (mod_item <= lr % things))
-	return (TRUE);
-    return (FALSE);
+    h = (int) (AtlasHash(bitmap, mask) & (unsigned long) (atlas->hash_size - 1));
+    while (atlas->hash[h] != 0)
+	h = (h + 1) & (atlas->hash_size - 1);
+    atlas->hash[h] = slot + 1;
+    return (slot);
 }
 
-/*	Function Name: HighlightBackground
- *	Description: paints the color of the background for the given item.
- *	Arguments: w - the widget.
- *                 x, y - ul corner of the area item occupies.
- *                 gc - the gc that is used to paint this rectangle
- *	Returns:
+/* An item to paint, see PaintCells() */
+
+typedef struct {
+    int x, y;			/* ul corner of the item's column and row */
+    GC gc;			/* for the text */
+    GC background;		/* for the background, NULL if none */
+    String string;
+    int length;
+    Pixmap bitmap, clipMask;
+} ListCell;
+
+/*	Function Name: MakeCell
+ *	Description: Gets an item ready to be painted and takes note of its
+ *                   highlighting. The items of a multiSelect list are
+ *                   highlighted if they are selected.
+ *	Arguments: w - the list widget.
+ *                 item - the item to paint.
+ *                 cell - the item to paint ** RETURNED **.
+ *	Returns: FALSE if the item is not in the window.
+ */
+
+static Boolean
+MakeCell(
+	    Widget w,
+	    int item,
+	    ListCell * cell)
+{
+    ListWidget lw = (ListWidget) w;
+    XawListFetchStruct entry;
+    GC normal = XtIsSensitive(w) ? lw->list.normgc : lw->list.graygc;
+    int row;
+
+    if (lw->list.vertical_cols) {
+	cell->x = (lw->list.col_width + lw->list.internal_width) * (item / lw->list.nrows);
+	row = item % lw->list.nrows;
+    } else {
+	cell->x = (lw->list.col_width + lw->list.internal_width) * (item % lw->list.ncols);
+	row = item / lw->list.ncols;
+    }
+    if (!RowInWindow(lw, row))
+	return (FALSE);
+    cell->y = RowY(lw, row);
+
+    /* Paint or erase the highlighted background */
+
+    cell->gc = normal;
+    cell->background = NULL;
+    if (lw->list.multi_select) {
+	if (IsSelected(lw, item)) {
+	    cell->gc = lw->list.revgc;
+	    cell->background = lw->list.normgc;
+	}
+    } else if (item == lw->list.highlight) {
+	cell->gc = lw->list.revgc;
+	cell->background = lw->list.normgc;
+	lw->list.is_highlighted = item;
+    } else if (item == lw->list.is_highlighted) {
+	cell->background = lw->list.revgc;
+	lw->list.is_highlighted = NO_HIGHLIGHT;
+    }
+    GetItem(w, item, &entry);
+    cell->string = entry.string;
+    cell->length = (int) strlen(entry.string);
+    cell->bitmap = entry.bitmap;
+    cell->clipMask = entry.clipMask;
+    return (TRUE);
+}
+
+/*	Function Name: CompareMasks
+ *	Description: Sorts cells by their clip mask for qsort().
+ */
+
+static int
+CompareMasks(
+		const void *a,
+		const void *b)
+{
+    Pixmap mask_a = (*(ListCell * const *) a)->clipMask;
+    Pixmap mask_b = (*(ListCell * const *) b)->clipMask;
+
+    return ((mask_a < mask_b) ? -1 : (mask_a > mask_b));
+}
+
+/*	Function Name: PaintCells
+ *	Description: Paints items with as few requests as possible: the
+ *                   backgrounds with one XFillRectangles() per GC, the
+ *                   icons with a clip mask from the atlas, or sorted by
+ *                   mask, so that each mask is set once, and the strings
+ *                   of neighbouring items in a row with one XDrawText().
+ *	Arguments: w - the list widget.
+ *                 cells - the items, sorted by rows.
+ *                 n - the number of items.
+ *	Returns: none.
  */
 
 static void
-HighlightBackground(
-		       Widget w,
-		       int x,
-		       int y,
-		       GC gc)
+PaintCells(
+	      Widget w,
+	      ListCell * cells,
+	      int n)
 {
     ListWidget lw = (ListWidget) w;
-    int hl_x, hl_y, width;
+    Display *dpy = XtDisplay(w);
+    Window win = XtWindow(w);
+    XRectangle *rects;
+    ListCell **masked;
+    Pixmap mask = None;
+    GC gcs[2];
+    int i, j, k, nmasked, x, str_y, delta, slot;
+    int icons, str_dx;
+    XFontSetExtents *ext = XExtentsOfFontSet(lw->list.fontset);
+
+    if (n <= 0)
+	return;
+    icons = UsesIcons(lw) && (lw->list.icon_width > 0) && (lw->list.icon_height > 0);
+    str_dx = lw->list.column_space / 2;
+    if (UsesIcons(lw))
+	str_dx += lw->list.icon_width + lw->list.internal_width;
+    rects = (XRectangle *) XtMalloc((Cardinal) (n * sizeof(XRectangle)));
+    masked = (ListCell **) XtMalloc((Cardinal) (n * sizeof(ListCell *)));
+
+    /* The backgrounds of highlighted and unhighlighted items */
+
+    gcs[0] = lw->list.normgc;
+    gcs[1] = lw->list.revgc;
+    for (j = 0; j < 2; j++) {
+	for (i = k = 0; i < n; i++)
+	    if (cells[i].background == gcs[j]) {
+		rects[k].x = (short) (cells[i].x + lw->list.internal_width
+				      - lw->list.column_space / 2);
+		rects[k].y = (short) (cells[i].y - lw->list.row_space / 2);
+		rects[k].width = (unsigned short) (lw->list.col_width
+						   + lw->list.column_space / 2);
+		rects[k].height = (unsigned short) lw->list.row_height;
+		k++;
+	    }
+	if (k > 0)
+	    XFillRectangles(dpy, win, gcs[j], rects, k);
+    }
+
+    /*  Paint the icons. An icon will only be painted, if width and
+       height are greater than 0 and if an icon is defined for this
+       entry. The depth of the icon has to be 1 (normal bitmap) or of
+       the same color depth as your display */
+
+    if (icons) {
+	for (i = nmasked = 0; i < n; i++) {
+	    x = cells[i].x + lw->list.column_space / 2;
+	    if (cells[i].bitmap == XtUnspecifiedPixmap) {
+		if (cells[i].background)
+		    XClearArea(dpy, win, x, cells[i].y, lw->list.icon_width,
+			       lw->list.icon_height, FALSE);
+	    } else if (lw->list.icon_depth == 1)
+		XCopyPlane(dpy, cells[i].bitmap, win, lw->list.normgc, 0, 0,
+			   lw->list.icon_width, lw->list.icon_height,
+			   x, cells[i].y, 1L);
+	    else if (cells[i].clipMask == XtUnspecifiedPixmap)
+		XCopyArea(dpy, cells[i].bitmap, win, lw->list.normgc, 0, 0,
+			  lw->list.icon_width, lw->list.icon_height,
+			  x, cells[i].y);
+	    else if ((slot = AtlasSlot(w, cells[i].bitmap, cells[i].clipMask)) >= 0)
+		XCopyArea(dpy, lw->list.atlas->pixmap, win, lw->list.normgc,
+			  (cells[i].background == lw->list.normgc) ?
+			  (int) lw->list.icon_width : 0,
+			  slot * (int) lw->list.icon_height,
+			  lw->list.icon_width, lw->list.icon_height,
+			  x, cells[i].y);
+	    else
+		masked[nmasked++] = &cells[i];
+	}
 
-    hl_x = x - lw->list.column_space / 2;
-    width = lw->list.col_width + lw->list.column_space / 2;
-    hl_y = y - lw->list.row_space / 2;
+	/* Support of a clip mask for non rectangular or transparent
+	 * pixmaps, if they are not in the atlas: Manipulate the GC with
+	 * a clip mask, once for all icons with the same mask
+	 */
+	qsort(masked, (size_t) nmasked, sizeof(ListCell *), CompareMasks);
+	for (i = 0; i < nmasked; i++) {
+	    x = masked[i]->x + lw->list.column_space / 2;
+	    if ((i == 0) || (masked[i]->clipMask != mask)) {
+		mask = masked[i]->clipMask;
+		XSetClipMask(dpy, lw->list.iconGc, mask);
+	    }
+	    XSetClipOrigin(dpy, lw->list.iconGc, x, masked[i]->y);
+	    XCopyArea(dpy, masked[i]->bitmap, win, lw->list.iconGc, 0, 0,
+		      lw->list.icon_width, lw->list.icon_height, x, masked[i]->y);
+	}
+    }
+
+    /* List's overall width contains the same number of inter-column
+       column_space's as columns.  There should thus be a half
+       column_width margin on each side of each column.
+       The row case is symmetric.
+
+       The strings of the items next to each other in a row are drawn
+       with one request, each placed by its distance to the end of
+       the string before it. */
 
-    XFillRectangle(XtDisplay(w), XtWindow(w), gc, hl_x, hl_y, (unsigned)
-		   width, (unsigned) lw->list.row_height);
+    if (lw->simple.international)
+	delta = (lw->list.row_height - ext->max_ink_extent.height) / 2
+	    - lw->list.internal_height + abs(ext->max_ink_extent.y);
+    else
+	delta = (lw->list.row_height - lw->list.font->max_bounds.ascent -
+		 lw->list.font->max_bounds.descent) / 2 - lw->list.internal_height
+	    + lw->list.font->max_bounds.ascent;
+    delta += lw->list.row_space / 2;
+
+    for (i = 0; i < n; i = j) {
+	for (j = i + 1; (j < n) && (cells[j].y == cells[i].y) &&
+	     (cells[j].gc == cells[i].gc); j++) ;
+	str_y = cells[i].y + delta;
+
+	if (lw->simple.international) {
+	    XmbTextItem *items = (XmbTextItem *) XtMalloc((Cardinal)
+							   ((j - i) * sizeof(XmbTextItem)));
+
+	    for (k = i; k < j; k++) {
+		items[k - i].chars = cells[k].string;
+		items[k - i].nchars = cells[k].length;
+		items[k - i].font_set = (k == i) ? lw->list.fontset : NULL;
+		items[k - i].delta = (k == i) ? 0 : cells[k].x - cells[k - 1].x -
+		    XmbTextEscapement(lw->list.fontset, cells[k - 1].string,
+				      cells[k - 1].length);
+	    }
+	    XmbDrawText(dpy, win, cells[i].gc, cells[i].x + str_dx, str_y,
+			items, j - i);
+	    XtFree((char *) items);
+	} else {
+	    XTextItem *items = (XTextItem *) XtMalloc((Cardinal)
+						       ((j - i) * sizeof(XTextItem)));
+
+	    for (k = i; k < j; k++) {
+		items[k - i].chars = cells[k].string;
+		items[k - i].nchars = cells[k].length;
+		items[k - i].font = None;
+		items[k - i].delta = (k == i) ? 0 : cells[k].x - cells[k - 1].x -
+		    XTextWidth(lw->list.font, cells[k - 1].string,
+			       cells[k - 1].length);
+	    }
+	    XDrawText(dpy, win, cells[i].gc, cells[i].x + str_dx, str_y,
+		      items, j - i);
+	    XtFree((char *) items);
+	}
+    }
+    XtFree((char *) rects);
+    XtFree((char *) masked);
 }
 
 /*  PaintItemName()
@@ -581,119 +1400,570 @@ PaintItemName(
 		 Widget w,
 		 int item)
 {
-    char *str;
-    GC gc;
-    int x, y, str_x, str_y, h_x, delta;
-    ListWidget lw = (ListWidget) w;
-    XFontSetExtents *ext = XExtentsOfFontSet(lw->list.fontset);
+    ListCell cell;
 
     if (!XtIsRealized(w))
 	return;			/* Just in case... */
 
+    if (MakeCell(w, item, &cell))
+	PaintCells(w, &cell, 1);
+}
+
+/*	Function Name: ClearItem
+ *	Description: Clears the area of an item, including the spacing
+ *                   around it that its highlighted background covers.
+ *	Arguments: w - the list widget.
+ *                 item - the item.
+ *	Returns: none.
+ */
+
+static void
+ClearItem(
+	     Widget w,
+	     int item)
+{
+    ListWidget lw = (ListWidget) w;
+    int row, col;
+
     if (lw->list.vertical_cols) {
-	x = (lw->list.col_width + lw->list.internal_width) * (item / lw->list.nrows);
-	y = lw->list.row_height * (item % lw->list.nrows) + lw->list.internal_height;
+	row = item % lw->list.nrows;
+	col = item / lw->list.nrows;
     } else {
-	x = (lw->list.col_width + lw->list.internal_width) * (item % lw->list.ncols);
-	y = lw->list.row_height * (item / lw->list.ncols) + lw->list.internal_height;
+	row = item / lw->list.ncols;
+	col = item % lw->list.ncols;
     }
-    /* Determine the string and the icon position */
+    if (!RowInWindow(lw, row))
+	return;
+    XClearArea(XtDisplay(w), XtWindow(w),
+	       (lw->list.col_width + lw->list.internal_width) * col
+	       + lw->list.internal_width - lw->list.column_space / 2,
+	       RowY(lw, row) - lw->list.row_space / 2,
+	       (unsigned) (lw->list.col_width + lw->list.column_space / 2),
+	       (unsigned) lw->list.row_height, FALSE);
+}
 
-    if (lw->list.iconList)
-	str_x = x + lw->list.icon_width + lw->list.internal_width;
-    else
-	str_x = x;
-    h_x = x + lw->list.internal_width;
+/*	Function Name: GetVisible
+ *	Description: Finds the part of the window shown by the parent,
+ *                   which scrolls the list by moving it (Viewport).
+ *	Arguments: w - the list widget.
+ *                 top, height - the visible rows of pixels ** RETURNED **.
+ *	Returns: none.
+ */
 
-    if (lw->simple.international) {
-	delta = (lw->list.row_height - ext->max_ink_extent.height) / 2 - lw->list.internal_height;
-	str_y = y + abs(ext->max_ink_extent.y) + delta;
-    } else {
-	delta = (lw->list.row_height - lw->list.font->max_bounds.ascent -
-		 lw->list.font->max_bounds.descent) / 2 - lw->list.internal_height;
-	str_y = y + lw->list.font->max_bounds.ascent + delta;
+static void
+GetVisible(
+	      Widget w,
+	      int *top,
+	      int *height)
+{
+    *top = -(int) w->core.y;
+    if (*top < 0)
+	*top = 0;
+    *height = (int) XtParent(w)->core.height;
+    if (*top + *height > (int) w->core.height)
+	*height = (int) w->core.height - *top;
+    if (*height < 0)
+	*height = 0;
+}
+
+/*	Function Name: SetShift
+ *	Description: Sets the pixels of a virtual list mapped away above
+ *                   its window.
+ *	Arguments: lw - the list widget.
+ *                 shift - the pixels, limited to those that leave the
+ *                         window filled.
+ *	Returns: none.
+ */
+
+static void
+SetShift(
+	    ListWidget lw,
+	    double shift)
+{
+    double max_shift = lw->list.virtual_height - (double) lw->core.height;
+
+    if (shift > max_shift)
+	shift = max_shift;
+    if (shift < 0.0)
+	shift = 0.0;
+    lw->list.row_offset = (int) (shift / lw->list.row_height);
+    lw->list.pixel_offset = (int) (shift - (double) lw->list.row_offset
+				   * lw->list.row_height);
+}
+
+/*	Function Name: RebaseVirtual
+ *	Description: Moves a long virtual list in its Viewport, so that
+ *                   the scrollbar shows where the visible part is in
+ *                   the whole list, and maps the rows anew so that the
+ *                   given part is visible.
+ *	Arguments: w - the list widget.
+ *                 left - the visible column of pixels.
+ *                 pixel - the first visible row of pixels, counted over
+ *                         all rows.
+ *	Returns: none.
+ *      NOTE:      At least a page of the window is kept above and below
+ *                 the visible part where the list goes on, so that it
+ *                 can be scrolled there pixel by pixel.
+ */
+
+static void
+RebaseVirtual(
+		 Widget w,
+		 int left,
+		 double pixel)
+{
+    ListWidget lw = (ListWidget) w;
+    int top, height, max_top;
+    double window, above, below;
+
+    GetVisible(w, &top, &height);
+    max_top = (int) lw->core.height - height;
+    above = (pixel < height) ? pixel : (double) height;
+    below = lw->list.virtual_height - height - pixel;
+    if (below > height)
+	below = (double) height;
+
+    window = pixel * max_top / (lw->list.virtual_height - height);
+    if (window > max_top - below)
+	window = max_top - below;
+    if (window < above)
+	window = above;
+
+    lw->list.mapped_top = (int) window;
+    SetShift(lw, pixel - lw->list.mapped_top);
+    XawViewportSetCoordinates(XtParent(w), (Position) left,
+			      (Position) lw->list.mapped_top);
+
+    /* In case the Viewport has not moved the list as far */
+
+    GetVisible(w, &top, &height);
+    if (top != lw->list.mapped_top) {
+	lw->list.mapped_top = top;
+	SetShift(lw, pixel - top);
     }
-    /* Paint or erase the highlighted background */
+}
 
-    if (item == lw->list.is_highlighted) {
-	if (item == lw->list.highlight) {
-	    gc = lw->list.revgc;
-	    HighlightBackground(w, h_x, y, lw->list.normgc);
-	} else {
-	    if (XtIsSensitive(w))
-		gc = lw->list.normgc;
+/*	Function Name: SetVirtualOffset
+ *	Description: Maps the rows of a virtual list onto its window.
+ *	Arguments: w - the list widget.
+ *	Returns: TRUE if the mapping has changed.
+ *      NOTE:      If a virtual list is higher than the window, moves
+ *                 of up to a page keep the mapping, so that the list
+ *                 scrolls pixel by pixel. Longer moves, like those of
+ *                 the thumb of a Viewport, take the position of the
+ *                 visible part in the window as the position in the
+ *                 whole list. When a small move gets near the end of
+ *                 the window, the list is moved back by RebaseVirtual().
+ */
+
+static Boolean
+SetVirtualOffset(Widget w)
+{
+    ListWidget lw = (ListWidget) w;
+    int row_offset = lw->list.row_offset;
+    int pixel_offset = lw->list.pixel_offset;
+    int top, height, max_top;
+    double shift;
+
+    GetVisible(w, &top, &height);
+    max_top = (int) lw->core.height - height;
+    shift = (double) row_offset * lw->list.row_height + pixel_offset;
+
+    if ((lw->list.virtual_height <= (double) lw->core.height) || (max_top <= 0))
+	shift = 0.0;
+    else if ((lw->list.mapped_top < 0) ||
+	     (abs(top - lw->list.mapped_top) > height))
+	shift = (double) top * (lw->list.virtual_height - height)
+	    / max_top - top;
+    else if (XtIsSubclass(XtParent(w), viewportWidgetClass) &&
+	     (((top < height) && (shift > 0.0)) ||
+	      ((top > max_top - height) &&
+	       (shift < lw->list.virtual_height - lw->core.height)))) {
+	RebaseVirtual(w, -(int) w->core.x, top + shift);
+	return ((row_offset != lw->list.row_offset) ||
+		(pixel_offset != lw->list.pixel_offset));
+    }
+    lw->list.mapped_top = top;
+    SetShift(lw, shift);
+    return ((row_offset != lw->list.row_offset) ||
+	    (pixel_offset != lw->list.pixel_offset));
+}
+
+/*	Function Name: PaintItems
+ *	Description: Paints the items in a rectangle, without walking
+ *                   through the items outside of it.
+ *	Arguments: w - the list widget.
+ *                 x, y, width, height - the rectangle.
+ *	Returns: none.
+ */
+
+static void
+PaintItems(
+	      Widget w,
+	      int x,
+	      int y,
+	      int width,
+	      int height)
+{
+    ListWidget lw = (ListWidget) w;
+    int row, col, first_row, last_row, first_col, last_col, item, n;
+    int col_step = lw->list.col_width + lw->list.internal_width;
+    ListCell *cells;
+
+    /* One more row and column on each side, because the highlighted
+       background reaches into the spacing around an item. */
+
+    first_row = RowAt(lw, y) - 1;
+    last_row = RowAt(lw, y + height) + 1;
+    first_col = x / col_step - 1;
+    last_col = (x + width) / col_step + 1;
+
+    if (first_row < 0)
+	first_row = 0;
+    if (last_row >= lw->list.nrows)
+	last_row = lw->list.nrows - 1;
+    if (first_col < 0)
+	first_col = 0;
+    if (last_col >= lw->list.ncols)
+	last_col = lw->list.ncols - 1;
+
+    if ((last_row < first_row) || (last_col < first_col))
+	return;
+
+    /* Collect the items row by row and paint them together. The strings
+       of a virtual list are only valid until the next one is fetched. */
+
+    cells = (ListCell *) XtMalloc((Cardinal) ((last_row - first_row + 1)
+					      * (last_col - first_col + 1)
+					      * sizeof(ListCell)));
+    n = 0;
+    for (row = first_row; row <= last_row; row++)
+	for (col = first_col; col <= last_col; col++) {
+	    if (lw->list.vertical_cols)
+		item = col * lw->list.nrows + row;
+	    else
+		item = row * lw->list.ncols + col;
+	    if ((item < lw->list.nitems) && MakeCell(w, item, &cells[n])) {
+		if (lw->list.is_virtual)
+		    cells[n].string = XtNewString(cells[n].string);
+		n++;
+	    }
+	}
+    PaintCells(w, cells, n);
+
+    if (lw->list.is_virtual)
+	while (n > 0)
+	    XtFree(cells[--n].string);
+    XtFree((char *) cells);
+}
+
+/*	Function Name: PaintVisible
+ *	Description: Repaints the visible part of a virtual list.
+ *	Arguments: w - the list widget.
+ *	Returns: none.
+ */
+
+static void
+PaintVisible(Widget w)
+{
+    int top, height;
+
+    GetVisible(w, &top, &height);
+    XClearArea(XtDisplay(w), XtWindow(w), 0, top, w->core.width,
+	       (unsigned) height, FALSE);
+    PaintItems(w, 0, top, (int) w->core.width, height);
+}
+
+/*	Function Name: RepaintFrom
+ *	Description: Repaints the visible items from the given one on,
+ *                   after items have been inserted, deleted or changed.
+ *	Arguments: w - the list widget.
+ *                 item - the first item that has changed.
+ *	Returns: none.
+ */
+
+static void
+RepaintFrom(
+	       Widget w,
+	       int item)
+{
+    ListWidget lw = (ListWidget) w;
+    int top, height, y;
+
+    GetVisible(w, &top, &height);
+
+    /* In column major order with more than one column the items after
+       the change may move into every column: repaint all. */
+
+    if (lw->list.vertical_cols && (lw->list.ncols > 1))
+	y = top;
+    else {
+	y = RowY(lw, item / lw->list.ncols) - lw->list.row_space / 2;
+	if (y < top)
+	    y = top;
+    }
+    if (y >= top + height)
+	return;
+    XClearArea(XtDisplay(w), XtWindow(w), 0, y, w->core.width,
+	       (unsigned) (top + height - y), FALSE);
+    PaintItems(w, 0, y, (int) w->core.width, top + height - y);
+}
+
+/*	Function Name: ReserveSelection
+ *	Description: Makes the selection bitset large enough for all items.
+ *	Arguments: w - the list widget.
+ *	Returns: none.
+ */
+
+static void
+ReserveSelection(Widget w)
+{
+    ListWidget lw = (ListWidget) w;
+    int size = (lw->list.nitems + 8) / 8;
+
+    if (size <= lw->list.selected_size)
+	return;
+    if (size < 2 * lw->list.selected_size)
+	size = 2 * lw->list.selected_size;
+    lw->list.selected = (unsigned char *) XtRealloc((char *) lw->list.selected,
+						    (Cardinal) size);
+    memset(lw->list.selected + lw->list.selected_size, 0,
+	   (size_t) (size - lw->list.selected_size));
+    lw->list.selected_size = size;
+}
+
+/*	Function Name: ForgetSelection
+ *	Description: Clears the selection, when the list is changed.
+ *	Arguments: w - the list widget.
+ *	Returns: none.
+ */
+
+static void
+ForgetSelection(Widget w)
+{
+    ListWidget lw = (ListWidget) w;
+
+    XtFree((char *) lw->list.selected);
+    lw->list.selected = NULL;
+    lw->list.selected_size = 0;
+    lw->list.anchor = NO_HIGHLIGHT;
+}
+
+/*	Function Name: ChangeSelection
+ *	Description: Selects or deselects a range of items.
+ *	Arguments: w - the list widget.
+ *                 first, last - the range of items.
+ *                 value - TRUE to select the items.
+ *	Returns: none.
+ *      NOTE:      Only the visible items that change are repainted,
+ *                 the bits of the others are set a byte at a time.
+ */
+
+static void
+ChangeSelection(
+		   Widget w,
+		   int first,
+		   int last,
+		   Boolean value)
+{
+    ListWidget lw = (ListWidget) w;
+    ListCell cells[64];
+    int i, end, n, top, height, first_row, last_row;
+
+    if (first < 0)
+	first = 0;
+    if (last >= lw->list.nitems)
+	last = lw->list.nitems - 1;
+    if (first > last)
+	return;
+    ReserveSelection(w);
+
+    if (XtIsRealized(w)) {
+	GetVisible(w, &top, &height);
+	first_row = RowAt(lw, top - lw->list.row_height);
+	last_row = RowAt(lw, top + height);
+	i = first;
+	end = last;
+	if (!lw->list.vertical_cols) {
+	    if (i < first_row * lw->list.ncols)
+		i = first_row * lw->list.ncols;
+	    if (end > (last_row + 1) * lw->list.ncols - 1)
+		end = (last_row + 1) * lw->list.ncols - 1;
+	}
+	for (n = 0; i <= end; i++) {
+	    if ((IsSelected(lw, i) != 0) == (value != FALSE))
+		continue;
+	    if (lw->list.vertical_cols &&
+		((i % lw->list.nrows < first_row) || (i % lw->list.nrows > last_row)))
+		continue;
+	    lw->list.selected[i >> 3] ^= (unsigned char) (1 << (i & 7));
+	    if (!MakeCell(w, i, &cells[n]))
+		continue;
+	    if (!value)
+		cells[n].background = lw->list.revgc;
+	    if (lw->list.is_virtual)
+		cells[n].string = XtNewString(cells[n].string);
+	    if (++n == (int) XtNumber(cells)) {
+		PaintCells(w, cells, n);
+		if (lw->list.is_virtual)
+		    while (n > 0)
+			XtFree(cells[--n].string);
+		n = 0;
+	    }
+	}
+	if (n > 0) {
+	    PaintCells(w, cells, n);
+	    if (lw->list.is_virtual)
+		while (n > 0)
+		    XtFree(cells[--n].string);
+	}
+    }
+
+    /* Set the bits of the items that are not visible */
+
+    for (i = first; (i <= last) && (i & 7); i++)
+	if (value)
+	    lw->list.selected[i >> 3] |= (unsigned char) (1 << (i & 7));
+	else
+	    lw->list.selected[i >> 3] &= (unsigned char) ~(1 << (i & 7));
+    if (i + 7 <= last) {
+	memset(lw->list.selected + (i >> 3), value ? 0xff : 0,
+	       (size_t) ((last + 1 - i) >> 3));
+	i += (last + 1 - i) & ~7;
+    }
+    for (; i <= last; i++)
+	if (value)
+	    lw->list.selected[i >> 3] |= (unsigned char) (1 << (i & 7));
+	else
+	    lw->list.selected[i >> 3] &= (unsigned char) ~(1 << (i & 7));
+}
+
+/*	Function Name: SelectOnly
+ *	Description: Selects a range of items and deselects all others.
+ *	Arguments: w - the list widget.
+ *                 first, last - the range of items.
+ *	Returns: none.
+ */
+
+static void
+SelectOnly(
+	      Widget w,
+	      int first,
+	      int last)
+{
+    ListWidget lw = (ListWidget) w;
+
+    ChangeSelection(w, 0, first - 1, FALSE);
+    ChangeSelection(w, last + 1, lw->list.nitems - 1, FALSE);
+    ChangeSelection(w, first, last, TRUE);
+}
+
+/*	Function Name: ShiftSelection
+ *	Description: Moves the selection of the items behind position,
+ *                   when items are inserted or deleted.
+ *	Arguments: w - the list widget.
+ *                 position - where the items are inserted or deleted.
+ *                 count - the number of items inserted, negative if
+ *                         they are deleted.
+ *	Returns: none.
+ *      NOTE:      nitems is the number of items after the change.
+ */
+
+static void
+ShiftSelection(
+		  Widget w,
+		  int position,
+		  int count)
+{
+    ListWidget lw = (ListWidget) w;
+    int i, from, old_nitems = lw->list.nitems - count;
+
+    if (lw->list.selected == NULL)
+	return;
+    ReserveSelection(w);
+
+    if (count > 0) {
+	for (i = lw->list.nitems - 1; i >= position; i--) {
+	    from = i - count;
+	    if ((from >= position) && IsSelected(lw, from))
+		lw->list.selected[i >> 3] |= (unsigned char) (1 << (i & 7));
 	    else
-		gc = lw->list.graygc;
-	    HighlightBackground(w, h_x, y, lw->list.revgc);
-	    lw->list.is_highlighted = NO_HIGHLIGHT;
+		lw->list.selected[i >> 3] &= (unsigned char) ~(1 << (i & 7));
 	}
     } else {
-	if (item == lw->list.highlight) {
-	    gc = lw->list.revgc;
-	    HighlightBackground(w, h_x, y, lw->list.normgc);
-	    lw->list.is_highlighted = item;
-	} else {
-	    if (XtIsSensitive(w))
-		gc = lw->list.normgc;
+	for (i = position; i < old_nitems; i++) {
+	    from = i - count;
+	    if ((from < old_nitems) && IsSelected(lw, from))
+		lw->list.selected[i >> 3] |= (unsigned char) (1 << (i & 7));
 	    else
-		gc = lw->list.graygc;
+		lw->list.selected[i >> 3] &= (unsigned char) ~(1 << (i & 7));
 	}
     }
-    /*  Paint the icon if there is one. The icon will only be painted, if
-       width and height are greater than 0 and if an icon is defined for
-       this entry. The depth of the icon has to be 1 (normal bitmap)
-       or of the same color depth as your display */
-
-    if ((lw->list.iconList) &&
-	(lw->list.icon_width > 0) && (lw->list.icon_height > 0)) {
-	x += lw->list.column_space / 2;
-	if (lw->list.iconList[item].bitmap != XtUnspecifiedPixmap)
-	    if (lw->list.icon_depth == 1)
-		XCopyPlane(XtDisplay(w), lw->list.iconList[item].bitmap,
-			   XtWindow(w),
-			   lw->list.normgc, 0, 0, lw->list.icon_width,
-			   lw->list.icon_height, x, y, 1L);
-	    else if (lw->list.iconList[item].clipMask != XtUnspecifiedPixmap) {
-		/* Support of a clip mask for non rectangular or transparent
-		 * pixmaps: Manipulate the GC with a clip mask
-		 */
-		XSetClipMask(XtDisplay(w), lw->list.iconGc,
-			     lw->list.iconList[item].clipMask);
-		XSetClipOrigin(XtDisplay(w), lw->list.iconGc, x, y);
-		XCopyArea(XtDisplay(w), lw->list.iconList[item].bitmap,
-			  XtWindow(w),
-			  lw->list.iconGc, 0, 0, lw->list.icon_width,
-			  lw->list.icon_height, x, y);
-	    } else
-		XCopyArea(XtDisplay(w), lw->list.iconList[item].bitmap,
-			  XtWindow(w),
-			  lw->list.normgc, 0, 0, lw->list.icon_width,
-			  lw->list.icon_height, x, y);
+
+    if (lw->list.anchor >= position) {
+	if (count > 0)
+	    lw->list.anchor += count;
+	else if (lw->list.anchor >= position - count)
+	    lw->list.anchor += count;
 	else
-	    XClearArea(XtDisplay(w), XtWindow(w), x, y,
-		       lw->list.icon_width, lw->list.icon_height, FALSE);
+	    lw->list.anchor = NO_HIGHLIGHT;
     }
-    /* List's overall width contains the same number of inter-column
-       column_space's as columns.  There should thus be a half
-       column_width margin on each side of each column.
-       The row case is symmetric. */
+}
 
-    str_x += lw->list.column_space / 2;
-    str_y += lw->list.row_space / 2;
+/*	Function Name: ItemsChanged
+ *	Description: Lays out the list again and repaints the visible
+ *                   items that have changed, after the items from first
+ *                   on have been inserted, deleted or changed.
+ *	Arguments: w - the list widget.
+ *                 first - the first item that has changed.
+ *	Returns: none.
+ *      NOTE:      Unlike ResetList(), it relies on nitems and longest
+ *                 being up to date.
+ */
 
-    /* Draw the String */
+static void
+ItemsChanged(
+		Widget w,
+		int first)
+{
+    ListWidget lw = (ListWidget) w;
+    Dimension width = w->core.width;
+    Dimension height = w->core.height;
+    int col_width = lw->list.col_width;
 
-    if (lw->list.iconList)
-	str = DeConst(lw->list.iconList[item].string);
-    else
-	str = DeConst(lw->list.list[item]);
+    lw->list.col_width = lw->list.longest + lw->list.column_space;
+    if (UsesIcons(lw))
+	lw->list.col_width += lw->list.icon_width;
+    if (Layout(w, WidthFree(w), HeightFree(w), &width, &height))
+	ChangeSize(w, width, height);
 
-    if (lw->simple.international)
-	XmbDrawString(XtDisplay(w), XtWindow(w), lw->list.fontset,
-		      gc, str_x, str_y, str, (int) strlen(str));
-    else
-	XDrawString(XtDisplay(w), XtWindow(w), gc, str_x, str_y, str, (int)
-		    strlen(str));
+    if (!XtIsRealized(w))
+	return;
+    if ((lw->list.col_width != col_width) ||
+	(lw->list.is_virtual && SetVirtualOffset(w)))
+	first = 0;
+    RepaintFrom(w, first);
+}
+
+/*	Function Name: VirtualMoved
+ *	Description: Event handler, remaps a virtual list when it has been
+ *                   moved by its parent.
+ *	Arguments: w - the list widget.
+ *                 event - the ConfigureNotify event.
+ *	Returns: none.
+ */
+
+/* ARGSUSED */
+static void
+VirtualMoved(
+		Widget w,
+		XtPointer closure GCC_UNUSED,
+		XEvent *event,
+		Boolean *cont GCC_UNUSED)
+{
+    if ((event->type == ConfigureNotify) && IsVirtual(w) &&
+	XtIsRealized(w) && SetVirtualOffset(w))
+	PaintVisible(w);
 }
 
 /* Redisplay()
@@ -710,20 +1980,30 @@ Redisplay(
 	     XEvent *event,
 	     Region junk GCC_UNUSED)
 {
-    int item;			/* an item to work with. */
-    int ul_item, lr_item;	/* corners of items we need to paint. */
     ListWidget lw = (ListWidget) w;
+    int top, height;
+
+    /* A virtual list only paints what is exposed, or what is visible. */
+
+    if (lw->list.is_virtual) {
+	if (SetVirtualOffset(w) || (event == NULL))
+	    PaintVisible(w);
+	else
+	    PaintItems(w, event->xexpose.x, event->xexpose.y,
+		       event->xexpose.width, event->xexpose.height);
+	return;
+    }
+
+    /* Repainting all paints the visible part: the rest of the window
+       gets exposed when it is scrolled into view. */
 
-    if (event == NULL) {	/* repaint all. */
-	ul_item = 0;
-	lr_item = lw->list.nrows * lw->list.ncols - 1;
+    if (event == NULL) {
 	XClearWindow(XtDisplay(w), XtWindow(w));
+	GetVisible(w, &top, &height);
+	PaintItems(w, 0, top, (int) w->core.width, height);
     } else
-	FindCornerItems(w, event, &ul_item, &lr_item);
-
-    for (item = ul_item; (item <= lr_item && item < lw->list.nitems); item++)
-	if (ItemInRectangle(w, ul_item, lr_item, item))
-	    PaintItemName(w, item);
+	PaintItems(w, event->xexpose.x, event->xexpose.y,
+		   event->xexpose.width, event->xexpose.height);
 }
 
 /* PreferredGeom()
@@ -794,6 +2074,52 @@ Resize(Widget w)
 		     "List Widget: Size changed when it shouldn't have when resising.");
 }
 
+/* VirtualLayout()
+ *
+ * lays out a virtual list, see Layout(). The list always grows downwards:
+ * the number of columns is taken from default_cols if the width is free,
+ * else from the width. Its height is limited to MaxListHeight, the height
+ * of all rows is kept in virtual_height for SetVirtualOffset().
+ *
+ * RETURNS: TRUE if width or height have been changed. */
+
+static Boolean
+VirtualLayout(
+		 Widget w,
+		 Boolean xfree,
+		 Boolean yfree,
+		 Dimension *width,
+		 Dimension *height)
+{
+    ListWidget lw = (ListWidget) w;
+    Boolean change = FALSE;
+
+    if (lw->list.force_cols || xfree)
+	lw->list.ncols = lw->list.default_cols;
+    else
+	lw->list.ncols = ((int) (*width - 2 * lw->list.internal_width)
+			  / (int) lw->list.col_width);
+    if (lw->list.ncols <= 0)
+	lw->list.ncols = 1;
+    lw->list.nrows = ((lw->list.nitems - 1) / lw->list.ncols) + 1;
+
+    if (xfree) {
+	*width = (Dimension) ((lw->list.ncols * lw->list.col_width)
+			      + 2 * lw->list.internal_width);
+	change = TRUE;
+    }
+    lw->list.virtual_height = (double) lw->list.nrows * lw->list.row_height
+	+ 2 * lw->list.internal_height;
+    if (yfree) {
+	if (lw->list.virtual_height > MaxListHeight)
+	    *height = MaxListHeight;
+	else
+	    *height = (Dimension) lw->list.virtual_height;
+	change = TRUE;
+    }
+    return (change);
+}
+
 /* Layout()
  *
  * lays out the item in the list.
@@ -817,6 +2143,9 @@ Layout(
     ListWidget lw = (ListWidget) w;
     Boolean change = FALSE;
 
+    if (lw->list.is_virtual)
+	return (VirtualLayout(w, xfree, yfree, width, height));
+
 /*
  * If force columns is set then always use number of columns specified
  * by default_cols.
@@ -902,7 +2231,9 @@ Layout(
  *
  * Notifies the user that a button has been pressed, and
  * calls the callback; if the XtNpasteBuffer resource is true
- * then the name of the item is also put in CUT_BUFFER0.	*/
+ * then the name of the item is also put in CUT_BUFFER0. In a
+ * multiSelect list the callback is called once for the gesture
+ * that changed the selection, with the item last clicked. */
 
 /* ARGSUSED */
 static void
@@ -916,6 +2247,7 @@ Notify(
     int item;
     char *str;
     XawListReturnStruct ret_value;
+    XawListFetchStruct entry;
 
 /*
  * Find item and if out of range then unhighlight and return.
@@ -927,14 +2259,14 @@ Notify(
     if (((CvtToItem(w, event->xbutton.x, event->xbutton.y, &item)) ==
 	OUT_OF_RANGE) ||
 	(lw->list.highlight != item)) {
-	XawListUnhighlight(w);
+	if (!lw->list.multi_select)
+	    XawListUnhighlight(w);
 	return;
     }
     /* if XtNpasteBuffer is set then paste it. */
 
-    str = DeConst(lw->list.iconList
-		  ? lw->list.iconList[item].string
-		  : lw->list.list[item]);
+    GetItem(w, item, &entry);
+    str = entry.string;
     if (lw->list.paste)
 	XStoreBytes(XtDisplay(w), str, (int) strlen(str));
 
@@ -978,10 +2310,187 @@ Set(
     if ((CvtToItem(w, event->xbutton.x, event->xbutton.y, &item))
 	== OUT_OF_RANGE)
 	XawListUnhighlight(w);	/* Unhighlight current item. */
+    else if (lw->list.multi_select)
+	XawListHighlight(w, item);	/* Select this one only. */
     else if (lw->list.is_highlighted != item)	/* If this item is not */
 	XawListHighlight(w, item);	/* highlighted then do it. */
 }
 
+/* Extend() - ACTION
+ *
+ * Selects the items from the anchor, the item last set or toggled,
+ * to the current element in a multiSelect list, and only these.
+ * Works like Set() in other lists. */
+
+/* ARGSUSED */
+static void
+Extend(
+	  Widget w,
+	  XEvent *event,
+	  String *params,
+	  Cardinal *num_params)
+{
+    int item;
+    ListWidget lw = (ListWidget) w;
+
+    if (!lw->list.multi_select || (lw->list.anchor == NO_HIGHLIGHT)) {
+	Set(w, event, params, num_params);
+	return;
+    }
+    if (((CvtToItem(w, event->xbutton.x, event->xbutton.y, &item))
+	 == OUT_OF_RANGE) || !XtIsSensitive(w))
+	return;
+    if (item < lw->list.anchor)
+	SelectOnly(w, item, lw->list.anchor);
+    else
+	SelectOnly(w, lw->list.anchor, item);
+    lw->list.highlight = item;
+}
+
+/* Toggle() - ACTION
+ *
+ * Selects the current element of a multiSelect list, or deselects
+ * it if it is selected, and leaves the other items alone. Works like
+ * Set() in other lists. */
+
+/* ARGSUSED */
+static void
+Toggle(
+	  Widget w,
+	  XEvent *event,
+	  String *params,
+	  Cardinal *num_params)
+{
+    int item;
+    ListWidget lw = (ListWidget) w;
+
+    if (!lw->list.multi_select) {
+	Set(w, event, params, num_params);
+	return;
+    }
+    if (((CvtToItem(w, event->xbutton.x, event->xbutton.y, &item))
+	 == OUT_OF_RANGE) || !XtIsSensitive(w))
+	return;
+    ChangeSelection(w, item, item, !IsSelected(lw, item));
+    lw->list.anchor = lw->list.highlight = item;
+}
+
+/*	Function Name: ShowItem
+ *	Description: Scrolls an item into view, if the list is in a
+ *                   Viewport.
+ *	Arguments: w - the list widget.
+ *                 item - the item.
+ *	Returns: none.
+ *      NOTE:      If the item of a long virtual list is not mapped
+ *                 into its window, the rows are mapped anew.
+ */
+
+static void
+ShowItem(
+	    Widget w,
+	    int item)
+{
+    ListWidget lw = (ListWidget) w;
+    Widget clip;
+    int x, y, left, top;
+
+    if (!XtIsSubclass(XtParent(w), viewportWidgetClass))
+	return;
+    clip = ((ViewportWidget) XtParent(w))->viewport.clip;
+
+    if (lw->list.vertical_cols) {
+	x = (lw->list.col_width + lw->list.internal_width) * (item / lw->list.nrows);
+	y = RowY(lw, item % lw->list.nrows);
+    } else {
+	x = (lw->list.col_width + lw->list.internal_width) * (item % lw->list.ncols);
+	y = RowY(lw, item / lw->list.ncols);
+    }
+    left = -(int) lw->core.x;
+    top = -(int) lw->core.y;
+
+    if (x + lw->list.col_width > left + (int) clip->core.width)
+	left = x + lw->list.col_width - (int) clip->core.width;
+    if (x < left)
+	left = x;
+    if (y + lw->list.row_height > top + (int) clip->core.height)
+	top = y + lw->list.row_height - (int) clip->core.height;
+    if (y < top)
+	top = y;
+
+    if (lw->list.is_virtual) {
+	if ((top < 0) || (top > (int) lw->core.height - (int) clip->core.height)) {
+	    RebaseVirtual(w, left, (double) top + (double) lw->list.row_offset
+			  * lw->list.row_height + lw->list.pixel_offset);
+	    if (XtIsRealized(w))
+		PaintVisible(w);
+	    return;
+	}
+	lw->list.mapped_top = top;	/* keep the mapping */
+    }
+    if ((left != -(int) lw->core.x) || (top != -(int) lw->core.y))
+	XawViewportSetCoordinates(XtParent(w), (Position) left, (Position) top);
+}
+
+/* Search() - ACTION
+ *
+ * Type-ahead: adds the typed character to the prefix searched for,
+ * highlights the first item (in sort order) that starts with it and
+ * scrolls it into view. BackSpace takes the last character back,
+ * Escape or a pause of SearchTimeout milliseconds starts anew. Does
+ * nothing unless typeAhead is set. */
+
+/* ARGSUSED */
+static void
+Search(
+	  Widget w,
+	  XEvent *event,
+	  String *params GCC_UNUSED,
+	  Cardinal *num_params GCC_UNUSED)
+{
+    ListWidget lw = (ListWidget) w;
+    char buf[32];
+    KeySym keysym;
+    int n, item;
+
+    if ((event->type != KeyPress) || !lw->list.type_ahead)
+	return;
+    n = XLookupString(&event->xkey, buf, (int) sizeof(buf), &keysym, NULL);
+
+    if (event->xkey.time - lw->list.prefix_time > SearchTimeout)
+	lw->list.prefix_length = 0;
+    lw->list.prefix_time = event->xkey.time;
+
+    if (keysym == XK_Escape) {
+	lw->list.prefix_length = 0;
+	return;
+    }
+    if ((keysym == XK_BackSpace) || (keysym == XK_Delete)) {
+	if (lw->list.prefix_length > 0)
+	    lw->list.prefix_length--;
+	if (lw->list.prefix_length == 0)
+	    return;
+	n = 0;
+    } else if ((n <= 0) || iscntrl((unsigned char) buf[0]))
+	return;			/* Modifiers, Return, ... */
+
+    if (lw->list.prefix_length + n + 1 > lw->list.prefix_size) {
+	lw->list.prefix_size = 2 * (lw->list.prefix_length + n + 1);
+	lw->list.prefix = XtRealloc(lw->list.prefix, (Cardinal) lw->list.prefix_size);
+    }
+    memcpy(lw->list.prefix + lw->list.prefix_length, buf, (size_t) n);
+    lw->list.prefix[lw->list.prefix_length + n] = '\0';
+
+    if ((item = XawListFindPrefix(w, lw->list.prefix)) == XAW_LIST_NONE) {
+	XBell(XtDisplay(w), 0);
+	lw->list.prefix[lw->list.prefix_length] = '\0';
+	return;
+    }
+    lw->list.prefix_length += n;
+    if (lw->list.highlight != item)
+	XawListHighlight(w, item);
+    ShowItem(w, item);
+}
+
 /*
  * Set specified arguments into widget
  */
@@ -1001,6 +2510,8 @@ SetValues(
     int text_height;
     XFontSetExtents *ext = XExtentsOfFontSet(nl->list.fontset);
 
+    nl->list.is_virtual = (XtHasCallbacks(new, XtNfetchCallback) == XtCallbackHasSome);
+
     /* If the request height/width is different, lock it.  Unless its 0. If */
     /* neither new nor 0, leave it as it was.  Not in R5. */
 
@@ -1031,6 +2542,7 @@ SetValues(
 	XtReleaseGC(current, cl->list.revgc);
 	XtReleaseGC(current, cl->list.normgc);
 	GetGCs(new);
+	ForgetAtlas(new);
 	redraw = TRUE;
     }
     /* Reset row height. */
@@ -1063,8 +2575,11 @@ SetValues(
 	(cl->list.iconList != nl->list.iconList) ||
 	((cl->list.list != nl->list.list) && (nl->list.iconList == NULL)) ||
 	((cl->list.icon_height != nl->list.icon_height) &&
-	nl->list.iconList) ||
-	((cl->list.icon_width != nl->list.icon_width) && nl->list.iconList) ||
+	UsesIcons(nl)) ||
+	((cl->list.icon_width != nl->list.icon_width) && UsesIcons(nl)) ||
+	(cl->list.is_virtual != nl->list.is_virtual) ||
+	((cl->list.longest_sample != nl->list.longest_sample) &&
+	nl->list.is_virtual) ||
 	(cl->list.internal_width != nl->list.internal_width) ||
 	(cl->list.internal_height != nl->list.internal_height) ||
 	(cl->list.column_space != nl->list.column_space) ||
@@ -1087,9 +2602,26 @@ SetValues(
 	redraw = TRUE;
     }
 
-    if ((cl->list.list != nl->list.list) || (cl->list.iconList != nl->list.iconList))
+    if ((cl->list.list != nl->list.list) || (cl->list.iconList != nl->list.iconList) ||
+	(cl->list.is_virtual != nl->list.is_virtual) ||
+	(nl->list.highlight >= nl->list.nitems))
 	nl->list.is_highlighted = nl->list.highlight = NO_HIGHLIGHT;
 
+    if ((cl->list.list != nl->list.list) || (cl->list.iconList != nl->list.iconList) ||
+	(cl->list.is_virtual != nl->list.is_virtual) ||
+	(cl->list.multi_select != nl->list.multi_select)) {
+	ForgetSelection(new);
+	nl->list.is_highlighted = nl->list.highlight = NO_HIGHLIGHT;
+	redraw = TRUE;
+    } else if ((cl->list.nitems != nl->list.nitems) &&
+	       (nl->list.selected != NULL))
+	ReserveSelection(new);	/* numberStrings changed, the list did not. */
+
+    if (cl->list.case_sensitive != nl->list.case_sensitive)
+	ForgetSorted(new);
+
+    InstallTranslations(new, current);
+
     if ((cl->core.sensitive != nl->core.sensitive) ||
 	(cl->core.ancestor_sensitive != nl->core.ancestor_sensitive)) {
 	nl->list.highlight = NO_HIGHLIGHT;
@@ -1114,6 +2646,11 @@ Destroy(
     XtReleaseGC(w, lw->list.revgc);
     XtReleaseGC(w, lw->list.normgc);
     XtReleaseGC(w, lw->list.iconGc);
+    ForgetWidths(w);
+    ForgetAtlas(w);
+    ForgetSorted(w);
+    ForgetSelection(w);
+    XtFree(lw->list.prefix);
 }
 
 /* Exported Functions */
@@ -1130,6 +2667,8 @@ Destroy(
  *	Returns: none.
  *      NOTE:      If nitems of longest are <= 0 then they will be calculated.
  *                 If nitems is <= 0 then the list needs to be NULL terminated.
+ *                 A virtual list does not use list, nitems is the new
+ *                 number of items.
  */
 
 void
@@ -1168,6 +2707,7 @@ XawListChange(
 
     ResetList(w, WidthFree(w), HeightFree(w));
     lw->list.is_highlighted = lw->list.highlight = NO_HIGHLIGHT;
+    ForgetSelection(w);
     if (XtIsRealized(w))
 	Redisplay(w, (XEvent *) NULL, (Region) NULL);
 }
@@ -1240,10 +2780,243 @@ XawIconListChange(
 
     ResetList(w, WidthFree(w), HeightFree(w));
     lw->list.is_highlighted = lw->list.highlight = NO_HIGHLIGHT;
+    ForgetSelection(w);
     if (XtIsRealized(w))
 	Redisplay(w, (XEvent *) NULL, (Region) NULL);
 }
 
+/*	Function Name: InsertItems
+ *	Description: Takes note of items inserted into the list.
+ *	Arguments: w - the list widget.
+ *                 position - where the items have been inserted.
+ *                 count - the number of items.
+ *	Returns: none.
+ */
+
+static void
+InsertItems(
+	       Widget w,
+	       int position,
+	       int count)
+{
+    ListWidget lw = (ListWidget) w;
+
+    if (position < 0)
+	position = 0;
+    if (position > lw->list.nitems)
+	position = lw->list.nitems;
+    if (count <= 0)
+	return;
+    lw->list.nitems += count;
+    ForgetIcons(w, position, count);
+
+    /* Make room for the widths of the new items and measure them */
+
+    if (lw->list.widths) {
+	if (lw->list.nitems > lw->list.widths_size) {
+	    lw->list.widths_size = 2 * lw->list.nitems;
+	    lw->list.widths = (Dimension *) XtRealloc((char *) lw->list.widths,
+						      (Cardinal)
+						      (lw->list.widths_size * sizeof(Dimension)));
+	}
+	memmove(lw->list.widths + position + count, lw->list.widths + position,
+		(size_t) (lw->list.nitems - count - position) * sizeof(Dimension));
+	MeasureItems(w, position, count);
+    }
+    if (lw->list.highlight >= position)
+	lw->list.highlight += count;
+    if (lw->list.is_highlighted >= position)
+	lw->list.is_highlighted += count;
+    ShiftSelection(w, position, count);
+
+    ForgetSorted(w);
+    ItemsChanged(w, position);
+}
+
+/*	Function Name: DeleteItems
+ *	Description: Takes note of items deleted from the list.
+ *	Arguments: w - the list widget.
+ *                 position - where the items have been deleted.
+ *                 count - the number of items.
+ *	Returns: none.
+ */
+
+static void
+DeleteItems(
+	       Widget w,
+	       int position,
+	       int count)
+{
+    ListWidget lw = (ListWidget) w;
+    int i;
+
+    if (position < 0)
+	position = 0;
+    if (count > lw->list.nitems - position)
+	count = lw->list.nitems - position;
+    if (count <= 0)
+	return;
+
+    if (lw->list.widths) {
+	for (i = position; i < position + count; i++)
+	    CountWidth(w, lw->list.widths[i], -1);
+	memmove(lw->list.widths + position, lw->list.widths + position + count,
+		(size_t) (lw->list.nitems - count - position) * sizeof(Dimension));
+    }
+    lw->list.nitems -= count;
+
+    if (lw->list.highlight >= position + count)
+	lw->list.highlight -= count;
+    else if (lw->list.highlight >= position)
+	lw->list.highlight = NO_HIGHLIGHT;
+    if (lw->list.is_highlighted >= position + count)
+	lw->list.is_highlighted -= count;
+    else if (lw->list.is_highlighted >= position)
+	lw->list.is_highlighted = NO_HIGHLIGHT;
+    ShiftSelection(w, position, -count);
+
+    /* The icons of the deleted items are not known any more, and their
+       pixmaps may be freed: paint the icons shown again */
+
+    ForgetAtlas(w);
+    ForgetSorted(w);
+    ItemsChanged(w, position);
+}
+
+/*	Function Name: XawListInsertItems
+ *	Description: Shows items inserted into the list.
+ *	Arguments: w - the list widget.
+ *                 list - the list, with the new items.
+ *                 position - the index of the first new item.
+ *                 count - the number of new items.
+ *	Returns: none.
+ *      NOTE:      Only the new items are measured and only the items
+ *                 from position on are repainted. A virtual list does
+ *                 not use list and keeps its estimate of longest.
+ */
+
+void
+XawListInsertItems(
+		      Widget w,
+		      String *list,
+		      int position,
+		      int count)
+{
+    ListWidget lw = (ListWidget) w;
+
+    lw->list.list = list;
+    lw->list.iconList = NULL;	/* To avoid the use of an iconList */
+    InsertItems(w, position, count);
+}
+
+/*	Function Name: XawListDeleteItems
+ *	Description: Shows that items have been deleted from the list.
+ *	Arguments: w - the list widget.
+ *                 list - the list, without the deleted items.
+ *                 position - the index of the first deleted item.
+ *                 count - the number of deleted items.
+ *	Returns: none.
+ *      NOTE:      The longest item is found without measuring the
+ *                 remaining items again.
+ */
+
+void
+XawListDeleteItems(
+		      Widget w,
+		      String *list,
+		      int position,
+		      int count)
+{
+    ListWidget lw = (ListWidget) w;
+
+    lw->list.list = list;
+    lw->list.iconList = NULL;	/* To avoid the use of an iconList */
+    DeleteItems(w, position, count);
+}
+
+/*	Function Name: XawIconListInsertItems
+ *	Description: Shows items inserted into the ICONLIST.
+ *	Arguments: w - the list widget.
+ *                 iconlist - the list, with the new items.
+ *                 position - the index of the first new item.
+ *                 count - the number of new items.
+ *	Returns: none.
+ */
+
+void
+XawIconListInsertItems(
+			  Widget w,
+			  XawIconList * iconlist,
+			  int position,
+			  int count)
+{
+    ListWidget lw = (ListWidget) w;
+
+    lw->list.iconList = iconlist;
+    lw->list.list = NULL;
+    InsertItems(w, position, count);
+}
+
+/*	Function Name: XawIconListDeleteItems
+ *	Description: Shows that items have been deleted from the ICONLIST.
+ *	Arguments: w - the list widget.
+ *                 iconlist - the list, without the deleted items.
+ *                 position - the index of the first deleted item.
+ *                 count - the number of deleted items.
+ *	Returns: none.
+ */
+
+void
+XawIconListDeleteItems(
+			  Widget w,
+			  XawIconList * iconlist,
+			  int position,
+			  int count)
+{
+    ListWidget lw = (ListWidget) w;
+
+    lw->list.iconList = iconlist;
+    lw->list.list = NULL;
+    DeleteItems(w, position, count);
+}
+
+/*	Function Name: XawListUpdateItem
+ *	Description: Shows an item that has been changed in place.
+ *	Arguments: w - the list widget.
+ *                 item - the index of the item.
+ *	Returns: none.
+ */
+
+void
+XawListUpdateItem(
+		     Widget w,
+		     int item)
+{
+    ListWidget lw = (ListWidget) w;
+    int old_width;
+
+    if ((item < 0) || (item >= lw->list.nitems))
+	return;
+    ForgetSorted(w);
+    ForgetIcons(w, item, 1);
+
+    /* Count the new width in before the old one is counted out, so
+       that longest is not searched for if it does not shrink. */
+
+    if (lw->list.widths) {
+	old_width = lw->list.widths[item];
+	MeasureItems(w, item, 1);
+	CountWidth(w, old_width, -1);
+    }
+    if (lw->list.longest + lw->list.column_space
+	+ (UsesIcons(lw) ? lw->list.icon_width : 0) != lw->list.col_width)
+	ItemsChanged(w, 0);
+    else if (XtIsRealized(w)) {
+	ClearItem(w, item);
+	PaintItemName(w, item);
+    }
+}
+
 /*	Function Name: XawListUnhighlight
  *	Description: unlights the current highlighted element.
  *	Arguments: w - the widget.
@@ -1257,7 +3030,9 @@ XawListUnhighlight(
     ListWidget lw = (ListWidget) w;
 
     lw->list.highlight = NO_HIGHLIGHT;
-    if (lw->list.is_highlighted != NO_HIGHLIGHT)
+    if (lw->list.multi_select)
+	ChangeSelection(w, 0, lw->list.nitems - 1, FALSE);
+    else if (lw->list.is_highlighted != NO_HIGHLIGHT)
 	PaintItemName(w, lw->list.is_highlighted);	/* unhighlight this one. */
 }
 
@@ -1275,7 +3050,12 @@ XawListHighlight(
 {
     ListWidget lw = (ListWidget) w;
 
-    if (XtIsSensitive(w)) {
+    if (XtIsSensitive(w) && lw->list.multi_select) {
+	if ((item < 0) || (item >= lw->list.nitems))
+	    return;
+	SelectOnly(w, item, item);
+	lw->list.anchor = lw->list.highlight = item;
+    } else if (XtIsSensitive(w)) {
 	lw->list.highlight = item;
 	if (lw->list.is_highlighted != NO_HIGHLIGHT)
 	    PaintItemName(w, lw->list.is_highlighted);	/* Unhighlight. */
@@ -1294,6 +3074,7 @@ XawListShowCurrent(Widget w)
 {
     ListWidget lw = (ListWidget) w;
     XawListReturnStruct *ret_val;
+    XawListFetchStruct entry;
 
     ret_val = (XawListReturnStruct *) XtMalloc(sizeof(XawListReturnStruct));
 
@@ -1303,10 +3084,171 @@ XawListShowCurrent(Widget w)
 	ret_val->list_index = lw->list.highlight;
 	if (ret_val->list_index == XAW_LIST_NONE)
 	    ret_val->string = "";
-	else
-	    ret_val->string = lw->list.iconList ?
-		lw->list.iconList[ret_val->list_index].string
-		: lw->list.list[ret_val->list_index];
+	else {
+	    GetItem(w, ret_val->list_index, &entry);
+	    ret_val->string = entry.string;
+	}
     }
     return (ret_val);
 }
+
+/*	Function Name: XawListShowItem
+ *	Description: Scrolls an item into view.
+ *	Arguments: w - the list widget.
+ *                 item - the item.
+ *	Returns: none.
+ */
+
+void
+XawListShowItem(
+		   Widget w,
+		   int item)
+{
+    if ((item >= 0) && (item < ((ListWidget) w)->list.nitems))
+	ShowItem(w, item);
+}
+
+/*	Function Name: XawListFindPrefix
+ *	Description: Finds an item that starts with a prefix.
+ *	Arguments: w - the list widget.
+ *                 prefix - the prefix.
+ *	Returns: the first item starting with prefix in sort order, or
+ *               XAW_LIST_NONE.
+ *      NOTE:      The items are sorted once, the index is kept until
+ *                 the list changes, so a search takes O(log n) string
+ *                 comparisons. Virtual lists are not searched.
+ */
+
+int
+XawListFindPrefix(
+		     Widget w,
+		     String prefix)
+{
+    ListWidget lw = (ListWidget) w;
+    XawListFetchStruct entry;
+    size_t length = strlen(prefix);
+    int low = 0, high = lw->list.nitems, mid;
+
+    if (lw->list.is_virtual || (lw->list.nitems <= 0))
+	return (XAW_LIST_NONE);
+    if (lw->list.sorted == NULL)
+	SortItems(w);
+
+    /* Find the first item not sorted before prefix */
+
+    while (low < high) {
+	mid = low + (high - low) / 2;
+	GetItem(w, lw->list.sorted[mid], &entry);
+	if (CompareText(lw, entry.string, prefix, length) < 0)
+	    low = mid + 1;
+	else
+	    high = mid;
+    }
+    if (low == lw->list.nitems)
+	return (XAW_LIST_NONE);
+    GetItem(w, lw->list.sorted[low], &entry);
+    if (CompareText(lw, entry.string, prefix, length) != 0)
+	return (XAW_LIST_NONE);
+    return (lw->list.sorted[low]);
+}
+
+/*	Function Name: XawListSelectRange
+ *	Description: Selects or deselects a range of items of a multiSelect
+ *                   list.
+ *	Arguments: w - the list widget.
+ *                 first, last - the range of items.
+ *                 select - TRUE to select the items.
+ *	Returns: none.
+ *      NOTE:      Only the visible items that change are repainted.
+ */
+
+void
+XawListSelectRange(
+		      Widget w,
+		      int first,
+		      int last,
+		      Boolean select)
+{
+    ListWidget lw = (ListWidget) w;
+
+    if (lw->list.multi_select)
+	ChangeSelection(w, first, last, select);
+}
+
+/*	Function Name: XawListIsSelected
+ *	Description: Tells if an item is selected.
+ *	Arguments: w - the list widget.
+ *                 item - the item.
+ *	Returns: TRUE if the item is selected, or highlighted if the
+ *               list is not a multiSelect list.
+ */
+
+Boolean
+XawListIsSelected(
+		     Widget w,
+		     int item)
+{
+    ListWidget lw = (ListWidget) w;
+
+    if ((item < 0) || (item >= lw->list.nitems))
+	return (FALSE);
+    if (!lw->list.multi_select)
+	return (item == lw->list.highlight);
+    return (IsSelected(lw, item) != 0);
+}
+
+/*	Function Name: XawListGetSelectedRanges
+ *	Description: Gets the selected items as ranges of items.
+ *	Arguments: w - the list widget.
+ *                 ranges - the ranges ** RETURNED **, may be NULL.
+ *                 max - the number of ranges that fit into ranges.
+ *	Returns: the number of ranges, which may be more than max.
+ *      NOTE:      Bytes of the bitset with no or all items selected
+ *                 are skipped as a whole.
+ */
+
+int
+XawListGetSelectedRanges(
+			    Widget w,
+			    XawListRange * ranges,
+			    int max)
+{
+    ListWidget lw = (ListWidget) w;
+    int i = 0, first, n = 0;
+
+    if (!lw->list.multi_select) {
+	if (lw->list.highlight == NO_HIGHLIGHT)
+	    return (0);
+	if ((ranges != NULL) && (max > 0))
+	    ranges[0].first = ranges[0].last = lw->list.highlight;
+	return (1);
+    }
+    if (lw->list.selected == NULL)
+	return (0);
+    while (i < lw->list.nitems) {
+	if (!(i & 7) && ((i >> 3) < lw->list.selected_size) &&
+	    (lw->list.selected[i >> 3] == 0)) {
+	    i += 8;
+	    continue;
+	}
+	if (!IsSelected(lw, i)) {
+	    i++;
+	    continue;
+	}
+	for (first = i; i < lw->list.nitems;)
+	    if (!(i & 7) && (i + 8 <= lw->list.nitems) &&
+		((i >> 3) < lw->list.selected_size) &&
+		(lw->list.selected[i >> 3] == 0xff))
+		i += 8;
+	    else if (IsSelected(lw, i))
+		i++;
+	    else
+		break;
+	if ((ranges != NULL) && (n < max)) {
+	    ranges[n].first = first;
+	    ranges[n].last = i - 1;
+	}
+	n++;
+    }
+    return (n);
+}
@@ -47,12 +47,15 @@
 #include "private.h"
 
 #include <X11/Xlib.h>
+#include <X11/Xlibint.h>		/* for XESetCloseDisplay() */
 #include <X11/Xresource.h>
 #include <X11/Xutil.h>
 #include <X11/StringDefs.h>
-#include <sys/param.h>		/* get MAXPATHLEN if possible */
-#ifndef MAXPATHLEN
-#define MAXPATHLEN 256
+#include <X11/Xos.h>		/* for access() */
+#include <sys/stat.h>
+#if defined(_POSIX_MAPPED_FILES) && (_POSIX_MAPPED_FILES > 0)
+#include <sys/mman.h>
+#define USE_MMAP 1
 #endif
 #include <X11/Xmu/CvtCache.h>
 #include <X11/xpm.h>
@@ -61,8 +64,88 @@
 #include <string.h>
 
 #include <X11/XawPlus/StrToPmap.h>
+#include "PmapBundle.h"
+#include "AsyncPmap.h"
 
 static char **PIXMAPFILEPATHCACHE = NULL;
+static XrmQuark searchKey = NULLQUARK;	/* see _XawPixmapSearchKey() */
+static unsigned long pathFlushes = 0;
+
+/*
+ * The files found for pixmap names, per display.  A NULL path remembers
+ * that the name was not found anywhere.
+ */
+typedef struct _PathCache {
+    struct _PathCache *next;
+    Display *dpy;
+    XrmQuark name;
+    char *path;
+} PathCache;
+
+static PathCache *pathCache = NULL;
+
+/*
+ * The displays that clean up their path cache when they are closed.  This
+ * outlives the entries, so that a flush does not add the hook again.
+ */
+typedef struct _PathDisplay {
+    struct _PathDisplay *next;
+    Display *dpy;
+} PathDisplay;
+
+static PathDisplay *pathDisplays = NULL;
+
+/*
+ * The pixmap bundle of each display, see PmapBundle.h.  data is NULL if
+ * the display has none.
+ */
+typedef struct _Bundle {
+    struct _Bundle *next;
+    Display *dpy;
+    unsigned char *data;
+    size_t size;
+    int mapped;
+} Bundle;
+
+static Bundle *bundles = NULL;
+
+/*
+ * The colors allocated for pixmaps, per display and colormap.  Colors are
+ * found by name, or by RGB value when libXpm asks for a close color, and
+ * stay allocated until the display is closed.  Names that cannot be
+ * parsed are remembered, colors that could not be allocated are not.
+ */
+#define COLOR_BUCKETS	64
+
+typedef struct _CachedColor {
+    struct _CachedColor *next;
+    XrmQuark name;		/* NULLQUARK if found by RGB value */
+    unsigned short red, green, blue;	/* the RGB value asked for */
+    XColor color;		/* the color allocated */
+    int status;			/* 1 allocated, -1 bad name */
+} CachedColor;
+
+typedef struct _ColorCache {
+    struct _ColorCache *next;
+    Display *dpy;
+    Colormap colormap;
+    CachedColor *bucket[COLOR_BUCKETS];
+    XawColorCacheStats stats;
+} ColorCache;
+
+static ColorCache *colorCaches = NULL;
+
+/*
+ * The color overrides of pixmap names, which are display independent.
+ */
+typedef struct _Overrides {
+    struct _Overrides *next;
+    XrmQuark spec;		/* the name with its overrides */
+    XpmColorSymbol *colorsymbols;
+    int numsymbols;
+} Overrides;
+
+static Overrides *overrides = NULL;
 
 /* This is the default pixmap path used for pixmaps, which are defined
  * in resouce files of XawPlus applications.
@@ -193,8 +276,851 @@ ExtractXPMColorOverrides(
     return colorsymbols;
 }
 
+/*
+ * LookupOverrides - extract the color overrides of a pixmap name once and
+ * keep them.  The name is cut off behind the file name.
+ */
+static XpmColorSymbol *
+LookupOverrides(
+		   char *string,	/* !CONTENTS ARE MODIFIED! */
+		   int *numsymbols)
+{
+    XrmQuark spec;
+    Overrides *known;
+    char *s;
+
+    for (s = string; *s && !isspace(*s); s++) ;
+    if (*s == '\0') {
+	*numsymbols = 0;
+	return NULL;
+    }
+    spec = XrmStringToQuark(string);
+    for (known = overrides; known != NULL; known = known->next) {
+	if (known->spec == spec) {
+	    *s = '\0';
+	    *numsymbols = known->numsymbols;
+	    return known->colorsymbols;
+	}
+    }
+    if ((known = (Overrides *) malloc(sizeof(Overrides))) == NULL) {
+	*s = '\0';
+	*numsymbols = 0;
+	return NULL;
+    }
+    known->spec = spec;
+    known->colorsymbols = ExtractXPMColorOverrides(string, &known->numsymbols);
+    if (known->colorsymbols == NULL)
+	known->numsymbols = 0;
+    known->next = overrides;
+    overrides = known;
+    *numsymbols = known->numsymbols;
+    return known->colorsymbols;
+}
+
+static int
+CloseColorCache(Display *dpy, XExtCodes * codes GCC_UNUSED)
+{
+    ColorCache **prev = &colorCaches, *cache;
+    int i;
+
+    while ((cache = *prev) != NULL) {
+	if (cache->dpy == dpy) {
+	    *prev = cache->next;
+	    for (i = 0; i < COLOR_BUCKETS; i++) {
+		CachedColor *color, *next;
+
+		for (color = cache->bucket[i]; color != NULL; color = next) {
+		    next = color->next;
+		    free(color);
+		}
+	    }
+	    free(cache);
+	} else
+	    prev = &cache->next;
+    }
+    return 0;
+}
+
+/*
+ * GetColorCache - find or create the color cache of a colormap
+ */
+static ColorCache *
+GetColorCache(Display *dpy, Colormap colormap)
+{
+    ColorCache *cache;
+    Bool known = False;
+
+    for (cache = colorCaches; cache != NULL; cache = cache->next) {
+	if (cache->dpy == dpy) {
+	    if (cache->colormap == colormap)
+		return cache;
+	    known = True;
+	}
+    }
+    if ((cache = (ColorCache *) calloc((size_t) 1, sizeof(ColorCache))) == NULL)
+	return NULL;
+    cache->dpy = dpy;
+    cache->colormap = colormap;
+    cache->next = colorCaches;
+    colorCaches = cache;
+    if (!known) {
+	XExtCodes *codes = XAddExtension(dpy);
+
+	if (codes != NULL)
+	    (void) XESetCloseDisplay(dpy, codes->extension, CloseColorCache);
+    }
+    return cache;
+}
+
+/*
+ * AllocCachedColor - the XpmAllocColorFunc of the color cache: allocate
+ * a color given by name, or by its RGB value if colorname is NULL.
+ * Returns 1 if allocated, 0 if not, and -1 for a bad name.
+ */
+static int
+AllocCachedColor(
+		    Display *dpy,
+		    Colormap colormap,
+		    char *colorname,
+		    XColor * xcolor,
+		    void *closure)
+{
+    ColorCache *cache = (ColorCache *) closure;
+    CachedColor *color;
+    XrmQuark name = NULLQUARK;
+    unsigned i;
+
+    cache->stats.lookups++;
+    if (colorname != NULL) {
+	name = XrmStringToQuark(colorname);
+	i = (unsigned) name % COLOR_BUCKETS;
+    } else {
+	i = ((unsigned) xcolor->red * 31 + xcolor->green * 7 + xcolor->blue)
+	    % COLOR_BUCKETS;
+    }
+    for (color = cache->bucket[i]; color != NULL; color = color->next) {
+	if (color->name == name &&
+	    (name != NULLQUARK ||
+	     (color->red == xcolor->red &&
+	      color->green == xcolor->green &&
+	      color->blue == xcolor->blue))) {
+	    cache->stats.hits++;
+	    if (color->status > 0)
+		*xcolor = color->color;
+	    return color->status;
+	}
+    }
+
+    cache->stats.misses++;
+    if ((color = (CachedColor *) malloc(sizeof(CachedColor))) == NULL)
+	return 0;
+    color->name = name;
+    color->red = xcolor->red;
+    color->green = xcolor->green;
+    color->blue = xcolor->blue;
+    if (colorname != NULL && !XParseColor(dpy, colormap, colorname, xcolor))
+	color->status = -1;
+    else if (XAllocColor(dpy, colormap, xcolor))
+	color->status = 1;
+    else {
+	free(color);
+	return 0;
+    }
+    color->color = *xcolor;
+    color->next = cache->bucket[i];
+    cache->bucket[i] = color;
+    return color->status;
+}
+
+/*
+ * FreeCachedColors - the XpmFreeColorsFunc of the color cache.  The
+ * colors are shared by all pixmaps of the colormap, and kept.
+ */
+static int
+FreeCachedColors(
+		    Display *dpy GCC_UNUSED,
+		    Colormap colormap GCC_UNUSED,
+		    Pixel * pixels GCC_UNUSED,
+		    int npixels GCC_UNUSED,
+		    void *closure GCC_UNUSED)
+{
+    return 0;
+}
+
+/*
+ * XawGetColorCacheStats - return the counters of the color caches of a
+ * display, summed over its colormaps
+ */
+void
+XawGetColorCacheStats(Display *dpy, XawColorCacheStats * stats)
+{
+    ColorCache *cache;
+
+    stats->lookups = stats->hits = stats->misses = 0;
+    for (cache = colorCaches; cache != NULL; cache = cache->next) {
+	if (cache->dpy == dpy) {
+	    stats->lookups += cache->stats.lookups;
+	    stats->hits += cache->stats.hits;
+	    stats->misses += cache->stats.misses;
+	}
+    }
+}
+
+/*
+ * FlushPathCache - remove the cached paths of a display, or all of them,
+ * or only the given entry
+ */
+static void
+FlushPathCache(Display *dpy, PathCache * only)
+{
+    PathCache **prev = &pathCache, *entry;
+
+    while ((entry = *prev) != NULL) {
+	if ((only != NULL) ? (entry == only) : (dpy == NULL || entry->dpy == dpy)) {
+	    *prev = entry->next;
+	    free(entry->path);
+	    free(entry);
+	} else
+	    prev = &entry->next;
+    }
+}
+
+static int
+ClosePathCache(Display *dpy, XExtCodes * codes GCC_UNUSED)
+{
+    PathDisplay **prev, *known;
+
+    FlushPathCache(dpy, NULL);
+    for (prev = &pathDisplays; (known = *prev) != NULL; prev = &known->next)
+	if (known->dpy == dpy) {
+	    *prev = known->next;
+	    free(known);
+	    break;
+	}
+    return 0;
+}
+
+/*
+ * LookupPath - find the cache entry of a name
+ */
+static PathCache *
+LookupPath(Display *dpy, XrmQuark name)
+{
+    PathCache *entry;
+
+    for (entry = pathCache; entry != NULL; entry = entry->next)
+	if (entry->dpy == dpy && entry->name == name)
+	    return entry;
+    return NULL;
+}
+
+/*
+ * RememberPath - add a name to the cache, path may be NULL
+ */
+static void
+RememberPath(Display *dpy, XrmQuark name, char *path)
+{
+    PathCache *entry;
+    PathDisplay *known;
+
+    for (known = pathDisplays; known != NULL; known = known->next)
+	if (known->dpy == dpy)
+	    break;
+    if (known == NULL) {	/* clean up when the display is closed */
+	XExtCodes *codes;
+
+	if ((known = (PathDisplay *) malloc(sizeof(PathDisplay))) == NULL)
+	    return;
+	if ((codes = XAddExtension(dpy)) == NULL) {
+	    free(known);
+	    return;
+	}
+	(void) XESetCloseDisplay(dpy, codes->extension, ClosePathCache);
+	known->dpy = dpy;
+	known->next = pathDisplays;
+	pathDisplays = known;
+    }
+
+    entry = (PathCache *) malloc(sizeof(PathCache));
+    if (entry == NULL)
+	return;
+    entry->dpy = dpy;
+    entry->name = name;
+    entry->path = NULL;
+    if (path != NULL && (entry->path = (char *) malloc(strlen(path) + 1)) != NULL)
+	strcpy(entry->path, path);
+    entry->next = pathCache;
+    pathCache = entry;
+}
+
+/*
+ * XawFlushPixmapPathCache - forget where pixmap files were found, or that
+ * they were not found, and read the pixmapFilePath resource again.  Use
+ * this after pixmap files were installed or removed.  A NULL display
+ * flushes the entries of all displays.
+ */
+void
+XawFlushPixmapPathCache(Display *dpy)
+{
+    FlushPathCache(dpy, NULL);
+    if (PIXMAPFILEPATHCACHE) {
+	free(PIXMAPFILEPATHCACHE[0]);
+	free(PIXMAPFILEPATHCACHE);
+	PIXMAPFILEPATHCACHE = NULL;
+    }
+    pathFlushes++;
+    searchKey = NULLQUARK;
+}
+
+/*
+ * GetNumber - read a number of a pixmap bundle
+ */
+static unsigned long
+GetNumber(unsigned char *p)
+{
+    return (((unsigned long) p[0] << 24) | ((unsigned long) p[1] << 16) |
+	    ((unsigned long) p[2] << 8) | (unsigned long) p[3]);
+}
+
+static int
+CloseBundle(Display *dpy, XExtCodes * codes GCC_UNUSED)
+{
+    Bundle **prev = &bundles, *bundle;
+
+    while ((bundle = *prev) != NULL) {
+	if (bundle->dpy == dpy) {
+	    *prev = bundle->next;
+#ifdef USE_MMAP
+	    if (bundle->mapped)
+		(void) munmap((void *) bundle->data, bundle->size);
+	    else
+#endif
+		free(bundle->data);
+	    free(bundle);
+	} else
+	    prev = &bundle->next;
+    }
+    return 0;
+}
+
+/*
+ * ReadBundle - map or read the file of a pixmap bundle, and check its
+ * header
+ */
+static void
+ReadBundle(Bundle * bundle, char *filename)
+{
+    struct stat sb;
+    int fd;
+
+    if ((fd = open(filename, O_RDONLY)) < 0) {
+	fprintf(stderr, "Warning: cannot open pixmap bundle %s\n", filename);
+	return;
+    }
+    if (fstat(fd, &sb) == 0 && sb.st_size >= BUNDLE_HEADER) {
+	bundle->size = (size_t) sb.st_size;
+#ifdef USE_MMAP
+	bundle->data = (unsigned char *) mmap(NULL, bundle->size, PROT_READ,
+					      MAP_SHARED, fd, (off_t) 0);
+	if (bundle->data == (unsigned char *) MAP_FAILED)
+	    bundle->data = NULL;
+	else
+	    bundle->mapped = 1;
+#endif
+	if (bundle->data == NULL &&
+	    (bundle->data = (unsigned char *) malloc(bundle->size)) != NULL &&
+	    read(fd, bundle->data, bundle->size) != (ssize_t) bundle->size) {
+	    free(bundle->data);
+	    bundle->data = NULL;
+	}
+    }
+    (void) close(fd);
+
+    if (bundle->data != NULL &&
+	(GetNumber(bundle->data) != BUNDLE_MAGIC ||
+	 GetNumber(bundle->data + 4) != BUNDLE_VERSION ||
+	 GetNumber(bundle->data + 8) >
+	 (bundle->size - BUNDLE_HEADER) / BUNDLE_ENTRY)) {
+	fprintf(stderr, "Warning: %s is not a pixmap bundle\n", filename);
+#ifdef USE_MMAP
+	if (bundle->mapped)
+	    (void) munmap((void *) bundle->data, bundle->size);
+	else
+#endif
+	    free(bundle->data);
+	bundle->data = NULL;
+	bundle->mapped = 0;
+    }
+}
+
+/*
+ * GetBundle - find the pixmap bundle of a display, opening the file named
+ * by the pixmapBundle resource the first time
+ */
+static Bundle *
+GetBundle(Display *dpy)
+{
+    Bundle *bundle;
+    XExtCodes *codes;
+    XrmName xrm_name[2];
+    XrmClass xrm_class[2];
+    XrmRepresentation rep_type;
+    XrmValue value;
+
+    for (bundle = bundles; bundle != NULL; bundle = bundle->next)
+	if (bundle->dpy == dpy)
+	    return bundle;
+
+    if ((bundle = (Bundle *) calloc((size_t) 1, sizeof(Bundle))) == NULL)
+	return NULL;
+    bundle->dpy = dpy;
+    bundle->next = bundles;
+    bundles = bundle;
+    if ((codes = XAddExtension(dpy)) != NULL)
+	(void) XESetCloseDisplay(dpy, codes->extension, CloseBundle);
+
+    xrm_name[0] = XrmPermStringToQuark(XtNpixmapBundle);
+    xrm_name[1] = NULLQUARK;
+    xrm_class[0] = XrmPermStringToQuark(XtCPixmapBundle);
+    xrm_class[1] = NULLQUARK;
+    if (!XrmGetDatabase(dpy))
+	(void) XGetDefault(dpy, "", "");
+    if (XrmQGetResource(XrmGetDatabase(dpy), xrm_name, xrm_class,
+			&rep_type, &value) &&
+	rep_type == XrmPermStringToQuark("String"))
+	ReadBundle(bundle, (char *) value.addr);
+    return bundle;
+}
+
+/*
+ * FindBundleEntry - find a pixmap in a bundle, checking that its data
+ * is inside the file
+ */
+static unsigned char *
+FindBundleEntry(Bundle * bundle, char *name)
+{
+    unsigned long low = 0, high = GetNumber(bundle->data + 8);
+    unsigned long offset, width, height, ncolors, bytes;
+    unsigned char *entry;
+    int cmp;
+
+    while (low < high) {
+	unsigned long mid = (low + high) / 2;
+
+	entry = bundle->data + BUNDLE_HEADER + mid * BUNDLE_ENTRY;
+	offset = GetNumber(entry + 4 * BUNDLE_NAME);
+	if (offset >= bundle->size ||
+	    memchr(bundle->data + offset, '\0', bundle->size - offset) == NULL)
+	    return NULL;
+	if ((cmp = strcmp(name, (char *) bundle->data + offset)) == 0)
+	    break;
+	if (cmp < 0)
+	    high = mid;
+	else
+	    low = mid + 1;
+    }
+    if (low >= high)
+	return NULL;
+
+    width = GetNumber(entry + 4 * BUNDLE_WIDTH);
+    height = GetNumber(entry + 4 * BUNDLE_HEIGHT);
+    ncolors = GetNumber(entry + 4 * BUNDLE_NCOLORS);
+    if (width == 0 || height == 0 || width > 0x7fff || height > 0x7fff ||
+	ncolors == 0 || ncolors > 0x10000)
+	return NULL;
+    offset = GetNumber(entry + 4 * BUNDLE_PALETTE);
+    if (offset > bundle->size || 4 * ncolors > bundle->size - offset)
+	return NULL;
+    bytes = width * height * ((ncolors > 256) ? 2 : 1);
+    offset = GetNumber(entry + 4 * BUNDLE_PIXELS);
+    if (offset > bundle->size || bytes > bundle->size - offset)
+	return NULL;
+    bytes = ((width + 7) / 8) * height;
+    offset = GetNumber(entry + 4 * BUNDLE_MASK);
+    if (offset != 0 && (offset > bundle->size || bytes > bundle->size - offset))
+	return NULL;
+    return entry;
+}
+
+/*
+ * CreateBundlePixmap - create the pixmap and clip mask of a bundle entry
+ */
+static Pixmap
+CreateBundlePixmap(
+		      Screen *screen,
+		      Colormap colormap,
+		      Bundle * bundle,
+		      unsigned char *entry,
+		      int *widthp,
+		      int *heightp,
+		      Pixmap * clipmask)
+{
+    Display *dpy = DisplayOfScreen(screen);
+    Window root = RootWindowOfScreen(screen);
+    unsigned width = (unsigned) GetNumber(entry + 4 * BUNDLE_WIDTH);
+    unsigned height = (unsigned) GetNumber(entry + 4 * BUNDLE_HEIGHT);
+    unsigned ncolors = (unsigned) GetNumber(entry + 4 * BUNDLE_NCOLORS);
+    unsigned char *palette = bundle->data + GetNumber(entry + 4 * BUNDLE_PALETTE);
+    unsigned char *pixels = bundle->data + GetNumber(entry + 4 * BUNDLE_PIXELS);
+    unsigned long mask = GetNumber(entry + 4 * BUNDLE_MASK);
+    ColorCache *cache = GetColorCache(dpy, colormap);
+    unsigned long *colors;
+    unsigned x, y, i;
+    XImage *image;
+    Pixmap pixmap;
+    GC gc;
+
+    if ((colors = (unsigned long *) malloc(ncolors * sizeof(unsigned long))) == NULL)
+	return None;
+    for (i = 0; i < ncolors; i++) {
+	unsigned long rgb = GetNumber(palette + 4 * i);
+	XColor color;
+
+	color.red = (unsigned short) (((rgb >> 16) & 0xff) * 0x101);
+	color.green = (unsigned short) (((rgb >> 8) & 0xff) * 0x101);
+	color.blue = (unsigned short) ((rgb & 0xff) * 0x101);
+	color.flags = DoRed | DoGreen | DoBlue;
+	if ((cache != NULL)
+	    ? (AllocCachedColor(dpy, colormap, NULL, &color, cache) > 0)
+	    : XAllocColor(dpy, colormap, &color))
+	    colors[i] = color.pixel;
+	else if ((unsigned) color.red + color.green + color.blue > 3 * 0x7fff)
+	    colors[i] = WhitePixelOfScreen(screen);
+	else
+	    colors[i] = BlackPixelOfScreen(screen);
+    }
+
+    image = XCreateImage(dpy, screen->root_visual, (unsigned) screen->root_depth,
+			 ZPixmap, 0, NULL, width, height, BitmapPad(dpy), 0);
+    if (image == NULL) {
+	free(colors);
+	return None;
+    }
+    if ((image->data = (char *) malloc((size_t) image->bytes_per_line * height)) == NULL) {
+	XDestroyImage(image);
+	free(colors);
+	return None;
+    }
+    for (y = 0; y < height; y++) {
+	for (x = 0; x < width; x++) {
+	    if (ncolors > 256) {
+		i = ((unsigned) pixels[0] << 8) | pixels[1];
+		pixels += 2;
+	    } else
+		i = *pixels++;
+	    XPutPixel(image, (int) x, (int) y, colors[(i < ncolors) ? i : 0]);
+	}
+    }
+    free(colors);
+
+    pixmap = XCreatePixmap(dpy, root, width, height, (unsigned) screen->root_depth);
+    gc = XCreateGC(dpy, pixmap, 0, NULL);
+    XPutImage(dpy, pixmap, gc, image, 0, 0, 0, 0, width, height);
+    XFreeGC(dpy, gc);
+    XDestroyImage(image);
+
+    if (clipmask)
+	*clipmask = (mask == 0) ? None :
+	    XCreateBitmapFromData(dpy, root, (char *) bundle->data + mask,
+				  width, height);
+    if (widthp)
+	*widthp = (int) width;
+    if (heightp)
+	*heightp = (int) height;
+    return pixmap;
+}
+
+/*
+ * SetAttributes - the XPM attributes for a screen and colormap, which
+ * allocate colors through the color cache
+ */
+static void
+SetAttributes(
+		 Screen *screen,
+		 Colormap colormap,
+		 XpmColorSymbol * colorsymbols,
+		 int numsymbols,
+		 XpmAttributes * attributes)
+{
+    ColorCache *colors;
+
+    attributes->visual = screen->root_visual;
+    attributes->depth = (unsigned) screen->root_depth;
+    attributes->colormap = colormap;
+    attributes->valuemask = XpmColormap | XpmDepth | XpmVisual;
+
+    if ((colors = GetColorCache(DisplayOfScreen(screen), colormap)) != NULL) {
+	attributes->alloc_color = AllocCachedColor;
+	attributes->free_colors = FreeCachedColors;
+	attributes->color_closure = (void *) colors;
+	attributes->valuemask |= XpmAllocColor | XpmFreeColors | XpmColorClosure;
+    }
+    if (numsymbols) {
+	attributes->numsymbols = (unsigned) numsymbols;
+	attributes->colorsymbols = colorsymbols;
+	attributes->valuemask |= XpmColorSymbols;
+    }
+}
+
+/*
+ * GetFilePaths - the directories of the pixmapFilePath resource
+ */
+static char **
+GetFilePaths(Display *dpy)
+{
+    if (!PIXMAPFILEPATHCACHE && _XmuCCLookupDisplay(dpy)) {
+	XrmName xrm_name[2];
+	XrmClass xrm_class[2];
+	XrmRepresentation rep_type;
+	XrmValue value;
+
+	xrm_name[0] = XrmPermStringToQuark("pixmapFilePath");
+	xrm_name[1] = NULLQUARK;
+	xrm_class[0] = XrmPermStringToQuark("PixmapFilePath");
+	xrm_class[1] = NULLQUARK;
+
+	/*
+	 * XXX - warning, derefing Display * until XDisplayDatabase
+	 */
+	if (!XrmGetDatabase(dpy)) {
+	    /* what a hack; need to initialize dpy->db */
+	    (void) XGetDefault(dpy, "", "");
+	}
+	if (XrmQGetResource(XrmGetDatabase(dpy), xrm_name, xrm_class,
+			    &rep_type, &value) &&
+	    rep_type == XrmPermStringToQuark("String")) {
+	    PIXMAPFILEPATHCACHE = split_path_string(value.addr);
+	}
+    }
+    return PIXMAPFILEPATHCACHE;
+}
+
+/*
+ * _XawBundledPixmap - create a pixmap from the pixmap bundle of the
+ * display, if it is there and its colors are not overridden
+ */
+Pixmap
+_XawBundledPixmap(
+		     Screen *screen,
+		     Colormap colormap,
+		     char *PixmapName,
+		     int *widthp,
+		     int *heightp,	/* RETURN */
+		     Pixmap * clipmask)	/* RETURN */
+{
+    Bundle *bundle = GetBundle(DisplayOfScreen(screen));
+    unsigned char *entry;
+
+    if (bundle == NULL || bundle->data == NULL ||
+	strpbrk(PixmapName, " \t\n") != NULL ||
+	(entry = FindBundleEntry(bundle, PixmapName)) == NULL)
+	return None;
+    return CreateBundlePixmap(screen, colormap, bundle, entry,
+			      widthp, heightp, clipmask);
+}
+
+/*
+ * _XawPixmapCandidates - the files to try for a pixmap name (without
+ * color overrides), in search order, as a NULL terminated list that is
+ * released with free().  The file found before comes first, a name that
+ * was not found before has none.
+ *
+ * Search order:
+ *    1.  name if it begins with / or ./
+ *    2.  "each prefix in file_paths"/name
+ *    3.  PIXMAPDIR/name
+ *    4.  name if didn't begin with / or .
+ */
+char **
+_XawPixmapCandidates(Display *dpy, char *name)
+{
+    PathCache *known = LookupPath(dpy, XrmStringToQuark(name));
+    char **file_paths = GetFilePaths(dpy);
+    Bool absolute = ((name[0] == '/') || ((name[0] == '.') && (name[1] == '/')));
+    size_t count = 0, size = 0, len = strlen(name);
+    char **list, *next;
+    int i;
+
+    if (known != NULL && known->path == NULL)
+	count = 0;
+    else if (absolute)
+	count = 1;
+    else {
+	count = 2;
+	size = strlen(PIXMAPDIR) + 1;
+	for (i = 0; file_paths && file_paths[i]; i++, count++)
+	    size += strlen(file_paths[i]) + 1;
+    }
+    size += count * (len + 1);
+    if (known != NULL && known->path != NULL) {
+	count++;
+	size += strlen(known->path) + 1;
+    }
+
+    list = (char **) malloc((count + 1) * sizeof(char *) + size);
+    if (list == NULL)
+	return NULL;
+    next = (char *) (list + count + 1);
+    count = 0;
+    if (known != NULL && known->path == NULL) {
+	list[0] = NULL;
+	return list;
+    }
+    if (known != NULL && known->path != NULL) {
+	list[count++] = strcpy(next, known->path);
+	next += strlen(next) + 1;
+    }
+    if (!absolute) {
+	for (i = 0; file_paths && file_paths[i]; i++) {
+	    list[count++] = next;
+	    sprintf(next, "%s/%s", file_paths[i], name);
+	    next += strlen(next) + 1;
+	}
+	list[count++] = next;
+	sprintf(next, "%s/%s", PIXMAPDIR, name);
+	next += strlen(next) + 1;
+    }
+    list[count++] = strcpy(next, name);
+    list[count] = NULL;
+    return list;
+}
+
+/*
+ * _XawRememberPixmapFile - remember the file found for a pixmap name, or
+ * that it was not found (path NULL)
+ */
+void
+_XawRememberPixmapFile(Display *dpy, char *name, char *path)
+{
+    XrmQuark quark = XrmStringToQuark(name);
+    PathCache *known = LookupPath(dpy, quark);
+
+    if (known != NULL) {
+	if ((known->path == NULL) ? (path == NULL)
+	    : (path != NULL && !strcmp(known->path, path)))
+	    return;
+	FlushPathCache(dpy, known);
+    }
+    RememberPath(dpy, quark, path);
+}
+
+/*
+ * _XawPixmapSearchKey - a quark that stays the same as long as pixmap
+ * names resolve to the same files: the directories of the pixmapFilePath
+ * resource, and the number of times the path cache was flushed
+ */
+XrmQuark
+_XawPixmapSearchKey(Display *dpy)
+{
+    char **file_paths, *key;
+    size_t size = 32;
+    XrmQuark quark;
+    int i;
+
+    if (searchKey != NULLQUARK)
+	return searchKey;
+    file_paths = GetFilePaths(dpy);
+    for (i = 0; file_paths && file_paths[i]; i++)
+	size += strlen(file_paths[i]) + 1;
+    if ((key = (char *) malloc(size)) == NULL)
+	return NULLQUARK;
+    sprintf(key, "%lu", pathFlushes);
+    for (i = 0; file_paths && file_paths[i]; i++) {
+	strcat(key, ":");
+	strcat(key, file_paths[i]);
+    }
+    quark = XrmStringToQuark(key);
+    free(key);
+    if (file_paths != NULL)	/* else the resource may be read later */
+	searchKey = quark;
+    return quark;
+}
+
+/*
+ * _XawResolvePixmapName - the file a pixmap name is read from, followed by
+ * the color overrides of the name, as a string released with free().  For
+ * names in the pixmap bundle and names that are not found, this is a copy
+ * of the name.
+ */
+char *
+_XawResolvePixmapName(Display *dpy, char *PixmapName)
+{
+    Bundle *bundle = GetBundle(dpy);
+    size_t len = strcspn(PixmapName, " \t\n");
+    char **candidates = NULL;
+    char *file, *fn = NULL, *result;
+    int i;
+
+    if ((file = (char *) malloc(len + 1)) == NULL)
+	return NULL;
+    strncpy(file, PixmapName, len);
+    file[len] = '\0';
+    if (bundle == NULL || bundle->data == NULL ||
+	PixmapName[len] != '\0' || FindBundleEntry(bundle, file) == NULL) {
+	if ((candidates = _XawPixmapCandidates(dpy, file)) != NULL) {
+	    for (i = 0; (fn = candidates[i]) != NULL; i++)
+		if (access(fn, R_OK) == 0)
+		    break;
+	}
+    }
+    if (fn == NULL)
+	fn = file;
+    if ((result = (char *) malloc(strlen(fn) + strlen(PixmapName + len) + 1)) != NULL) {
+	strcpy(result, fn);
+	strcat(result, PixmapName + len);
+    }
+    free(candidates);
+    free(file);
+    return result;
+}
+
+/*
+ * _XawCreateXpmPixmap - create a pixmap and its clip mask from a decoded
+ * XPM file, applying the color overrides of PixmapName
+ */
+Pixmap
+_XawCreateXpmPixmap(
+		       Screen *screen,
+		       Colormap colormap,
+		       char *PixmapName,
+		       XpmImage * image,
+		       Pixmap * clipmask)	/* RETURN */
+{
+    XpmAttributes attributes;
+    XpmColorSymbol *colorsymbols;
+    int numsymbols;
+    Pixmap pixmap = None, mask = None;
+    char *name;
+
+    if ((name = (char *) malloc(strlen(PixmapName) + 1)) == NULL)
+	return None;
+    (void) strcpy(name, PixmapName);
+    colorsymbols = LookupOverrides(name, &numsymbols);
+    free(name);
+
+    SetAttributes(screen, colormap, colorsymbols, numsymbols, &attributes);
+    if (XpmCreatePixmapFromXpmImage(DisplayOfScreen(screen),
+				    RootWindowOfScreen(screen), image,
+				    &pixmap, &mask, &attributes) != XpmSuccess)
+	return None;
+    if (clipmask)
+	*clipmask = mask;
+    else if (mask != None)
+	XFreePixmap(DisplayOfScreen(screen), mask);
+    return pixmap;
+}
+
 /*
  * XawLocatePixmapFile - read a pixmap file using the normal defaults
+ *
+ * The file found for a name is remembered, and so is a name that could
+ * not be found, so that the path is searched only once per display.
+ * Candidates that cannot be read are skipped without parsing them.  A
+ * file that can be read but not created, e.g. because the colormap is
+ * full, is not remembered as missing, so that it is tried again.
+ * Pixmaps found in the bundle named by the pixmapBundle resource are
+ * created from it without reading any XPM file, unless colors are
+ * overridden.
  */
 
 Pixmap
@@ -210,122 +1136,59 @@ XawLocatePixmapFile(
 {
     Display *dpy = DisplayOfScreen(screen);
     Window root = RootWindowOfScreen(screen);
-    Bool try_plain_name = True;
-    XmuCvtCache *cache = _XmuCCLookupDisplay(dpy);
-    char **file_paths = NULL;
-    char filename[MAXPATHLEN];
+    char **candidates;
+    char *name, *fn = NULL;
+    Bool readable = False;
     int i;
-    char *name;
 
     XpmAttributes attributes;
     XpmColorSymbol *colorsymbols;
     int numsymbols;
-
-    attributes.visual = screen->root_visual;
-    attributes.depth = (unsigned) screen->root_depth;
-    attributes.colormap = colormap;
-    attributes.valuemask = XpmColormap | XpmDepth | XpmVisual;
-
-    name = (char *) malloc(strlen(PixmapName) + 1);
-    (void) strcpy(name, PixmapName);
-    colorsymbols = ExtractXPMColorOverrides(name, &numsymbols);
-
-    if (numsymbols) {
-	attributes.numsymbols = (unsigned) numsymbols;
-	attributes.colorsymbols = colorsymbols;
-	attributes.valuemask |= XpmColorSymbols;
-    }
-    /* name is modified by call */
+    Pixmap pixmap = None;
 
     /*
-     * look in cache for pixmap path
+     * look in the pixmap bundle
      */
-    if (cache) {
-	if (!PIXMAPFILEPATHCACHE) {
-	    XrmName xrm_name[2];
-	    XrmClass xrm_class[2];
-	    XrmRepresentation rep_type;
-	    XrmValue value;
-
-	    xrm_name[0] = XrmPermStringToQuark("pixmapFilePath");
-	    xrm_name[1] = NULLQUARK;
-	    xrm_class[0] = XrmPermStringToQuark("PixmapFilePath");
-	    xrm_class[1] = NULLQUARK;
-
-	    /*
-	     * XXX - warning, derefing Display * until XDisplayDatabase
-	     */
-	    if (!XrmGetDatabase(dpy)) {
-		/* what a hack; need to initialize dpy->db */
-		(void) XGetDefault(dpy, "", "");
-	    }
-	    if (XrmQGetResource(XrmGetDatabase(dpy), xrm_name, xrm_class,
-				&rep_type, &value) &&
-		rep_type == XrmPermStringToQuark("String")) {
-		PIXMAPFILEPATHCACHE = split_path_string(value.addr);
-	    }
+    pixmap = _XawBundledPixmap(screen, colormap, PixmapName,
+			       widthp, heightp, clipmask);
+    if (pixmap != None) {
+	if (srcname && srcnamelen > 0) {
+	    strncpy(srcname, PixmapName, (size_t) (srcnamelen - 1));
+	    srcname[srcnamelen - 1] = '\0';
 	}
-	file_paths = PIXMAPFILEPATHCACHE;
+	return pixmap;
     }
 
-    /*
-     * Search order:
-     *    1.  name if it begins with / or ./
-     *    2.  "each prefix in file_paths"/name
-     *    3.  PIXMAPDIR/name
-     *    4.  name if didn't begin with / or .
-     */
+    name = (char *) malloc(strlen(PixmapName) + 1);
+    (void) strcpy(name, PixmapName);
+    colorsymbols = LookupOverrides(name, &numsymbols);
+    /* name is modified by call */
 
-    for (i = 1; i <= 4; i++) {
-	char *fn = filename;
-	Pixmap pixmap;
+    SetAttributes(screen, colormap, colorsymbols, numsymbols, &attributes);
 
-	switch (i) {
-	case 1:
-	    if (!((name[0] == '/') || ((name[0] == '.') && (name[1] == '/'))))
+    if ((candidates = _XawPixmapCandidates(dpy, name)) != NULL) {
+	for (i = 0; (fn = candidates[i]) != NULL; i++) {
+	    if (access(fn, R_OK) != 0)
 		continue;
-	    fn = name;
-	    try_plain_name = False;
-	    break;
-	case 2:
-	    if (file_paths && *file_paths) {
-		sprintf(filename, "%s/%s", *file_paths, name);
-		file_paths++;
-		i--;
+	    readable = True;
+	    if (XpmReadPixmapFile(dpy, root, fn,
+				  &pixmap, clipmask, &attributes) == XpmSuccess)
 		break;
-	    }
-	    continue;
-	case 3:
-	    sprintf(filename, "%s/%s", PIXMAPDIR, name);
-	    break;
-	case 4:
-	    if (!try_plain_name)
-		continue;
-	    fn = name;
-	    break;
 	}
-
-	if (XpmReadPixmapFile(dpy, root, fn,
-			      &pixmap, clipmask, &attributes) == XpmSuccess) {
-	    if (widthp)
-		*widthp = (int) attributes.width;
-	    if (heightp)
-		*heightp = (int) attributes.height;
-	    if (srcname && srcnamelen > 0) {
-		strncpy(srcname, fn, (size_t) (srcnamelen - 1));
-		srcname[srcnamelen - 1] = '\0';
-	    }
-	    /*free up colorsymbol info */
-	    free(name);
-	    if (numsymbols)
-		free(colorsymbols);
-	    return pixmap;
+	if (fn != NULL || !readable)
+	    _XawRememberPixmapFile(dpy, name, fn);
+    }
+    if (fn != NULL) {
+	if (widthp)
+	    *widthp = (int) attributes.width;
+	if (heightp)
+	    *heightp = (int) attributes.height;
+	if (srcname && srcnamelen > 0) {
+	    strncpy(srcname, fn, (size_t) (srcnamelen - 1));
+	    srcname[srcnamelen - 1] = '\0';
 	}
     }
-    /*free up colorsymbol info */
-
+    free(candidates);
     free(name);
-    if (numsymbols)
-	free(colorsymbols);
-    return None;
+    return (fn != NULL) ? pixmap : None;
 }
@@ -122,6 +122,22 @@ static FILE * InitStringOrFile(MultiSrcObject src, Boolean newString);
 static void FreeAllPieces(MultiSrcObject src);
 static void RemovePiece(MultiSrcObject src, MultiPiece* piece);
 static void BreakPiece(MultiSrcObject src, MultiPiece* piece);
+static MultiPiece * NewPiece(void);
+static void LinkPiece(MultiSrcObject src, MultiPiece* piece, MultiPiece* parent, Boolean left);
+static void RotatePiece(MultiSrcObject src, MultiPiece* piece);
+static void UpdatePiece(MultiSrcObject src, MultiPiece* piece);
+static void UpdateTotals(MultiPiece* piece);
+static void SumPiece(MultiPiece* piece);
+static void SumSubtree(MultiPiece* piece);
+static XawTextPosition CountLines(wchar_t* text, XawTextPosition length);
+static void IndexLines(MultiSrcObject src);
+static XawTextPosition FindNewline(MultiSrcObject src, XawTextPosition number);
+static XawTextPosition LinesBefore(MultiSrcObject src, XawTextPosition position);
+static XawTextPosition ScanLines(MultiSrcObject src, XawTextPosition position, XawTextScanDirection dir, int count, Bool include);
+static XawTextPosition SearchText(MultiSrcObject src, XawTextPosition position, XawTextScanDirection dir, XawTextBlock* text, Boolean fold);
+static Boolean MatchText(MultiPiece* piece, XawTextPosition offset, wchar_t* buf, int length, XawTextScanDirection dir, Boolean fold);
+static int CompareText(wchar_t* a, wchar_t* b, int n, Boolean fold);
+static XawTextPosition SearchHorspool(MultiSrcObject src, XawTextPosition position, XawTextScanDirection dir, wchar_t* buf, int length, Boolean fold);
 static void LoadPieces(MultiSrcObject src, FILE* file, char* string);
 static void RemoveOldStringOrFile(MultiSrcObject src, Boolean checkString);
 static void CvtStringToMultiType(XrmValuePtr args, Cardinal* num_args, XrmValuePtr fromVal, XrmValuePtr toVal);
@@ -143,6 +159,12 @@ static void (MyWStrncpy)();
 extern int errno;
 #endif
 
+#define PieceTotal(p)		((p) != NULL ? (p)->total : 0)
+#define PieceLines(p)		((p) != NULL ? (p)->line_total : 0)
+
+#define ShiftIndex(c)		((unsigned) (c) & 0xff)
+#define FoldChar(c, fold)	((fold) ? (wchar_t) towlower(c) : (c))
+
 #ifdef X_NOT_POSIX
 #define Off_t long
 #define Size_t unsigned int
@@ -248,6 +270,7 @@ Initialize(
 
     src->multi_src.changes = FALSE;
     src->multi_src.allocated_string = FALSE;
+    src->multi_src.lines_indexed = FALSE;
 
     file = InitStringOrFile(src, src->multi_src.type == XawAsciiFile);
     LoadPieces(src, file, NULL);
@@ -356,7 +379,9 @@ ReplaceText(
 
 	/* If empty and not the only piece then remove it. */
 
-	if (((start_piece->used = startPos - start_first) == 0) &&
+	start_piece->used = startPos - start_first;
+	UpdatePiece(src, start_piece);
+	if ((start_piece->used == 0) &&
 	    !((start_piece->next == NULL) && (start_piece->prev == NULL)))
 	    RemovePiece(src, start_piece);
 
@@ -368,10 +393,13 @@ ReplaceText(
 	if (end_piece->used != 0)
 	    MyWStrncpy(end_piece->text, (end_piece->text + endPos - end_first),
 		       (size_t) (int) end_piece->used);
+	UpdatePiece(src, end_piece);
     } else {			/* We are fully in one piece. */
 	if ((start_piece->used -= endPos - startPos) == 0) {
 	    if (!((start_piece->next == NULL) && (start_piece->prev == NULL)))
 		RemovePiece(src, start_piece);
+	    else
+		UpdatePiece(src, start_piece);
 	} else {
 	    MyWStrncpy(start_piece->text + (startPos - start_first),
 		       start_piece->text + (endPos - start_first),
@@ -381,6 +409,7 @@ ReplaceText(
 		 (src->multi_src.piece_size - 1)))
 		start_piece->text[src->multi_src.length - (endPos -
 		    startPos)] = (wchar_t) 0;
+	    UpdatePiece(src, start_piece);
 	}
     }
 
@@ -411,6 +440,7 @@ ReplaceText(
 		    /*((TextWidget)src->object.parent)->text.lastPos = src->multi_src.length; */
 
 		    start_piece->text[src->multi_src.length] = (wchar_t) 0;
+		    UpdatePiece(src, start_piece);
 		    return (XawEditError);
 		}
 	    }
@@ -432,6 +462,7 @@ ReplaceText(
 	    startPos += fill;
 	    firstPos += fill;
 	    start_piece->used += fill;
+	    UpdatePiece(src, start_piece);
 	    length -= fill;
 	}
     }
@@ -498,6 +529,9 @@ Scan(
     if (position > src->multi_src.length)
 	position = src->multi_src.length;
 
+    if ((type == XawstEOL) && (count > 1))
+	return (ScanLines(src, position, dir, count, include));
+
     if (dir == XawsdRight) {
 	if (position == src->multi_src.length)
 	    return (src->multi_src.length);
@@ -603,22 +637,38 @@ Search(
 	  XawTextScanDirection dir,
 	  XawTextBlock * text)
 {
-    MultiSrcObject src = (MultiSrcObject) w;
-    int inc, count = 0;
-    wchar_t *ptr;
+    return (SearchText((MultiSrcObject) w, position, dir, text, False));
+}
+
+/*	Function Name: SearchText
+ *	Description: Searchs the text source for the text block passed,
+ *                   for Search() and _XawMultiSourceSearchIgnoreCase().
+ *	Arguments: src - the MultiSource Widget.
+ *                 position - the position to start scanning.
+ *                 dir - direction to scan.
+ *                 text - the text block to search for.
+ *                 fold - True to ignore the case of letters.
+ *	Returns: the position of the item found.
+ */
+
+static XawTextPosition
+SearchText(
+	      MultiSrcObject src,
+	      XawTextPosition position,
+	      XawTextScanDirection dir,
+	      XawTextBlock * text,
+	      Boolean fold)
+{
     wchar_t *wtarget;
     int wtarget_len;
-    Display *d = XtDisplay(XtParent(w));
-    MultiPiece *piece;
-    wchar_t *buf;
-    XawTextPosition first;
+    Display *d = XtDisplay(XtParent((Widget) src));
+    XawTextPosition found;
 
     /* STEP 1: First, a brief sanity check. */
 
-    if (dir == XawsdRight)
-	inc = 1;
-    else {
-	inc = -1;
+    if (position > src->multi_src.length)
+	position = src->multi_src.length;
+    if (dir == XawsdLeft) {
 	if (position == 0)
 	    return (XawTextSearchError);	/* scanning left from 0??? */
 	position--;
@@ -646,53 +696,14 @@ Search(
 
     /* STEP 3: SEARCH! */
 
-    buf = (wchar_t *) XtMalloc((unsigned) sizeof(wchar_t) * (unsigned) wtarget_len);
-    (void) wcsncpy(buf, wtarget, (size_t) wtarget_len);
-    piece = FindPiece(src, position, &first);
-    ptr = (position - first) + piece->text;
-
-    /* CONSTCOND */
-    while (TRUE) {
-	if (*ptr == ((dir == XawsdRight) ? *(buf + count)
-		     : *(buf + wtarget_len - count - 1))) {
-	    if (count == (text->length - 1))
-		break;
-	    else
-		count++;
-	} else {
-	    if (count != 0) {
-		position -= inc * count;
-		ptr -= inc * count;
-	    }
-	    count = 0;
-	}
-
-	ptr += inc;
-	position += inc;
-
-	while (ptr < piece->text) {
-	    piece = piece->prev;
-	    if (piece == NULL) {	/* Begining of text. */
-		XtFree((char *) buf);
-		return (XawTextSearchError);
-	    }
-	    ptr = piece->text + piece->used - 1;
-	}
-
-	while (ptr >= (piece->text + piece->used)) {
-	    piece = piece->next;
-	    if (piece == NULL) {	/* End of text. */
-		XtFree((char *) buf);
-		return (XawTextSearchError);
-	    }
-	    ptr = piece->text;
-	}
-    }
+    if ((wtarget == NULL) || (wtarget_len <= 0))
+	found = XawTextSearchError;
+    else
+	found = SearchHorspool(src, position, dir, wtarget, wtarget_len, fold);
 
-    XtFree((char *) buf);
-    if (dir == XawsdLeft)
-	return (position);
-    return (position - (wtarget_len - 1));
+    if (text->format != XawFmtWide)
+	XtFree((char *) wtarget);
+    return (found);
 }
 
 /*	Function Name: SetValues
@@ -955,6 +966,63 @@ _XawMultiSaveAsFile(
     return (False);
 }
 
+/*	Function Name: _XawMultiSourceLineToPosition
+ *	Description: Finds the start of a line, for XawTextSourceLineToPosition.
+ *	Arguments: w - the MultiSrc widget.
+ *                 line - the line number, counting from 0.
+ *	Returns: the position, or the end of the text if there are
+ *               fewer lines.
+ */
+
+XawTextPosition
+_XawMultiSourceLineToPosition(Widget w, long line)
+{
+    MultiSrcObject src = (MultiSrcObject) w;
+    XawTextPosition newline;
+
+    if (line <= 0)
+	return (0);
+    if ((newline = FindNewline(src, (XawTextPosition) line)) < 0)
+	return (src->multi_src.length);
+    return (newline + 1);
+}
+
+/*	Function Name: _XawMultiSourcePositionToLine
+ *	Description: Finds the line of a position, for
+ *                   XawTextSourcePositionToLine.
+ *	Arguments: w - the MultiSrc widget.
+ *                 position - the position.
+ *	Returns: the line number, counting from 0.
+ */
+
+long
+_XawMultiSourcePositionToLine(Widget w, XawTextPosition position)
+{
+    MultiSrcObject src = (MultiSrcObject) w;
+
+    if (position > src->multi_src.length)
+	position = src->multi_src.length;
+    return ((long) LinesBefore(src, position));
+}
+
+/*	Function Name: _XawMultiSourceSearchIgnoreCase
+ *	Description: Searchs the text source for the text block passed,
+ *                   ignoring the case of letters.  This is used by
+ *                   XawTextSourceSearchCompiled().
+ *	Arguments: w - the MultiSrc widget.
+ *                 position - the position to start scanning.
+ *                 dir - direction to scan.
+ *                 text - the text block to search for.
+ *	Returns: the position of the item found.
+ */
+
+XawTextPosition
+_XawMultiSourceSearchIgnoreCase(Widget w, XawTextPosition position,
+				XawTextScanDirection dir, XawTextBlock * text)
+{
+    return (SearchText((MultiSrcObject) w, position, dir, text, True));
+}
+
 /************************************************************
  *
  * Private Functions.
@@ -1192,6 +1260,8 @@ LoadPieces(
      */
     int local_length = (int) src->multi_src.length;
 
+    src->multi_src.lines_indexed = FALSE;
+
     if (string != NULL) {
 	/*
 	 * ASSERT: IF our caller passed a non-null string, THEN
@@ -1255,6 +1325,7 @@ LoadPieces(
 	piece = AllocNewPiece(src, piece);
 	piece->used = Min(src->multi_src.length, src->multi_src.piece_size);
 	piece->text = (wchar_t *) src->multi_src.string;
+	UpdatePiece(src, piece);
 	return;
     }
 
@@ -1269,6 +1340,7 @@ LoadPieces(
 	piece->used = Min(left, src->multi_src.piece_size);
 	if (piece->used != 0)
 	    (void) wcsncpy(piece->text, ptr, (size_t) piece->used);
+	UpdatePiece(src, piece);
 
 	left -= piece->used;
 	ptr += piece->used;
@@ -1290,16 +1362,27 @@ AllocNewPiece(
 		 MultiSrcObject src,
 		 MultiPiece * prev)
 {
-    MultiPiece *piece = XtNew(MultiPiece);
+    MultiPiece *piece = NewPiece();
 
     if (prev == NULL) {
 	src->multi_src.first_piece = piece;
+	src->multi_src.root_piece = piece;
 	piece->next = NULL;
+	piece->parent = NULL;
     } else {
 	if (prev->next != NULL)
 	    (prev->next)->prev = piece;
 	piece->next = prev->next;
 	prev->next = piece;
+
+	/*
+	 * The successor of prev is either its right child, or the leftmost
+	 * piece of its right subtree.
+	 */
+	if (prev->right == NULL)
+	    LinkPiece(src, piece, prev, FALSE);
+	else
+	    LinkPiece(src, piece, piece->next, TRUE);
     }
 
     piece->prev = prev;
@@ -1307,6 +1390,57 @@ AllocNewPiece(
     return (piece);
 }
 
+/*	Function Name: NewPiece
+ *	Description: Allocates an empty piece, which is not yet linked.
+ *	Arguments: none.
+ *	Returns: the allocated piece.
+ */
+
+static MultiPiece *
+NewPiece(void)
+{
+    static unsigned long seed = 1;
+    MultiPiece *piece = XtNew(MultiPiece);
+
+    piece->text = NULL;
+    piece->used = 0;
+    piece->total = 0;
+    piece->lines = 0;
+    piece->line_total = 0;
+    piece->left = piece->right = NULL;
+    seed = seed * 1103515245L + 12345;
+    piece->weight = seed >> 8;
+
+    return (piece);
+}
+
+/*	Function Name: LinkPiece
+ *	Description: Adds an empty piece to the position index as a child
+ *                   of the given piece, and restores the heap order.
+ *	Arguments: src - The MultiSrc Widget.
+ *                 piece - the new piece.
+ *                 parent - the piece that has no child on that side.
+ *                 left - TRUE to become the left child of parent.
+ *	Returns: none.
+ */
+
+static void
+LinkPiece(
+	     MultiSrcObject src,
+	     MultiPiece * piece,
+	     MultiPiece * parent,
+	     Boolean left)
+{
+    if (left)
+	parent->left = piece;
+    else
+	parent->right = piece;
+    piece->parent = parent;
+
+    while (piece->parent != NULL && piece->parent->weight < piece->weight)
+	RotatePiece(src, piece);
+}
+
 /*	Function Name: FreeAllPieces
  *	Description: Frees all the pieces
  *	Arguments: src - The MultiSrc Widget.
@@ -1340,6 +1474,25 @@ RemovePiece(
 	       MultiSrcObject src,
 	       MultiPiece * piece)
 {
+    MultiPiece *child;
+
+    while (piece->left != NULL && piece->right != NULL) {
+	if (piece->left->weight > piece->right->weight)
+	    RotatePiece(src, piece->left);
+	else
+	    RotatePiece(src, piece->right);
+    }
+    child = (piece->left != NULL) ? piece->left : piece->right;
+    if (child != NULL)
+	child->parent = piece->parent;
+    if (piece->parent == NULL)
+	src->multi_src.root_piece = child;
+    else if (piece->parent->left == piece)
+	piece->parent->left = child;
+    else
+	piece->parent->right = child;
+    UpdateTotals(piece->parent);
+
     if (piece->prev == NULL)
 	src->multi_src.first_piece = piece->next;
     else
@@ -1360,6 +1513,10 @@ RemovePiece(
  *                 position - the position that we are searching for.
  * RETURNED        first - the position of the first character in this piece.
  *	Returns: piece - the piece that contains this position.
+ *
+ * The pieces are kept in a treap ordered like the linked list, where each
+ * node knows the number of characters in its subtree, so that the lookup
+ * costs O(log pieces) rather than a walk from the first piece.
  */
 
 static MultiPiece *
@@ -1368,19 +1525,451 @@ FindPiece(
 	     XawTextPosition position,
 	     XawTextPosition * first)
 {
-    MultiPiece *old_piece = NULL;
-    MultiPiece *piece = src->multi_src.first_piece;
-    XawTextPosition temp;
+    MultiPiece *piece = src->multi_src.root_piece;
+    XawTextPosition base = 0;
+
+    if (position < 0)
+	position = 0;
+
+    while (piece != NULL) {
+	if (position < base + PieceTotal(piece->left)) {
+	    piece = piece->left;
+	} else {
+	    base += PieceTotal(piece->left);
+	    if (position < base + piece->used) {
+		*first = base;
+		return (piece);
+	    }
+	    base += piece->used;
+	    piece = piece->right;
+	}
+    }
+
+    /* if we run off the end the return the last piece */
+
+    for (piece = src->multi_src.root_piece;
+	 piece->right != NULL;
+	 piece = piece->right) ;
+    *first = src->multi_src.root_piece->total - piece->used;
+    return (piece);
+}
+
+/*	Function Name: UpdatePiece
+ *	Description: Updates the position index after the text or the used
+ *                   count of a piece has changed.
+ *	Arguments: src - The MultiSrc Widget.
+ *                 piece - the piece that was changed.
+ *	Returns: none.
+ */
+
+static void
+UpdatePiece(
+	       MultiSrcObject src,
+	       MultiPiece * piece)
+{
+    if (src->multi_src.lines_indexed)
+	piece->lines = CountLines(piece->text, piece->used);
+    UpdateTotals(piece);
+}
+
+/*	Function Name: UpdateTotals
+ *	Description: Recomputes the subtree totals from a piece up to the
+ *                   root of the position index.
+ *	Arguments: piece - the lowest piece whose subtree has changed.
+ *	Returns: none.
+ */
+
+static void
+UpdateTotals(
+		MultiPiece * piece)
+{
+    for (; piece != NULL; piece = piece->parent)
+	SumPiece(piece);
+}
+
+/*	Function Name: SumPiece
+ *	Description: Recomputes the totals of one piece from its children.
+ *	Arguments: piece - the piece.
+ *	Returns: none.
+ */
+
+static void
+SumPiece(
+	    MultiPiece * piece)
+{
+    piece->total = (PieceTotal(piece->left) + piece->used +
+		    PieceTotal(piece->right));
+    piece->line_total = (PieceLines(piece->left) + piece->lines +
+			 PieceLines(piece->right));
+}
+
+/*	Function Name: RotatePiece
+ *	Description: Rotates a piece of the position index above its parent.
+ *	Arguments: src - The MultiSrc Widget.
+ *                 piece - the piece to move up.
+ *	Returns: none.
+ */
+
+static void
+RotatePiece(
+	       MultiSrcObject src,
+	       MultiPiece * piece)
+{
+    MultiPiece *parent = piece->parent;
+    MultiPiece *grand = parent->parent;
+
+    if (parent->left == piece) {
+	parent->left = piece->right;
+	if (piece->right != NULL)
+	    piece->right->parent = parent;
+	piece->right = parent;
+    } else {
+	parent->right = piece->left;
+	if (piece->left != NULL)
+	    piece->left->parent = parent;
+	piece->left = parent;
+    }
+    parent->parent = piece;
+    piece->parent = grand;
+
+    if (grand == NULL)
+	src->multi_src.root_piece = piece;
+    else if (grand->left == parent)
+	grand->left = piece;
+    else
+	grand->right = piece;
+
+    SumPiece(parent);
+    SumPiece(piece);
+}
+
+/*	Function Name: CountLines
+ *	Description: Counts the newlines in a buffer.
+ *	Arguments: text - the buffer.
+ *                 length - the number of characters.
+ *	Returns: the number of newlines.
+ */
+
+static XawTextPosition
+CountLines(
+	      wchar_t *text,
+	      XawTextPosition length)
+{
+    XawTextPosition lines = 0;
+    wchar_t *end = text + length;
+    wchar_t lf = _Xaw_atowc(XawLF);
+
+    for (; text < end; text++)
+	if (*text == lf)
+	    lines++;
+    return (lines);
+}
+
+/*	Function Name: IndexLines
+ *	Description: Counts the newlines of every piece, the first time
+ *                   that the line index is needed.  After that the
+ *                   counts are kept up to date by UpdatePiece.
+ *	Arguments: src - The MultiSrc Widget.
+ *	Returns: none.
+ */
+
+static void
+IndexLines(
+	      MultiSrcObject src)
+{
+    MultiPiece *piece;
 
-    for (temp = 0; piece != NULL; temp += piece->used, piece = piece->next) {
-	*first = temp;
-	old_piece = piece;
+    if (src->multi_src.lines_indexed)
+	return;
+
+    for (piece = src->multi_src.first_piece; piece != NULL; piece = piece->next)
+	piece->lines = CountLines(piece->text, piece->used);
+    SumSubtree(src->multi_src.root_piece);
+
+    src->multi_src.lines_indexed = TRUE;
+}
+
+static void
+SumSubtree(
+	      MultiPiece * piece)
+{
+    if (piece != NULL) {
+	SumSubtree(piece->left);
+	SumSubtree(piece->right);
+	SumPiece(piece);
+    }
+}
+
+/*	Function Name: FindNewline
+ *	Description: Finds a newline by its number.
+ *	Arguments: src - The MultiSrc Widget.
+ *                 number - the number of the newline, counting from 1.
+ *	Returns: the position of the newline, or -1 if there is none.
+ */
+
+static XawTextPosition
+FindNewline(
+	       MultiSrcObject src,
+	       XawTextPosition number)
+{
+    MultiPiece *piece;
+    XawTextPosition base = 0;
+
+    IndexLines(src);
+
+    piece = src->multi_src.root_piece;
+    if ((number < 1) || (number > piece->line_total))
+	return (-1);
+
+    while (piece != NULL) {
+	if (number <= PieceLines(piece->left)) {
+	    piece = piece->left;
+	} else {
+	    number -= PieceLines(piece->left);
+	    base += PieceTotal(piece->left);
+	    if (number <= piece->lines) {
+		wchar_t *ptr;
+		wchar_t lf = _Xaw_atowc(XawLF);
+
+		for (ptr = piece->text;; ptr++)
+		    if ((*ptr == lf) && (--number == 0))
+			return (base + (ptr - piece->text));
+	    }
+	    number -= piece->lines;
+	    base += piece->used;
+	    piece = piece->right;
+	}
+    }
+    return (-1);
+}
+
+/*	Function Name: LinesBefore
+ *	Description: Counts the newlines in front of a position.
+ *	Arguments: src - The MultiSrc Widget.
+ *                 position - the position.
+ *	Returns: the number of newlines.
+ */
+
+static XawTextPosition
+LinesBefore(
+	       MultiSrcObject src,
+	       XawTextPosition position)
+{
+    MultiPiece *piece;
+    XawTextPosition base = 0, lines = 0;
 
-	if ((temp + piece->used) > position)
-	    return (piece);
+    IndexLines(src);
+
+    piece = src->multi_src.root_piece;
+    while (piece != NULL) {
+	if (position < base + PieceTotal(piece->left)) {
+	    piece = piece->left;
+	} else {
+	    base += PieceTotal(piece->left);
+	    lines += PieceLines(piece->left);
+	    if (position < base + piece->used)
+		return (lines + CountLines(piece->text, position - base));
+	    base += piece->used;
+	    lines += piece->lines;
+	    piece = piece->right;
+	}
+    }
+    return (lines);
+}
+
+/*	Function Name: ScanLines
+ *	Description: Scans for several ends of line using the line index,
+ *                   giving the same result as Scan.
+ *	Arguments: src - The MultiSrc Widget.
+ *                 position - the position to start scanning.
+ *                 dir - direction to scan.
+ *                 count - the number of lines.
+ *                 include - whether to include the newline found.
+ *	Returns: the position of the item found.
+ */
+
+static XawTextPosition
+ScanLines(
+	     MultiSrcObject src,
+	     XawTextPosition position,
+	     XawTextScanDirection dir,
+	     int count,
+	     Bool include)
+{
+    XawTextPosition newline;
+
+    if (dir == XawsdRight) {
+	if (position >= src->multi_src.length)
+	    return (src->multi_src.length);
+	newline = FindNewline(src, LinesBefore(src, position) + count);
+	if (newline < 0)
+	    return (src->multi_src.length);
+	position = include ? newline + 1 : newline;
+    } else {
+	if (position <= 0)
+	    return (0);
+	newline = FindNewline(src, LinesBefore(src, position) - count + 1);
+	if (newline < 0)
+	    return (0);
+	position = include ? newline : newline + 1;
+    }
+
+    if (position >= src->multi_src.length)
+	return (src->multi_src.length);
+    return (position);
+}
+
+/*	Function Name: MatchText
+ *	Description: Compares the text at an offset with a string, following
+ *                   the pieces as needed.
+ *	Arguments: piece - the piece to start in.
+ *                 offset - the offset of the first character to compare.
+ *                 buf - the string.
+ *                 length - the length of the string.
+ *                 dir - XawsdRight to compare forward from the start of
+ *                       the string, XawsdLeft to compare backward from
+ *                       its end.
+ *                 fold - True to ignore the case of letters.
+ *	Returns: True if the text matches the string.
+ */
+
+static Boolean
+MatchText(
+	     MultiPiece * piece,
+	     XawTextPosition offset,
+	     wchar_t *buf,
+	     int length,
+	     XawTextScanDirection dir,
+	     Boolean fold)
+{
+    int n;
+
+    while (length > 0) {
+	if (dir == XawsdRight) {
+	    n = (int) Min(length, piece->used - offset);
+	    if (CompareText(piece->text + offset, buf, n, fold) != 0)
+		return (False);
+	    buf += n;
+	    length -= n;
+	    if (length > 0) {
+		if ((piece = piece->next) == NULL)
+		    return (False);
+		offset = 0;
+	    }
+	} else {
+	    n = (int) Min(length, offset + 1);
+	    if (CompareText(piece->text + offset - n + 1, buf + length - n,
+			    n, fold) != 0)
+		return (False);
+	    length -= n;
+	    if (length > 0) {
+		if ((piece = piece->prev) == NULL)
+		    return (False);
+		offset = piece->used - 1;
+	    }
+	}
+    }
+    return (True);
+}
+
+/*	Function Name: CompareText
+ *	Description: Compares two wide strings like memcmp().
+ *	Arguments: a, b - the strings.
+ *                 n - the number of characters.
+ *                 fold - True to ignore the case of letters.
+ *	Returns: zero if the strings are equal.
+ */
+
+static int
+CompareText(
+	       wchar_t *a,
+	       wchar_t *b,
+	       int n,
+	       Boolean fold)
+{
+    if (!fold)
+	return (memcmp(a, b, n * sizeof(wchar_t)));
+
+    for (; n > 0; n--, a++, b++)
+	if (towlower(*a) != towlower(*b))
+	    return (1);
+    return (0);
+}
+
+/*	Function Name: SearchHorspool
+ *	Description: Searches for a string with the Boyer-Moore-Horspool
+ *                   algorithm, which skips ahead by up to the length of
+ *                   the string after each mismatch.
+ *	Arguments: src - The MultiSrc Widget.
+ *                 position - the first position where the string may
+ *                            start, or to the left the last position
+ *                            where it may end.
+ *                 dir - direction to search.
+ *                 buf - the string.
+ *                 length - the length of the string.
+ *                 fold - True to ignore the case of letters.
+ *	Returns: the position of the string or XawTextSearchError.
+ *
+ * The shifts are kept for the low byte of each character only, so
+ * characters that share it get the smallest of their shifts.
+ */
+
+static XawTextPosition
+SearchHorspool(
+		  MultiSrcObject src,
+		  XawTextPosition position,
+		  XawTextScanDirection dir,
+		  wchar_t *buf,
+		  int length,
+		  Boolean fold)
+{
+    int shift[256];
+    MultiPiece *piece;
+    XawTextPosition first, pos;
+    wchar_t c;
+    int i;
+
+    for (i = 0; i < 256; i++)
+	shift[i] = length;
+    if (dir == XawsdRight) {
+	for (i = 0; i < length - 1; i++)
+	    shift[ShiftIndex(FoldChar(buf[i], fold))] = length - 1 - i;
+	pos = position + length - 1;
+    } else {
+	for (i = length - 1; i > 0; i--)
+	    shift[ShiftIndex(FoldChar(buf[i], fold))] = i;
+	pos = position - (length - 1);
+    }
+    if ((pos < 0) || (pos >= src->multi_src.length))
+	return (XawTextSearchError);
+
+    piece = FindPiece(src, pos, &first);
+
+    /* CONSTCOND */
+    while (TRUE) {
+	c = FoldChar(piece->text[pos - first], fold);
+	if (dir == XawsdRight) {
+	    if ((c == FoldChar(buf[length - 1], fold)) &&
+		MatchText(piece, pos - first, buf, length, XawsdLeft, fold))
+		return (pos - (length - 1));
+	    pos += shift[ShiftIndex(c)];
+	    while (pos >= first + piece->used) {
+		first += piece->used;
+		if ((piece = piece->next) == NULL)	/* End of text. */
+		    return (XawTextSearchError);
+	    }
+	} else {
+	    if ((c == FoldChar(buf[0], fold)) &&
+		MatchText(piece, pos - first, buf, length, XawsdRight, fold))
+		return (pos);
+	    pos -= shift[ShiftIndex(c)];
+	    while (pos < first) {
+		if ((piece = piece->prev) == NULL)	/* Begining of text. */
+		    return (XawTextSearchError);
+		first -= piece->used;
+	    }
+	}
     }
-    *first = temp - (old_piece ? old_piece->used : 0);
-    return (old_piece);		/* if we run off the end the return the last piece */
 }
 
 /*	Function Name: BreakPiece
@@ -1406,6 +1995,8 @@ BreakPiece(
 		   (size_t) (src->multi_src.piece_size - HALF_PIECE));
     piece->used = HALF_PIECE;
     new->used = src->multi_src.piece_size - HALF_PIECE;
+    UpdatePiece(src, piece);
+    UpdatePiece(src, new);
 }
 
 /* Convert string "XawAsciiString" and "XawAsciiFile" to quarks. */
@@ -0,0 +1,61 @@
+/**********************************************************************
+ *
+ * PmapBundle.h: The file format of pixmap bundles.
+ *
+ * A pixmap bundle holds a number of XPM files, already converted to
+ * indexed pixels with an RGB palette and a bitmap mask, so that
+ * XawLocatePixmapFile() can create the pixmaps without parsing XPM
+ * text. Bundles are written by util/xawbundle and found through the
+ * resource pixmapBundle, class PixmapBundle.
+ *
+ * All numbers are 32 bit, most significant byte first. All offsets
+ * are counted from the start of the file.
+ *
+ *	header	magic, version, number of pixmaps
+ *	index	one entry per pixmap, sorted by name (strcmp)
+ *	data	names, palettes, pixels and masks
+ *
+ * A palette holds one 0x00RRGGBB value per color. The pixels are
+ * one byte each if there are at most 256 colors, else two bytes.
+ * The mask has the format of XCreateBitmapFromData(): rows of
+ * (width + 7) / 8 bytes, least significant bit first, a set bit
+ * for each pixel that is drawn.
+ *
+ * Copyright (c) Roland Krause 2002, roland_krause@freenet.de
+ *
+ * This module is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 675 Mass Ave, Cambridge, MA 02139, USA.
+ *
+ **********************************************************************/
+
+#ifndef _PmapBundle_h
+#define _PmapBundle_h
+
+#define BUNDLE_MAGIC	0x58617742UL	/* "XawB"			*/
+#define BUNDLE_VERSION	1
+
+#define BUNDLE_HEADER	12		/* Bytes in the header		*/
+#define BUNDLE_ENTRY	28		/* Bytes in an index entry	*/
+
+/* The numbers of an index entry */
+
+#define BUNDLE_NAME	0		/* Offset of the name		*/
+#define BUNDLE_WIDTH	1
+#define BUNDLE_HEIGHT	2
+#define BUNDLE_NCOLORS	3
+#define BUNDLE_PALETTE	4		/* Offset of the palette	*/
+#define BUNDLE_PIXELS	5		/* Offset of the pixels		*/
+#define BUNDLE_MASK	6		/* Offset of the mask, 0 if none */
+
+#endif /* _PmapBundle_h */
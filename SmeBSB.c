@@ -43,6 +43,7 @@ in this Software without prior written authorization from The Open Group.
 #include "private.h"
 
 #include "UTF8.h"
+#include "AsyncPmap.h"
 
 #include <X11/IntrinsicP.h>
 #include <X11/StringDefs.h>
@@ -78,6 +79,14 @@ static XtResource resources[] =
      offset(right_bitmap), XtRImmediate, (XtPointer) None},
     {XtNrightClipMask, XtCRightBitmap, XtRClipMask, sizeof(Pixmap),
      offset(right_clipmask), XtRImmediate, (XtPointer) None},
+    {XtNleftBitmapName, XtCLeftBitmapName, XtRString, sizeof(String),
+     offset(left_bitmap_name), XtRString, NULL},
+    {XtNrightBitmapName, XtCRightBitmapName, XtRString, sizeof(String),
+     offset(right_bitmap_name), XtRString, NULL},
+    {XtNplaceholderWidth, XtCPlaceholderWidth, XtRDimension, sizeof(Dimension),
+     offset(placeholder_width), XtRImmediate, (XtPointer) 0},
+    {XtNplaceholderHeight, XtCPlaceholderHeight, XtRDimension, sizeof(Dimension),
+     offset(placeholder_height), XtRImmediate, (XtPointer) 0},
     {XtNleftMargin, XtCHorizontalMargins, XtRDimension, sizeof(Dimension),
      offset(left_margin), XtRImmediate, (XtPointer) 4},
     {XtNrightMargin, XtCHorizontalMargins, XtRDimension, sizeof(Dimension),
@@ -229,6 +238,16 @@ Initialize(
 	    entry->sme_bsb.label = XtNewString(entry->sme_bsb.label);
     }
     CreateGCs(new);
+    if (entry->sme_bsb.left_bitmap_name)
+	_XawLoadPixmap(new, entry->sme_bsb.left_bitmap_name, XtNleftBitmap,
+		       XtNleftClipMask, entry->sme_bsb.placeholder_width,
+		       entry->sme_bsb.placeholder_height,
+		       &entry->sme_bsb.left_bitmap, &entry->sme_bsb.left_clipmask);
+    if (entry->sme_bsb.right_bitmap_name)
+	_XawLoadPixmap(new, entry->sme_bsb.right_bitmap_name, XtNrightBitmap,
+		       XtNrightClipMask, entry->sme_bsb.placeholder_width,
+		       entry->sme_bsb.placeholder_height,
+		       &entry->sme_bsb.right_bitmap, &entry->sme_bsb.right_clipmask);
     GetBitmapInfo(new, TRUE);	/* Left Bitmap Info */
     GetBitmapInfo(new, FALSE);	/* Right Bitmap Info */
     GetDefaultSize(new, &(entry->rectangle.width), &(entry->rectangle.height));
@@ -517,6 +536,19 @@ SetValues(
     if (entry->rectangle.sensitive != old_entry->rectangle.sensitive)
 	ret_val = TRUE;
 
+    /* Start loading bitmaps given by name */
+
+    if (old_entry->sme_bsb.left_bitmap_name != entry->sme_bsb.left_bitmap_name)
+	_XawLoadPixmap(new, entry->sme_bsb.left_bitmap_name, XtNleftBitmap,
+		       XtNleftClipMask, entry->sme_bsb.placeholder_width,
+		       entry->sme_bsb.placeholder_height,
+		       &entry->sme_bsb.left_bitmap, &entry->sme_bsb.left_clipmask);
+    if (old_entry->sme_bsb.right_bitmap_name != entry->sme_bsb.right_bitmap_name)
+	_XawLoadPixmap(new, entry->sme_bsb.right_bitmap_name, XtNrightBitmap,
+		       XtNrightClipMask, entry->sme_bsb.placeholder_width,
+		       entry->sme_bsb.placeholder_height,
+		       &entry->sme_bsb.right_bitmap, &entry->sme_bsb.right_clipmask);
+
     if ((entry->sme_bsb.left_bitmap != old_entry->sme_bsb.left_bitmap) ||
 	(entry->sme_bsb.left_clipmask != old_entry->sme_bsb.left_clipmask)) {
 	GetBitmapInfo(new, TRUE);
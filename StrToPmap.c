@@ -22,6 +22,10 @@
  * XtAddConverter(XtRString, XtRPixmap, XawCvtStringToPixmap,
  *		   screenConvertArg, XtNumber(screenConvertArg));
  *
+ * Both converters share a cache, so that a pixmap and its clip mask are
+ * read from the file only once, and a file is read only once for all
+ * widget classes using these converters and all names it is found by.
+ *
  * Copyright 2022  Thomas E. Dickey
  * Copyright (c) Roland Krause 2002, roland_krause@freenet.de
  *
@@ -45,10 +49,148 @@
 
 #include <X11/Intrinsic.h>
 #include <X11/StringDefs.h>
+#include <X11/Xlibint.h>		/* for XESetCloseDisplay() */
 #include <X11/Xmu/Converters.h>
 #include <X11/Xmu/Drawing.h>
 
 #include <X11/XawPlus/StrToPmap.h>
+#include "AsyncPmap.h"
+
+/******************************************************************************************
+ *
+ * The pixmap cache: One entry for each string converted on a screen with a colormap.
+ * XPM entries also hold the path the file was found at, followed by the color
+ * overrides of the string, so that different spellings of a file share the pixmaps,
+ * and the search key of the pixmap path they were resolved with. XBM files are only
+ * known by the string. Failed conversions are remembered too. The entries of a
+ * display are removed when it is closed.
+ *
+ ******************************************************************************************/
+
+typedef struct _PixmapCache {
+    struct _PixmapCache *next;
+    XrmQuark		string;		/* The string converted		*/
+    XrmQuark		search;		/* _XawPixmapSearchKey() of it	*/
+    XrmQuark		name;		/* The file or string read	*/
+    Screen		*screen;	/* The conversion arguments	*/
+    Colormap		colormap;
+    Pixmap		pixmap;		/* The results			*/
+    Pixmap		clipMask;
+} PixmapCache;
+
+static PixmapCache *pixmapCache = NULL;
+
+/******************************************************************************************
+ *
+ * ClosePixmapCache(): Removes the entries of a display from the cache, when the
+ *		       display is closed.
+ *
+ ******************************************************************************************/
+
+static int ClosePixmapCache(dpy, codes)
+Display  *dpy;
+XExtCodes *codes;
+{
+    PixmapCache **prev = &pixmapCache, *entry;
+
+    while ((entry = *prev) != NULL)
+    {
+       if (DisplayOfScreen(entry->screen) == dpy)
+       {
+	  *prev = entry->next;
+	  XtFree((char *)entry);
+       }
+       else prev = &entry->next;
+    }
+    return 0;
+}
+
+/******************************************************************************************
+ *
+ * LookupPixmap(): Returns the cache entry for a string, reading the file if
+ *		   it is not in the cache yet. If the filname ends with `.xpm',
+ *		   the file is read as XPM pixmap file, else as XBM bitmap,
+ *		   which is its own clip mask. A string converted before with
+ *		   the same pixmap path is found without touching the file
+ *		   system; a new XPM string is resolved to its file, and shares
+ *		   the pixmaps of another string that resolved to it.
+ *
+ ******************************************************************************************/
+
+static PixmapCache *LookupPixmap(screen, colormap, name)
+Screen   *screen;
+Colormap colormap;
+char     *name;
+{
+    Boolean     isXpm = (strstr(name, ".xpm") != NULL);
+    XrmQuark    string = XrmStringToQuark(name);
+    XrmQuark    search = NULLQUARK, quark = NULLQUARK;
+    PixmapCache *entry, *same = NULL;
+    Boolean     newDisplay = True;
+
+    if (isXpm) search = _XawPixmapSearchKey(DisplayOfScreen(screen));
+
+    for (entry = pixmapCache; entry != NULL; entry = entry->next)
+    {
+       if (entry->string == string && entry->search == search &&
+	   entry->screen == screen && entry->colormap == colormap)
+	  return entry;
+       if (DisplayOfScreen(entry->screen) == DisplayOfScreen(screen))
+	  newDisplay = False;
+    }
+
+    /* Not converted yet: find the file, it may have been read for another string */
+
+    if (isXpm)
+    {
+       char *resolved = _XawResolvePixmapName(DisplayOfScreen(screen), name);
+
+       if (resolved != NULL)
+       {
+	  quark = XrmStringToQuark(resolved);
+	  free(resolved);
+       }
+    }
+    if (quark == NULLQUARK) quark = string;
+
+    for (entry = pixmapCache; entry != NULL && same == NULL; entry = entry->next)
+    {
+       if (entry->name == quark && entry->screen == screen && entry->colormap == colormap)
+	  same = entry;
+    }
+
+    /* Clean up when the display is closed */
+
+    if (newDisplay)
+    {
+       Display   *dpy = DisplayOfScreen(screen);
+       XExtCodes *codes = XAddExtension(dpy);
+
+       if (codes != NULL) (void)XESetCloseDisplay(dpy, codes->extension, ClosePixmapCache);
+    }
+    entry = XtNew(PixmapCache);
+    entry->string   = string;
+    entry->search   = search;
+    entry->name     = quark;
+    entry->screen   = screen;
+    entry->colormap = colormap;
+    entry->clipMask = None;
+
+    if (same != NULL)
+    {
+       entry->pixmap   = same->pixmap;
+       entry->clipMask = same->clipMask;
+    }
+    else if (!isXpm)
+       entry->pixmap = entry->clipMask = XmuLocateBitmapFile(screen, name, NULL, 0,
+							      NULL, NULL, NULL, NULL);
+    else
+       entry->pixmap = XawLocatePixmapFile(screen, colormap, name, NULL, 0,
+					   NULL, NULL, &entry->clipMask);
+    entry->next = pixmapCache;
+    pixmapCache = entry;
+    return entry;
+}
 
 /******************************************************************************************
  *
@@ -65,7 +207,7 @@ Cardinal   *numArgs;
 XrmValuePtr fromVal;
 XrmValuePtr toVal;
 {
-    static Pixmap pixmap, clipMask;
+    static Pixmap pixmap;
     char *name = (char *)fromVal->addr;
 
     /* Number of arguments correct ? */
@@ -76,16 +218,9 @@ XrmValuePtr toVal;
 		 "needs screen and colormap arguments.\n");
        return;
     }
-    /* Check, if filename ends with `.xpm'. If so, try to convert the file
-     * as XPM file format, else try bitmap file format.
-     */
-    if (strstr(name, ".xpm") == NULL)
-         pixmap = XmuLocateBitmapFile(*((Screen **)args[0].addr),
-				      name, NULL, 0, NULL, NULL, NULL, NULL);
-
-    else pixmap = XawLocatePixmapFile(*((Screen **)args[0].addr),
-				      *((Colormap *)args[1].addr),
-				      name, NULL, 0, NULL, NULL, &clipMask);
+    pixmap = LookupPixmap(*((Screen **)args[0].addr), *((Colormap *)args[1].addr),
+			  name)->pixmap;
+
     /* Conversion failed ? */
 
     if (pixmap == None) XtStringConversionWarning(name, "Pixmap");
@@ -122,13 +257,9 @@ XrmValuePtr toVal;
 		 "needs screen and colormap arguments.\n");
        return;
     }
-    /* Check, if filename ends with `.xpm'. If so, try to convert the file
-     * as XPM file format, else try bitmap file format.
-     */
-    if (strstr(name, ".xpm") == NULL)
-      clipMask = XmuLocateBitmapFile(*((Screen **)args[0].addr), name, NULL, 0, NULL, NULL, NULL, NULL);
-    else (void)XawLocatePixmapFile(*((Screen **)args[0].addr), *((Colormap *)args[1].addr),
-				   name, NULL, 0, NULL, NULL, &clipMask);
+    clipMask = LookupPixmap(*((Screen **)args[0].addr), *((Colormap *)args[1].addr),
+			    name)->clipMask;
+
     /* Conversion failed ? */
 
     if (clipMask == None) XtStringConversionWarning(name, "ClipMask");
@@ -71,6 +71,7 @@ This file contains modifications for XawPlus, Roland Krause 2002
 #include <X11/XawPlus/Cardinals.h>
 #include <X11/XawPlus/Scrollbar.h>
 #include <X11/XawPlus/TextP.h>
+#include <X11/XawPlus/TextSrcP.h>
 #include <X11/XawPlus/MultiSinkP.h>
 #include <X11/XawPlus/XawImP.h>
 
@@ -129,6 +130,7 @@ static Boolean TranslateExposeRegion(TextWidget, XRectangle *);
 static XawTextPosition FindGoodPosition(TextWidget, XawTextPosition);
 static XawTextPosition _BuildLineTable(TextWidget, XawTextPosition,
 				       XawTextPosition, int);
+static int CompareEdits(const void *, const void *);
 
 /****************************************************************
  *
@@ -189,7 +191,9 @@ static XtResource resources[] =
     {XtNautoFill, XtCAutoFill, XtRBoolean, sizeof(Boolean),
      offset(text.auto_fill), XtRImmediate, (XtPointer) FALSE},
     {XtNunrealizeCallback, XtCCallback, XtRCallback, sizeof(XtPointer),
-     offset(text.unrealize_callbacks), XtRCallback, (XtPointer) NULL}
+     offset(text.unrealize_callbacks), XtRCallback, (XtPointer) NULL},
+    {XtNupdateRate, XtCUpdateRate, XtRInt, sizeof(int),
+     offset(text.update_rate), XtRImmediate, (XtPointer) 0}
 };
 #undef offset
 
@@ -554,6 +558,7 @@ Initialize(
 
     ctx->text.lt.lines = 0;
     ctx->text.lt.info = NULL;
+    ctx->text.old_info = NULL;
     (void) bzero((char *) &(ctx->text.origSel), sizeof(XawTextSelection));
     (void) bzero((char *) &(ctx->text.s), sizeof(XawTextSelection));
     ctx->text.s.type = XawselectPosition;
@@ -565,9 +570,11 @@ Initialize(
     ctx->text.lastPos = (ctx->text.source != NULL) ? GETLASTPOS : 0;
     ctx->text.file_insert = NULL;
     ctx->text.search = NULL;
-    ctx->text.updateFrom = (XawTextPosition *) XtMalloc((unsigned) ONE);
-    ctx->text.updateTo = (XawTextPosition *) XtMalloc((unsigned) ONE);
+    ctx->text.updateFrom = NULL;
+    ctx->text.updateTo = NULL;
     ctx->text.numranges = ctx->text.maxranges = 0;
+    ctx->text.line_index = NULL;
+    ctx->text.update_timer = 0;
     ctx->text.gc = DefaultGCOfScreen(XtScreen(ctx));
     ctx->text.hasfocus = FALSE;
     ctx->text.margin = ctx->text.r_margin;	/* Strucure copy. */
@@ -732,7 +739,8 @@ InsertCursor(
 /*
  * Procedure to register a span of text that is no longer valid on the display
  * It is used to avoid a number of small, and potentially overlapping, screen
- * updates.
+ * updates.  The ranges are kept sorted, and a range is merged with those it
+ * overlaps or touches.
 */
 
 void
@@ -741,28 +749,63 @@ _XawTextNeedsUpdating(
 			 XawTextPosition left,
 			 XawTextPosition right)
 {
-    int i;
-    if (left < right) {
-	for (i = 0; i < ctx->text.numranges; i++) {
-	    if (left <= ctx->text.updateTo[i] && right >=
-		ctx->text.updateFrom[i]) {
-		ctx->text.updateFrom[i] = Min(left, ctx->text.updateFrom[i]);
-		ctx->text.updateTo[i] = Max(right, ctx->text.updateTo[i]);
-		return;
-	    }
+    XawTextPosition *from = ctx->text.updateFrom, *to = ctx->text.updateTo;
+    int low = 0, high = ctx->text.numranges, mid, n;
+    size_t size;
+
+    if (left >= right)
+	return;
+
+    while (low < high) {	/* Find the first range that ends at left or later. */
+	mid = (low + high) / 2;
+	if (to[mid] < left)
+	    low = mid + 1;
+	else
+	    high = mid;
+    }
+    for (high = low; (high < ctx->text.numranges) && (from[high] <= right);
+	 high++) {
+	left = Min(left, from[high]);
+	right = Max(right, to[high]);
+    }
+
+    if (high > low) {		/* Replace ranges low .. high - 1. */
+	n = ctx->text.numranges - high;
+	memmove(from + low + 1, from + high, (size_t) n * sizeof(XawTextPosition));
+	memmove(to + low + 1, to + high, (size_t) n * sizeof(XawTextPosition));
+	ctx->text.numranges -= high - low - 1;
+    } else {			/* Insert a range at low. */
+	if (ctx->text.numranges == ctx->text.maxranges) {
+	    ctx->text.maxranges = (ctx->text.maxranges == 0) ? 8
+		: 2 * ctx->text.maxranges;
+	    size = (size_t) ctx->text.maxranges * sizeof(XawTextPosition);
+	    ctx->text.updateFrom = from = (XawTextPosition *)
+		XtRealloc((char *) from, (Cardinal) size);
+	    ctx->text.updateTo = to = (XawTextPosition *)
+		XtRealloc((char *) to, (Cardinal) size);
 	}
+	n = ctx->text.numranges - low;
+	memmove(from + low + 1, from + low, (size_t) n * sizeof(XawTextPosition));
+	memmove(to + low + 1, to + low, (size_t) n * sizeof(XawTextPosition));
 	ctx->text.numranges++;
-	if (ctx->text.numranges > ctx->text.maxranges) {
-	    ctx->text.maxranges = ctx->text.numranges;
-	    i = ((size_t) ctx->text.maxranges * sizeof(XawTextPosition));
-	    ctx->text.updateFrom = (XawTextPosition *)
-		XtRealloc((char *) ctx->text.updateFrom, (unsigned) i);
-	    ctx->text.updateTo = (XawTextPosition *)
-		XtRealloc((char *) ctx->text.updateTo, (unsigned) i);
-	}
-	ctx->text.updateFrom[ctx->text.numranges - 1] = left;
-	ctx->text.updateTo[ctx->text.numranges - 1] = right;
     }
+    from[low] = left;
+    to[low] = right;
+}
+
+/*
+ * Sorts and merges the update ranges again, after an edit moved them.
+ */
+
+static void
+MergeUpdates(TextWidget ctx)
+{
+    int i, num = ctx->text.numranges;
+
+    ctx->text.numranges = 0;
+    for (i = 0; i < num; i++)	/* Never writes behind range i. */
+	_XawTextNeedsUpdating(ctx, ctx->text.updateFrom[i],
+			      ctx->text.updateTo[i]);
 }
 
 /*
@@ -976,6 +1019,8 @@ _XawTextBuildLineTable(
     if ((lines != ctx->text.lt.lines) || (ctx->text.lt.info == NULL)) {
 	ctx->text.lt.info = (XawTextLineTableEntry *) XtRealloc((char *) ctx->text.
 								lt.info, size);
+	ctx->text.old_info = (XawTextLineTableEntry *)
+	    XtRealloc((char *) ctx->text.old_info, size);
 	ctx->text.lt.lines = lines;
 	force_rebuild = TRUE;
     }
@@ -987,8 +1032,43 @@ _XawTextBuildLineTable(
     }
 }
 
+/*
+ * Returns the width that lines are wrapped at, or BIGNUM if they are not.
+ */
+
+static int
+WrapWidth(TextWidget ctx)
+{
+    if (((ctx->text.resize == XawtextResizeWidth) ||
+	 (ctx->text.resize == XawtextResizeBoth)) ||
+	(ctx->text.wrap == XawtextWrapNever))
+	return (BIGNUM);
+    return (Max(0, ((int) ctx->core.width - (int) HMargins(ctx))));
+}
+
+/*
+ * Finds a line that starts at position in the copy of the line table that
+ * _BuildLineTable() made, from line first on.  Returns -1 if there is none.
+ */
+
+static int
+FindOldLine(TextWidget ctx, int first, XawTextPosition position)
+{
+    int line;
+
+    for (line = first; line <= ctx->text.lt.lines; line++)
+	if (ctx->text.old_info[line].position == position)
+	    return (line);
+    return (-1);
+}
+
 /*
  * This assumes that the line table does not change size.
+ *
+ * The lines are measured from position on, until one starts after min_pos
+ * where a line of the old table started: the lines from there on are the
+ * same as before.  If the edit added or removed lines, they are moved up
+ * or down in the table, and only lines that become visible are measured.
  */
 
 static XawTextPosition
@@ -999,19 +1079,17 @@ _BuildLineTable(
 		   int line)
 {
     XawTextLineTableEntry *lt = ctx->text.lt.info + line;
+    XawTextLineTableEntry *old = ctx->text.old_info;
     XawTextPosition endPos;
     Position y;
-    int count, width, realW, realH;
+    int count, width, realW, realH, first = line, dy;
     Widget src = ctx->text.source;
 
-    if (((ctx->text.resize == XawtextResizeWidth) ||
-	 (ctx->text.resize == XawtextResizeBoth)) ||
-	(ctx->text.wrap == XawtextWrapNever))
-	width = BIGNUM;
-    else
-	width = Max(0, ((int) ctx->core.width - (int) HMargins(ctx)));
-
+    width = WrapWidth(ctx);
     y = ((line == 0) ? ctx->text.margin.top : lt->y);
+    (void) memcpy((char *) (old + line), (char *) lt,
+		  (size_t) (ctx->text.lt.lines - line + 1) *
+		  sizeof(XawTextLineTableEntry));
 
     while (TRUE) {
 	lt->y = y;
@@ -1036,6 +1114,31 @@ _BuildLineTable(
 	if ((line > ctx->text.lt.lines) ||
 	    ((lt->position == (position = endPos)) && (position > min_pos)))
 	    return (position);
+
+	if ((position > min_pos) && (position <= ctx->text.lastPos) &&
+	    ((count = FindOldLine(ctx, first, position)) >= 0)) {
+	    /*
+	     * The old lines from here on moved by dy, copy them.
+	     */
+	    dy = y - old[count].y;
+	    for (; (line <= ctx->text.lt.lines) && (count <= ctx->text.lt.lines)
+		 && (old[count].position <= ctx->text.lastPos);
+		 lt++, line++, count++) {
+		*lt = old[count];
+		lt->y = (Position) (lt->y + dy);
+	    }
+	    --lt;
+	    --line;
+	    if (line == ctx->text.lt.lines)	/* The table is full. */
+		return (lt->position);
+	    if (count <= ctx->text.lt.lines) {	/* The end of the text. */
+		y = (Position) (old[count].y + dy);
+		endPos = ctx->text.lastPos;
+		break;
+	    }
+	    position = lt->position;	/* Measure the lines below. */
+	    y = lt->y;
+	}
     }
 
 /*
@@ -1069,9 +1172,676 @@ _BuildLineTable(
     return (endPos);
 }
 
+/*
+ * The line index counts the display lines of the whole text, for the
+ * vertical scrollbar, and measures the widest line for the horizontal
+ * one.  The text is split at the starts of source lines into regions of
+ * up to INDEX_LINES source lines, and each region keeps its length, its
+ * number of display lines and the width of its widest line.  Two Fenwick
+ * trees hold the sums of the lengths and of the display lines, so that
+ * the region of a position or of a display line and the lines before it
+ * are found in O(log n) steps.
+ *
+ * An edit changes only the region it starts in: the newlines it removes
+ * and inserts are added to its count, which is then exact for unwrapped
+ * text and close for wrapped text, and the region is marked to be
+ * counted again.  Regions that an edit joins with it are left empty.  A
+ * new wrap width marks all regions.  The counting, and the splitting of
+ * long regions and dropping of empty ones, is done by a work procedure
+ * while the application is idle, a few regions at a time.
+ *
+ * The source counts its replacements; if it was changed by someone else,
+ * e.g. another text widget or XawTextSourceReplace(), the index is
+ * started again.
+ */
+
+#define INDEX_LINES	32	/* Source lines per region. */
+#define INDEX_STEPS	8	/* Regions counted per call of CountLines(). */
+#define INDEX_SPLIT	256	/* Regions split off per call of CountRegion(). */
+
+#define SrcChanges(ctx)	(((TextSrcObject) (ctx)->text.source)->textSrc.changes)
+
+typedef struct {
+    XawTextPosition length;	/* From the start of a source line. */
+    int lines;			/* Display lines. */
+    int widest;			/* The width of the widest line. */
+    Boolean dirty;		/* TRUE if lines and widest are estimates. */
+} IndexRegion;
+
+typedef struct _XawTextLineIndex {
+    IndexRegion *regions;	/* In the order of the text. */
+    XawTextPosition *lengths;	/* Fenwick trees of the lengths and */
+    XawTextPosition *counts;	/* display lines of the regions. */
+    int num_regions, size;
+    int num_dirty;		/* Regions to count (again), */
+    int num_empty;		/* and regions left empty by edits. */
+    int next;			/* No region before this one is dirty. */
+    XawTextPosition end;	/* The end of the last region. */
+    int width;			/* The wrap width the lines were counted */
+    XawTextWrapMode wrap;	/* for, and the wrap mode. */
+    Boolean measure;		/* TRUE if the widths are measured too. */
+    int widest;			/* The widest line of all, -1 if unknown. */
+    unsigned long changes;	/* The changes of the source counted. */
+    XtWorkProcId work;		/* The CountLines() work procedure, or 0. */
+} XawTextLineIndex;
+
+/*	Function Name: NextLine
+ *	Description: Finds the start of the display line after the one
+ *                   that starts at a position.
+ *	Arguments: ctx - the text widget.
+ *                 position - the start of a display line.
+ *                 width - the wrap width, see WrapWidth().
+ *                 textWidth - returns the width of the line, may be NULL.
+ *	Returns: the start of the next display line.
+ */
+
+static XawTextPosition
+NextLine(TextWidget ctx, XawTextPosition position, int width, int *textWidth)
+{
+    XawTextPosition endPos = position;
+    int realW, realH;
+
+    if ((ctx->text.wrap != XawtextWrapNever) || (textWidth != NULL))
+	XawTextSinkFindPosition(ctx->text.sink, position, ctx->text.margin.left,
+				width, ctx->text.wrap == XawtextWrapWord,
+				&endPos, &realW, &realH);
+    if (textWidth != NULL)
+	*textWidth = realW;
+    if ((endPos <= position) || (ctx->text.wrap == XawtextWrapNever))
+	endPos = SrcScan(ctx->text.source, position, XawstEOL, XawsdRight, 1,
+			 TRUE);
+    return (endPos);
+}
+
+/*	Function Name: CountNewlines
+ *	Description: Counts the newlines in a part of the text.
+ *	Arguments: ctx - the text widget.
+ *                 from, to - the part of the text.
+ *	Returns: the number of newlines.
+ */
+
+static int
+CountNewlines(TextWidget ctx, XawTextPosition from, XawTextPosition to)
+{
+    XawTextBlock block;
+    int i, newlines = 0;
+
+    while (from < to) {
+	from = SrcRead(ctx->text.source, from, &block, (int) (to - from));
+	if (block.length <= 0)
+	    break;
+	for (i = 0; i < block.length; i++) {
+	    if (block.format == XawFmtWide) {
+		if (((wchar_t *) block.ptr)[i] == _Xaw_atowc(XawLF))
+		    newlines++;
+	    } else if (block.ptr[i] == XawLF)
+		newlines++;
+	}
+    }
+    return (newlines);
+}
+
+/*	Function Name: TreeAdd
+ *	Description: Adds to the value of a region in a Fenwick tree.
+ *	Arguments: tree - the tree, with one entry per region from 1 on.
+ *                 n - the number of regions.
+ *                 r - the region.
+ *                 delta - what to add.
+ *	Returns: none.
+ */
+
+static void
+TreeAdd(XawTextPosition * tree, int n, int r, XawTextPosition delta)
+{
+    int i;
+
+    for (i = r + 1; i <= n; i += i & -i)
+	tree[i] += delta;
+}
+
+/*	Function Name: TreeSum
+ *	Description: Sums up the values of the regions before one.
+ *	Arguments: tree - the Fenwick tree.
+ *                 r - the region.
+ *	Returns: the sum of the values of the regions 0 to r - 1.
+ */
+
+static XawTextPosition
+TreeSum(XawTextPosition * tree, int r)
+{
+    XawTextPosition sum = 0;
+    int i;
+
+    for (i = r; i > 0; i -= i & -i)
+	sum += tree[i];
+    return (sum);
+}
+
+/*	Function Name: TreeFind
+ *	Description: Finds the region that a sum of values ends in.
+ *	Arguments: tree - the Fenwick tree.
+ *                 n - the number of regions.
+ *                 value - the sum.
+ *                 before - returns the sum of the regions before it.
+ *	Returns: the first region at which the sum of the values exceeds
+ *               value, n if there is none. Regions with the value 0 are
+ *               skipped.
+ */
+
+static int
+TreeFind(XawTextPosition * tree, int n, XawTextPosition value,
+	 XawTextPosition * before)
+{
+    XawTextPosition sum = 0;
+    int r = 0, step;
+
+    for (step = 1; 2 * step <= n; step *= 2) ;
+    for (; step > 0; step /= 2)
+	if ((r + step <= n) && (sum + tree[r + step] <= value)) {
+	    r += step;
+	    sum += tree[r];
+	}
+    *before = sum;
+    return (r);
+}
+
+/*	Function Name: BuildTrees
+ *	Description: Fills in the Fenwick trees of the line index.
+ *	Arguments: index - the line index.
+ *	Returns: none.
+ */
+
+static void
+BuildTrees(XawTextLineIndex * index)
+{
+    int i, j, n = index->num_regions;
+
+    for (i = 1; i <= n; i++) {
+	index->lengths[i] = index->regions[i - 1].length;
+	index->counts[i] = index->regions[i - 1].lines;
+    }
+    for (i = 1; i <= n; i++)
+	if ((j = i + (i & -i)) <= n) {
+	    index->lengths[j] += index->lengths[i];
+	    index->counts[j] += index->counts[i];
+	}
+}
+
+/*	Function Name: ReserveRegions
+ *	Description: Makes room for more regions in the line index.
+ *	Arguments: index - the line index.
+ *                 count - the number of regions to make room for.
+ *	Returns: none.
+ */
+
+static void
+ReserveRegions(XawTextLineIndex * index, int count)
+{
+    if (count <= index->size)
+	return;
+    while (index->size < count)
+	index->size = (index->size == 0) ? 64 : 2 * index->size;
+    index->regions = (IndexRegion *)
+	XtRealloc((char *) index->regions,
+		  (Cardinal) ((size_t) index->size * sizeof(IndexRegion)));
+    index->lengths = (XawTextPosition *)
+	XtRealloc((char *) index->lengths,
+		  (Cardinal) ((size_t) (index->size + 1) * sizeof(XawTextPosition)));
+    index->counts = (XawTextPosition *)
+	XtRealloc((char *) index->counts,
+		  (Cardinal) ((size_t) (index->size + 1) * sizeof(XawTextPosition)));
+}
+
+/*	Function Name: AppendRegion
+ *	Description: Adds a dirty region at the end of the line index.
+ *	Arguments: index - the line index.
+ *                 length - the length of the new region.
+ *	Returns: none.
+ */
+
+static void
+AppendRegion(XawTextLineIndex * index, XawTextPosition length)
+{
+    int n = index->num_regions + 1, low = n - (n & -n);
+
+    ReserveRegions(index, n);
+    index->regions[n - 1].length = length;
+    index->regions[n - 1].lines = 0;
+    index->regions[n - 1].widest = 0;
+    index->regions[n - 1].dirty = TRUE;
+    index->lengths[n] = length + TreeSum(index->lengths, n - 1)
+	- TreeSum(index->lengths, low);
+    index->counts[n] = TreeSum(index->counts, n - 1)
+	- TreeSum(index->counts, low);
+    index->num_regions = n;
+    index->num_dirty++;
+    index->end += length;
+}
+
+/*	Function Name: SplitRegion
+ *	Description: Splits a region of the line index into several.
+ *	Arguments: index - the line index.
+ *                 r - the region.
+ *                 starts - where the new regions after it start.
+ *                 count - the number of new regions.
+ *	Returns: none.
+ *
+ * NOTE: The new regions are dirty, and the lines of the region are shared
+ *       out among them as estimates.
+ */
+
+static void
+SplitRegion(XawTextLineIndex * index, int r, XawTextPosition * starts, int count)
+{
+    IndexRegion *region;
+    XawTextPosition start = TreeSum(index->lengths, r);
+    XawTextPosition end = start + index->regions[r].length;
+    int i, lines = index->regions[r].lines;
+
+    ReserveRegions(index, index->num_regions + count);
+    memmove(index->regions + r + 1 + count, index->regions + r + 1,
+	    (size_t) (index->num_regions - r - 1) * sizeof(IndexRegion));
+    index->num_regions += count;
+
+    index->regions[r].length = starts[0] - start;
+    index->regions[r].lines = Min(lines, INDEX_LINES);
+    lines -= index->regions[r].lines;
+    for (i = 0; i < count; i++) {
+	region = index->regions + r + 1 + i;
+	region->length = ((i + 1 < count) ? starts[i + 1] : end) - starts[i];
+	region->lines = (i + 1 < count) ? Min(lines, INDEX_LINES) : lines;
+	region->widest = index->regions[r].widest;
+	region->dirty = TRUE;
+	lines -= region->lines;
+    }
+    index->num_dirty += count;
+    BuildTrees(index);
+}
+
+/*	Function Name: DropEmptyRegions
+ *	Description: Removes the regions that edits left empty.
+ *	Arguments: index - the line index.
+ *	Returns: none.
+ */
+
+static void
+DropEmptyRegions(XawTextLineIndex * index)
+{
+    int r, n = 0;
+
+    for (r = 0; r < index->num_regions; r++)
+	if (index->regions[r].length > 0)
+	    index->regions[n++] = index->regions[r];
+	else if (index->regions[r].dirty)
+	    index->num_dirty--;
+    index->num_regions = n;
+    index->num_empty = 0;
+    index->next = 0;
+    BuildTrees(index);
+}
+
+/*	Function Name: SyncLineIndex
+ *	Description: Starts the line index again if the source was changed
+ *                   by someone else since it was last updated.
+ *	Arguments: ctx - the text widget.
+ *	Returns: none.
+ */
+
+static void
+SyncLineIndex(TextWidget ctx)
+{
+    XawTextLineIndex *index = ctx->text.line_index;
+
+    if ((index == NULL) || (index->changes == SrcChanges(ctx)))
+	return;
+    index->num_regions = index->num_dirty = index->num_empty = 0;
+    index->next = 0;
+    index->end = 0;
+    index->widest = 0;
+    index->changes = SrcChanges(ctx);
+}
+
+/*	Function Name: CountRegion
+ *	Description: Counts the display lines of a dirty region, after
+ *                   splitting off what follows its first INDEX_LINES
+ *                   source lines.
+ *	Arguments: ctx - the text widget.
+ *                 r - the region.
+ *	Returns: none.
+ */
+
+static void
+CountRegion(TextWidget ctx, int r)
+{
+    XawTextLineIndex *index = ctx->text.line_index;
+    XawTextPosition position, end, starts[INDEX_SPLIT];
+    int count = 0, lines, width = 0, widest = 0, old = index->regions[r].widest;
+
+    position = TreeSum(index->lengths, r);
+    end = position + index->regions[r].length;
+    starts[0] = SrcScan(ctx->text.source, position, XawstEOL, XawsdRight,
+			INDEX_LINES, TRUE);
+    while ((count < INDEX_SPLIT) && (starts[count] < end))
+	if (++count < INDEX_SPLIT)
+	    starts[count] = SrcScan(ctx->text.source, starts[count - 1],
+				    XawstEOL, XawsdRight, INDEX_LINES, TRUE);
+    if (count > 0) {
+	SplitRegion(index, r, starts, count);
+	end = starts[0];
+    }
+
+    for (lines = 0; position < end; lines++) {
+	position = NextLine(ctx, position, index->width,
+			    index->measure ? &width : (int *) NULL);
+	if (width > widest)
+	    widest = width;
+    }
+    TreeAdd(index->counts, index->num_regions, r,
+	    (XawTextPosition) (lines - index->regions[r].lines));
+    index->regions[r].lines = lines;
+    index->regions[r].widest = widest;
+    index->regions[r].dirty = FALSE;
+    index->num_dirty--;
+
+    if (index->widest < 0)
+	return;
+    if (widest > index->widest)
+	index->widest = widest;
+    else if ((old >= index->widest) && (widest < old))
+	index->widest = -1;	/* The widest line may be gone. */
+}
+
+/*	Function Name: CountLines
+ *	Description: The work procedure that fills in the line index.
+ *	Arguments: closure - the text widget.
+ *	Returns: TRUE when all display lines are counted.
+ */
+
+static Boolean
+CountLines(XtPointer closure)
+{
+    TextWidget ctx = (TextWidget) closure;
+    XawTextLineIndex *index = ctx->text.line_index;
+    int steps;
+
+    SyncLineIndex(ctx);
+    if (index->num_empty > 0)
+	DropEmptyRegions(index);
+
+    for (steps = 0; steps < INDEX_STEPS; steps++) {
+	while ((index->next < index->num_regions) &&
+	       !index->regions[index->next].dirty)
+	    index->next++;
+
+	if (index->next < index->num_regions)
+	    CountRegion(ctx, index->next);
+	else if (index->end < ctx->text.lastPos)
+	    AppendRegion(index, SrcScan(ctx->text.source, index->end, XawstEOL,
+					XawsdRight, INDEX_LINES, TRUE)
+			 - index->end);
+	else {
+	    index->work = 0;	/* Show the thumb in counted lines. */
+	    _XawTextPrepareToUpdate(ctx);
+	    _XawTextSetScrollBars(ctx);
+	    _XawTextExecuteUpdate(ctx);
+	    return (TRUE);
+	}
+    }
+    return (FALSE);
+}
+
+/*	Function Name: LineIndexDone
+ *	Description: Checks if the display lines of the whole text are
+ *                   known, if only as estimates for edited regions, and
+ *                   starts to count those that are not.
+ *	Arguments: ctx - the text widget.
+ *	Returns: TRUE if the line index covers the text.
+ */
+
+static Boolean
+LineIndexDone(TextWidget ctx)
+{
+    XawTextLineIndex *index = ctx->text.line_index;
+    int r, width = WrapWidth(ctx);
+    Boolean measure = (ctx->text.scroll_horiz != XawtextScrollNever);
+
+    SyncLineIndex(ctx);
+    if (index == NULL) {
+	ctx->text.line_index = index = XtNew(XawTextLineIndex);
+	(void) bzero((char *) index, sizeof(XawTextLineIndex));
+	index->width = width;
+	index->wrap = ctx->text.wrap;
+	index->measure = measure;
+	index->changes = SrcChanges(ctx);
+    } else if ((index->width != width) || (index->wrap != ctx->text.wrap) ||
+	       (index->measure != measure)) {
+	for (r = 0; r < index->num_regions; r++)
+	    index->regions[r].dirty = TRUE;
+	index->num_dirty = index->num_regions;
+	index->next = 0;
+	index->width = width;
+	index->wrap = ctx->text.wrap;
+	index->measure = measure;
+	index->widest = -1;
+    }
+
+    if (((index->num_dirty > 0) || (index->end < ctx->text.lastPos)) &&
+	(index->work == 0))
+	index->work = XtAppAddWorkProc(XtWidgetToApplicationContext((Widget) ctx),
+				       CountLines, (XtPointer) ctx);
+    return (index->end >= ctx->text.lastPos);
+}
+
+/*	Function Name: IndexLines
+ *	Description: Counts the display lines before a position.
+ *	Arguments: ctx - the text widget.
+ *                 position - the position.
+ *	Returns: the number of display lines that start before position.
+ *
+ * NOTE: This function requires a line index that covers the text.
+ */
+
+static int
+IndexLines(TextWidget ctx, XawTextPosition position)
+{
+    XawTextLineIndex *index = ctx->text.line_index;
+    XawTextPosition pos;
+    int r, lines;
+
+    r = TreeFind(index->lengths, index->num_regions, position, &pos);
+    lines = (int) TreeSum(index->counts, r);
+    if (r < index->num_regions)
+	for (; pos < position; lines++)
+	    pos = NextLine(ctx, pos, index->width, (int *) NULL);
+    return (lines);
+}
+
+/*	Function Name: IndexTotal
+ *	Description: Counts all display lines.
+ *	Arguments: ctx - the text widget.
+ *	Returns: the number of display lines, at least one.
+ *
+ * NOTE: This function requires a line index that covers the text.
+ */
+
+static int
+IndexTotal(TextWidget ctx)
+{
+    XawTextLineIndex *index = ctx->text.line_index;
+    XawTextPosition lastPos = ctx->text.lastPos;
+    int lines = (int) TreeSum(index->counts, index->num_regions);
+
+    /* An empty line at the end is shown too. */
+    if ((lastPos == 0) ||
+	(SrcScan(ctx->text.source, lastPos, XawstEOL, XawsdLeft, 1, FALSE) ==
+	 lastPos))
+	lines++;
+    return (Max(lines, 1));
+}
+
+/*	Function Name: IndexWidest
+ *	Description: Finds the width of the widest line.
+ *	Arguments: ctx - the text widget.
+ *	Returns: the width of the widest line of the text.
+ *
+ * NOTE: This function requires a line index that covers the text.
+ */
+
+static int
+IndexWidest(TextWidget ctx)
+{
+    XawTextLineIndex *index = ctx->text.line_index;
+    int r;
+
+    if (index->widest < 0)
+	for (r = 0, index->widest = 0; r < index->num_regions; r++)
+	    if (index->widest < index->regions[r].widest)
+		index->widest = index->regions[r].widest;
+    return (index->widest);
+}
+
+/*	Function Name: IndexPosition
+ *	Description: Finds the start of a display line.
+ *	Arguments: ctx - the text widget.
+ *                 line - the number of the display line, from 0.
+ *	Returns: the position the line starts at.
+ *
+ * NOTE: This function requires a line index that covers the text.
+ */
+
+static XawTextPosition
+IndexPosition(TextWidget ctx, int line)
+{
+    XawTextLineIndex *index = ctx->text.line_index;
+    XawTextPosition position, end, before;
+    int r;
+
+    r = TreeFind(index->counts, index->num_regions, (XawTextPosition) line,
+		 &before);
+    if (r == index->num_regions)
+	return (ctx->text.lastPos);
+
+    position = TreeSum(index->lengths, r);
+    end = position + index->regions[r].length;
+    for (line -= (int) before; (line > 0) && (position < end); line--)
+	position = NextLine(ctx, position, index->width, (int *) NULL);
+    return (Min(position, end));
+}
+
+/*	Function Name: UpdateLineIndex
+ *	Description: Fixes the line index after an edit.
+ *	Arguments: ctx - the text widget.
+ *                 pos1, pos2 - the text that was replaced.
+ *                 delta - the change of the text length.
+ *                 removed - the newlines in the text that was replaced.
+ *	Returns: none.
+ *
+ * NOTE: ctx->text.lastPos must still be the end of the text before the
+ *       edit, and SyncLineIndex() must have been called before it.
+ */
+
+static void
+UpdateLineIndex(TextWidget ctx, XawTextPosition pos1, XawTextPosition pos2,
+		int delta, int removed)
+{
+    XawTextLineIndex *index = ctx->text.line_index;
+    IndexRegion *region;
+    XawTextPosition start;
+    int i, r, last, lines;
+
+    if (index == NULL)
+	return;
+    index->changes = SrcChanges(ctx);
+
+    if ((pos2 > index->end) ||
+	((pos1 == index->end) && (index->end < ctx->text.lastPos))) {
+	/*
+	 * The edit reaches into the text that is not counted yet, it is
+	 * counted from the region the edit starts in on.
+	 */
+	r = TreeFind(index->lengths, index->num_regions, pos1, &start);
+	for (i = r; i < index->num_regions; i++)
+	    if (index->regions[i].dirty)
+		index->num_dirty--;
+	index->num_regions = r;
+	index->end = start;
+	index->next = Min(index->next, r);
+	return;
+    }
+    if (index->end == 0)
+	return;
+
+    /*
+     * The edit goes into the region it starts in, text appended to the
+     * end into the last one. Regions that start in the edit may not
+     * start a line any more, they are joined with it.
+     */
+    r = TreeFind(index->lengths, index->num_regions,
+		 Min(pos1, index->end - 1), &start);
+    last = (pos2 < index->end)
+	? TreeFind(index->lengths, index->num_regions, pos2, &start)
+	: index->num_regions - 1;
+    region = index->regions + r;
+    lines = CountNewlines(ctx, pos1, pos2 + delta) - removed;
+    for (i = r + 1; i <= last; i++) {
+	if (index->regions[i].length == 0)
+	    continue;
+	lines += index->regions[i].lines;
+	region->length += index->regions[i].length;
+	region->widest = Max(region->widest, index->regions[i].widest);
+	TreeAdd(index->lengths, index->num_regions, r,
+		index->regions[i].length);
+	TreeAdd(index->lengths, index->num_regions, i,
+		-index->regions[i].length);
+	TreeAdd(index->counts, index->num_regions, i,
+		-(XawTextPosition) index->regions[i].lines);
+	if (index->regions[i].dirty)
+	    index->num_dirty--;
+	index->regions[i].length = 0;
+	index->regions[i].lines = 0;
+	index->regions[i].dirty = FALSE;
+	index->num_empty++;
+    }
+    lines = Max(region->lines + lines, (region->length + delta > 0) ? 1 : 0)
+	- region->lines;
+    region->length += delta;
+    region->lines += lines;
+    TreeAdd(index->lengths, index->num_regions, r, (XawTextPosition) delta);
+    TreeAdd(index->counts, index->num_regions, r, (XawTextPosition) lines);
+    if (!region->dirty) {
+	region->dirty = TRUE;
+	index->num_dirty++;
+    }
+    index->next = Min(index->next, r);
+    index->end += delta;
+}
+
+/*	Function Name: ForgetLineIndex
+ *	Description: Frees the line index.
+ *	Arguments: ctx - the text widget.
+ *	Returns: none.
+ */
+
+static void
+ForgetLineIndex(TextWidget ctx)
+{
+    XawTextLineIndex *index = ctx->text.line_index;
+
+    if (index == NULL)
+	return;
+    if (index->work != 0)
+	XtRemoveWorkProc(index->work);
+    XtFree((char *) index->regions);
+    XtFree((char *) index->lengths);
+    XtFree((char *) index->counts);
+    XtFree((char *) index);
+    ctx->text.line_index = NULL;
+}
+
 /*	Function Name: GetWidestLine
- *	Description: Returns the width (in pixels) of the widest line that
- *                   is currently visable.
+ *	Description: Returns the width (in pixels) of the widest line of
+ *                   the text, or that is currently visable until the
+ *                   line index has measured all lines.
  *	Arguments: ctx - the text widget.
  *	Returns: the width of the widest line.
  *
@@ -1089,6 +1859,10 @@ GetWidestLine(TextWidget ctx)
 	if (widest < lt->info[i].textWidth)
 	    widest = lt->info[i].textWidth;
 
+    if ((ctx->text.scroll_horiz != XawtextScrollNever) && LineIndexDone(ctx)
+	&& (widest < IndexWidest(ctx)))
+	widest = (Dimension) Min(IndexWidest(ctx), BIGNUM);
+
     return (widest);
 }
 
@@ -1102,13 +1876,23 @@ CheckVBarScrolling(TextWidget ctx)
 	return;
 
     if ((ctx->text.lastPos > 0) && (ctx->text.lt.lines > 0)) {
-	first = (float) ctx->text.lt.top;
-	first /= (float) ctx->text.lastPos;
-	last = (float) ctx->text.lt.info[ctx->text.lt.lines].position;
-	if (ctx->text.lt.info[ctx->text.lt.lines].position < ctx->text.lastPos)
-	    last /= (float) ctx->text.lastPos;
-	else
-	    last = 1.0;
+	if (LineIndexDone(ctx)) {
+	    int total = IndexTotal(ctx);
+	    int top = IndexLines(ctx, ctx->text.lt.top);
+
+	    first = (float) top / (float) total;
+	    last = (float) (top + ctx->text.lt.lines) / (float) total;
+	    if (last > 1.0)
+		last = 1.0;
+	} else {		/* Until the lines are counted. */
+	    first = (float) ctx->text.lt.top;
+	    first /= (float) ctx->text.lastPos;
+	    last = (float) ctx->text.lt.info[ctx->text.lt.lines].position;
+	    if (ctx->text.lt.info[ctx->text.lt.lines].position < ctx->text.lastPos)
+		last /= (float) ctx->text.lastPos;
+	    else
+		last = 1.0;
+	}
 
 	if (ctx->text.scroll_vert == XawtextScrollWhenNeeded) {
 	    int line;
@@ -1498,8 +2282,16 @@ VJump(
     else
 	old_bot = ctx->text.lastPos;
 
-    position = (long) (*percent * (float) ctx->text.lastPos);
-    position = SrcScan(ctx->text.source, position, XawstEOL, XawsdLeft, 1, FALSE);
+    if (LineIndexDone(ctx)) {	/* Jump to a display line. */
+	int total = IndexTotal(ctx);
+	int line = (int) (*percent * (float) total);
+
+	position = IndexPosition(ctx, Min(line, total - 1));
+    } else {
+	position = (long) (*percent * (float) ctx->text.lastPos);
+	position = SrcScan(ctx->text.source, position, XawstEOL, XawsdLeft, 1,
+			   FALSE);
+    }
     if ((position >= old_top) && (position <= old_bot)) {
 	int line = 0;
 	for (; (line < lt->lines) && (position > lt->info[line].position);
@@ -1994,7 +2786,7 @@ _XawTextReplace(
 		   XawTextPosition pos2,
 		   XawTextBlock * text)
 {
-    int i, line1, delta, error;
+    int i, line1, delta, error, removed = 0;
     XawTextPosition updateFrom, updateTo;
     Widget src = ctx->text.source;
     XawTextEditType edit_mode;
@@ -2025,10 +2817,15 @@ _XawTextReplace(
     updateFrom = Max(updateFrom, ctx->text.lt.top);
 
     line1 = LineForPosition(ctx, updateFrom);
+    SyncLineIndex(ctx);
+    if (ctx->text.line_index != NULL)
+	removed = CountNewlines(ctx, pos1, pos2);
     if ((error = SrcReplace(src, pos1, pos2, text)) != 0) {
 	ctx->text.update_disabled = tmp;	/* restore redisplay */
 	return (error);
     }
+    UpdateLineIndex(ctx, pos1, pos2, (int) (text->length - (pos2 - pos1)),
+		    removed);
 
     XawTextUnsetSelection((Widget) ctx);
 
@@ -2044,13 +2841,31 @@ _XawTextReplace(
 
     delta = (int) (text->length - (pos2 - pos1));
 
-    if (delta < ctx->text.lastPos) {
-	for (pos2 += delta, i = 0; i < ctx->text.numranges; i++) {
-	    if (ctx->text.updateFrom[i] > pos1)
+    if (ctx->text.update_timer != 0) {	/* Keep the top line where it is. */
+	if (ctx->text.lt.top >= pos2)
+	    ctx->text.lt.top += delta;
+	else if (ctx->text.lt.top > pos1)
+	    ctx->text.lt.top = SrcScan(src, pos1, XawstEOL, XawsdLeft, 1, FALSE);
+	ctx->text.damage = Min(ctx->text.damage, pos1);
+    }
+
+    if (delta < ctx->text.lastPos) {	/* Ends in removed text move to pos1. */
+	for (i = 0; i < ctx->text.numranges; i++) {
+	    if (ctx->text.updateFrom[i] >= pos2)
 		ctx->text.updateFrom[i] += delta;
-	    if (ctx->text.updateTo[i] >= pos1)
+	    else if (ctx->text.updateFrom[i] > pos1)
+		ctx->text.updateFrom[i] = pos1;
+	    if (ctx->text.updateTo[i] >= pos2)
 		ctx->text.updateTo[i] += delta;
+	    else if (ctx->text.updateTo[i] > pos1)
+		ctx->text.updateTo[i] = pos1 + text->length;
 	}
+	MergeUpdates(ctx);
+    }
+
+    if (ctx->text.update_timer != 0) {	/* ShowReplaced() does the rest. */
+	ctx->text.update_disabled = tmp;
+	return (0);
     }
 
     /*
@@ -2073,8 +2888,8 @@ _XawTextReplace(
      */
 
     if (IsPositionVisible(ctx, updateFrom)) {
-	updateTo = _BuildLineTable(ctx,
-				   ctx->text.lt.info[line1].position, pos1, line1);
+	updateTo = _BuildLineTable(ctx, ctx->text.lt.info[line1].position,
+				   pos1 + text->length, line1);
 	_XawTextNeedsUpdating(ctx, updateFrom, updateTo);
     }
 
@@ -2710,6 +3525,35 @@ ProcessExposeRegion(Widget w, XEvent *event, Region region GCC_UNUSED)
     _XawTextExecuteUpdate(ctx);
 }
 
+/*
+ * Displays what XawTextReplace() changed while the widget has an updateRate:
+ * the line table is built again, and the text is displayed from the first
+ * change on.
+ */
+
+static void
+ShowReplaced(TextWidget ctx)
+{
+    XawTextPosition from;
+
+    ctx->text.update_timer = 0;
+    _XawTextBuildLineTable(ctx, FindGoodPosition(ctx, ctx->text.lt.top), TRUE);
+    from = SrcScan(ctx->text.source, FindGoodPosition(ctx, ctx->text.damage),
+		   XawstWhiteSpace, XawsdLeft, 1, FALSE);
+    _XawTextNeedsUpdating(ctx, Max(from, ctx->text.lt.top), ctx->text.lastPos);
+
+    _XawTextCheckResize(ctx);
+    _XawTextExecuteUpdate(ctx);
+    _XawTextSetScrollBars(ctx);
+}
+
+/* ARGSUSED */
+static void
+ReplaceTimeout(XtPointer closure, XtIntervalId * id GCC_UNUSED)
+{
+    ShowReplaced((TextWidget) closure);
+}
+
 /*
  * This routine does all setup required to syncronize batched screen updates
  */
@@ -2717,6 +3561,10 @@ ProcessExposeRegion(Widget w, XEvent *event, Region region GCC_UNUSED)
 void
 _XawTextPrepareToUpdate(TextWidget ctx)
 {
+    if (ctx->text.update_timer != 0) {	/* Show the replaced text first. */
+	XtRemoveTimeOut(ctx->text.update_timer);
+	ShowReplaced(ctx);
+    }
     if (ctx->text.old_insert < 0) {
 	InsertCursor((Widget) ctx, XawisOff);
 	ctx->text.numranges = 0;
@@ -2727,43 +3575,38 @@ _XawTextPrepareToUpdate(TextWidget ctx)
 
 /*
  * This is a private utility routine used by _XawTextExecuteUpdate. It
- * processes all the outstanding update requests and merges update
- * ranges where possible.
+ * processes all the outstanding update requests.  Ranges that start on the
+ * line where the range before them ends, or on the line after it, are
+ * displayed together with it.
  */
 
 static
 void
 FlushUpdate(TextWidget ctx)
 {
-    int i, w;
-    XawTextPosition updateFrom, updateTo;
+    int i, line = 0;
+    XawTextPosition updateFrom, updateTo, next;
+    XawTextLineTable *lt = &(ctx->text.lt);
+
     if (!XtIsRealized((Widget) ctx)) {
 	ctx->text.numranges = 0;
 	return;
     }
-    while (ctx->text.numranges > 0) {
-	updateFrom = ctx->text.updateFrom[0];
-	w = 0;
-	for (i = 1; i < ctx->text.numranges; i++) {
-	    if (ctx->text.updateFrom[i] < updateFrom) {
-		updateFrom = ctx->text.updateFrom[i];
-		w = i;
-	    }
-	}
-	updateTo = ctx->text.updateTo[w];
-	ctx->text.numranges--;
-	ctx->text.updateFrom[w] = ctx->text.updateFrom[ctx->text.numranges];
-	ctx->text.updateTo[w] = ctx->text.updateTo[ctx->text.numranges];
-	for (i = ctx->text.numranges - 1; i >= 0; i--) {
-	    while (ctx->text.updateFrom[i] <= updateTo && i < ctx->text.numranges) {
-		updateTo = ctx->text.updateTo[i];
-		ctx->text.numranges--;
-		ctx->text.updateFrom[i] = ctx->text.updateFrom[ctx->text.numranges];
-		ctx->text.updateTo[i] = ctx->text.updateTo[ctx->text.numranges];
-	    }
+    for (i = 0; i < ctx->text.numranges;) {
+	updateFrom = ctx->text.updateFrom[i];
+	updateTo = ctx->text.updateTo[i++];
+	while ((i < ctx->text.numranges) && (lt->lines > 0) &&
+	       (updateTo >= lt->top)) {
+	    while ((line < lt->lines) && (lt->info[line + 1].position <= updateTo))
+		line++;
+	    next = lt->info[Min(line + 2, lt->lines)].position;
+	    if (ctx->text.updateFrom[i] >= next)
+		break;
+	    updateTo = ctx->text.updateTo[i++];
 	}
 	DisplayText((Widget) ctx, updateFrom, updateTo);
     }
+    ctx->text.numranges = 0;
 }
 
 /*
@@ -2886,9 +3729,17 @@ TextDestroy(Widget w)
 
     XtFree((char *) ctx->text.s.selections);
     XtFree((char *) ctx->text.lt.info);
+    XtFree((char *) ctx->text.old_info);
+    if (ctx->text.update_timer != 0)
+	XtRemoveTimeOut(ctx->text.update_timer);
+    if (ctx->text.search != NULL) {
+	XawTextSourceFreeSearch(ctx->text.search->pattern);
+	XtFree(ctx->text.search->pattern_text);
+    }
     XtFree((char *) ctx->text.search);
     XtFree((char *) ctx->text.updateFrom);
     XtFree((char *) ctx->text.updateTo);
+    ForgetLineIndex(ctx);
 }
 
 /*
@@ -2963,6 +3814,10 @@ SetValues(Widget current,
 	redisplay = TRUE;
     }
 
+    if ((newtw->text.scroll_vert == XawtextScrollNever) &&
+	(newtw->text.scroll_horiz == XawtextScrollNever))
+	ForgetLineIndex(newtw);
+
     if (oldtw->text.source != newtw->text.source)
 	XawTextSetSource((Widget) newtw, newtw->text.source, newtw->text.lt.top);
 
@@ -2976,6 +3831,9 @@ SetValues(Widget current,
 	oldtw->text.r_margin.top != newtw->text.r_margin.top ||
 	oldtw->text.sink != newtw->text.sink ||
 	newtw->text.redisplay_needed) {
+	if (oldtw->text.sink != newtw->text.sink ||
+	    newtw->text.redisplay_needed)
+	    ForgetLineIndex(newtw);	/* The fonts may have changed. */
 	_XawTextBuildLineTable(newtw, newtw->text.lt.top, TRUE);
 	redisplay = TRUE;
     }
@@ -3226,6 +4084,7 @@ XawTextSetSource(Widget w, Widget source, XawTextPosition startPos)
     ctx->text.s.left = ctx->text.s.right = 0;
     ctx->text.insertPos = startPos;
     ctx->text.lastPos = GETLASTPOS;
+    ForgetLineIndex(ctx);
 
     _XawTextBuildLineTable(ctx, ctx->text.lt.top, TRUE);
     XawTextDisplay(w);
@@ -3236,6 +4095,9 @@ XawTextSetSource(Widget w, Widget source, XawTextPosition startPos)
  * then inserts, at startPos, the text that was passed. As a side effect it
  * "invalidates" that portion of the displayed text (if any), so that things
  * will be repainted properly.
+ *
+ * If the widget has an updateRate, the text is displayed by a timer, once
+ * for all replacements until it expires.
  */
 
 int
@@ -3244,8 +4106,26 @@ XawTextReplace(Widget w, XawTextPosition startPos, XawTextPosition endPos,
 {
     TextWidget ctx = (TextWidget) w;
     int result;
+    Boolean defer = (ctx->text.update_rate > 0) && XtIsRealized(w);
 
-    _XawTextPrepareToUpdate(ctx);
+    /*
+     * _XawTextReplace() unsets the selection, and LoseSelection() would
+     * show the pending replacements in the middle of this one. Unset it
+     * before the timer is armed; any later selection shows them first.
+     */
+    if (defer)
+	XawTextUnsetSelection(w);
+
+    if (!defer || (ctx->text.update_timer == 0)) {
+	_XawTextPrepareToUpdate(ctx);
+	if (defer) {
+	    ctx->text.damage = ctx->text.lastPos;
+	    ctx->text.update_timer =
+		XtAppAddTimeOut(XtWidgetToApplicationContext(w),
+				(unsigned long) Max(1, 1000 / ctx->text.update_rate),
+				ReplaceTimeout, (XtPointer) ctx);
+	}
+    }
     endPos = FindGoodPosition(ctx, endPos);
     startPos = FindGoodPosition(ctx, startPos);
     if ((result = _XawTextReplace(ctx, startPos, endPos, text)) == XawEditDone) {
@@ -3256,6 +4136,8 @@ XawTextReplace(Widget w, XawTextPosition startPos, XawTextPosition endPos,
 					  XawstPositions, sd, abs(delta), TRUE);
 	}
     }
+    if (ctx->text.update_timer != 0)
+	return result;
 
     _XawTextCheckResize(ctx);
     _XawTextExecuteUpdate(ctx);
@@ -3264,6 +4146,191 @@ XawTextReplace(Widget w, XawTextPosition startPos, XawTextPosition endPos,
     return result;
 }
 
+/*
+ * Orders the edits for XawTextReplaceMany() by position, and edits at the
+ * same position as they were passed.
+ */
+
+static int
+CompareEdits(const void *a, const void *b)
+{
+    XawTextEdit *edit1 = *(XawTextEdit * const *) a;
+    XawTextEdit *edit2 = *(XawTextEdit * const *) b;
+
+    if (edit1->startPos != edit2->startPos)
+	return ((edit1->startPos < edit2->startPos) ? -1 : 1);
+    return ((edit1 < edit2) ? -1 : (edit1 > edit2) ? 1 : 0);
+}
+
+/*
+ * This public routine applies a number of edits like XawTextReplace(), but
+ * fixes the line table and redisplays the text only once, over the range
+ * of text that was changed.  The positions of all edits refer to the text
+ * before any of them is made, and the edits must not overlap.  They are
+ * clamped and, in XawtextAppend mode, moved to the end of the text as by
+ * XawTextReplace(), and all of them are checked before any is made.  They
+ * are then made from the end of the text backward; if the source refuses
+ * one, the edits before it are not made, its index is stored in *failed
+ * and its error is returned.  *failed is -1 if no edit was refused.
+ */
+
+int
+XawTextReplaceMany(Widget w, XawTextEdit * edits, int num_edits, int *failed)
+{
+    TextWidget ctx = (TextWidget) w;
+    Widget src = ctx->text.source;
+    XawTextEdit *copy, **order;
+    XawTextLineTableEntry *lineP;
+    XawTextPosition from, to, top, insert, updateFrom, updateTo;
+    XawTextEditType edit_mode;
+    Arg args[1];
+    Boolean visible;
+    int i, line1, delta, removed = 0, error = XawEditDone;
+
+    if (failed != NULL)
+	*failed = -1;
+    if (num_edits <= 0)
+	return (XawEditDone);
+
+    XtSetArg(args[0], XtNeditType, &edit_mode);
+    XtGetValues(src, args, ONE);
+    insert = ctx->text.insertPos;
+
+    /*
+     * Check the edits on a copy, so that the caller's positions are kept.
+     */
+    copy = (XawTextEdit *)
+	XtMalloc((Cardinal) ((size_t) num_edits * sizeof(XawTextEdit)));
+    order = (XawTextEdit **)
+	XtMalloc((Cardinal) ((size_t) num_edits * sizeof(XawTextEdit *)));
+    for (i = 0; i < num_edits; i++) {
+	copy[i] = edits[i];
+	if ((edit_mode == XawtextAppend) &&
+	    (copy[i].startPos == ctx->text.insertPos)) {
+	    copy[i].startPos = copy[i].endPos = insert = ctx->text.lastPos;
+	    if (copy[i].text.length == 0)
+		error = XawEditError;
+	} else if (copy[i].endPos >= copy[i].startPos) {
+	    copy[i].startPos = FindGoodPosition(ctx, copy[i].startPos);
+	    copy[i].endPos = FindGoodPosition(ctx, copy[i].endPos);
+	} else
+	    error = XawPositionError;
+	if (error != XawEditDone) {
+	    if (failed != NULL)
+		*failed = i;
+	    XtFree((char *) copy);
+	    XtFree((char *) order);
+	    return (error);
+	}
+	order[i] = copy + i;
+    }
+    qsort(order, (size_t) num_edits, sizeof(XawTextEdit *), CompareEdits);
+    for (i = 1; i < num_edits; i++) {
+	if (order[i]->startPos < order[i - 1]->endPos) {
+	    if (failed != NULL)
+		*failed = (int) (order[i] - copy);
+	    XtFree((char *) copy);
+	    XtFree((char *) order);
+	    return (XawPositionError);
+	}
+    }
+
+    _XawTextPrepareToUpdate(ctx);
+    from = order[0]->startPos;
+    to = order[num_edits - 1]->endPos;
+    top = ctx->text.lt.top;
+
+    updateFrom = SrcScan(src, from, XawstWhiteSpace, XawsdLeft, 1, FALSE);
+    updateFrom = Max(updateFrom, ctx->text.lt.top);
+    line1 = LineForPosition(ctx, updateFrom);
+    visible = IsPositionVisible(ctx, updateFrom);
+    SyncLineIndex(ctx);
+    if (ctx->text.line_index != NULL)
+	removed = CountNewlines(ctx, from, to);
+
+    for (i = num_edits - 1; i >= 0; i--) {
+	XawTextEdit *edit = order[i];
+	int d;
+
+	if ((error = SrcReplace(src, edit->startPos, edit->endPos,
+				&edit->text)) != XawEditDone) {
+	    if (failed != NULL)
+		*failed = (int) (edit - copy);
+	    break;
+	}
+	d = (int) (edit->text.length - (edit->endPos - edit->startPos));
+	if (insert >= edit->endPos)
+	    insert += d;
+	else if (insert > edit->startPos)
+	    insert = edit->startPos;
+	if (top >= edit->endPos)
+	    top += d;
+	else if (top > edit->startPos)
+	    top = SrcScan(src, edit->startPos, XawstEOL, XawsdLeft, 1, FALSE);
+    }
+    XtFree((char *) order);
+    XtFree((char *) copy);
+
+    /*
+     * A source that runs out of room may have made part of the refused
+     * edit, so the change in length is taken from the source.
+     */
+    delta = (int) (GETLASTPOS - ctx->text.lastPos);
+    if ((i == num_edits - 1) && (delta == 0)) {	/* Nothing was changed. */
+	_XawTextExecuteUpdate(ctx);
+	return (error);
+    }
+    UpdateLineIndex(ctx, from, to, delta, removed);
+
+    XawTextUnsetSelection(w);
+    ctx->text.lastPos = GETLASTPOS;
+    ctx->text.insertPos = FindGoodPosition(ctx, insert);
+    ctx->text.single_char = FALSE;
+
+    for (i = 0; i < ctx->text.numranges; i++) {
+	if (ctx->text.updateFrom[i] >= to)
+	    ctx->text.updateFrom[i] += delta;
+	else if (ctx->text.updateFrom[i] > from)
+	    ctx->text.updateFrom[i] = from;
+	if (ctx->text.updateTo[i] >= to)
+	    ctx->text.updateTo[i] += delta;
+	else if (ctx->text.updateTo[i] > from)
+	    ctx->text.updateTo[i] = to + delta;
+    }
+    MergeUpdates(ctx);
+
+    if ((top != ctx->text.lt.top) || (ctx->text.lt.top >= ctx->text.lastPos)) {
+	/*
+	 * Text above the window was changed, display it all again.
+	 */
+	_XawTextBuildLineTable(ctx, FindGoodPosition(ctx, top), TRUE);
+	ClearWindow(w);
+	_XawTextNeedsUpdating(ctx, zeroPosition, ctx->text.lastPos);
+    } else if (visible) {
+	/*
+	 * Lines that start after the edits move with the text behind them,
+	 * lines that started inside them are gone.  The line table is then
+	 * rebuilt from the first edited line until it meets an old line.
+	 */
+	for (i = line1 + 1, lineP = ctx->text.lt.info + i;
+	     i <= ctx->text.lt.lines; i++, lineP++) {
+	    if (lineP->position >= to)
+		lineP->position += delta;
+	    else if (lineP->position > from)
+		lineP->position = -1;
+	}
+	updateTo = _BuildLineTable(ctx, ctx->text.lt.info[line1].position,
+				   to + delta, line1);
+	_XawTextNeedsUpdating(ctx, updateFrom, updateTo);
+    }
+
+    _XawTextCheckResize(ctx);
+    _XawTextExecuteUpdate(ctx);
+    _XawTextSetScrollBars(ctx);
+
+    return (error);
+}
+
 XawTextPosition
 XawTextTopPosition(Widget w)
 {
@@ -3275,6 +4342,12 @@ XawTextSetInsertionPoint(Widget w, XawTextPosition position)
 {
     TextWidget ctx = (TextWidget) w;
 
+    if (ctx->text.update_timer != 0) {	/* ShowReplaced() shows it. */
+	ctx->text.insertPos = FindGoodPosition(ctx, position);
+	ctx->text.showposition = TRUE;
+	return;
+    }
+
     _XawTextPrepareToUpdate(ctx);
     ctx->text.insertPos = FindGoodPosition(ctx, position);
     ctx->text.showposition = TRUE;
@@ -3330,6 +4403,7 @@ XawTextInvalidate(Widget w, XawTextPosition from, XawTextPosition to)
     from = FindGoodPosition(ctx, from);
     to = FindGoodPosition(ctx, to);
     ctx->text.lastPos = GETLASTPOS;
+    ForgetLineIndex(ctx);
     _XawTextPrepareToUpdate(ctx);
     _XawTextNeedsUpdating(ctx, from, to);
     _XawTextBuildLineTable(ctx, ctx->text.lt.top, TRUE);
@@ -3355,6 +4429,7 @@ XawTextEnableRedisplay(Widget w)
 
     ctx->text.update_disabled = False;
     lastPos = ctx->text.lastPos = GETLASTPOS;
+    SyncLineIndex(ctx);		/* If the source was changed directly. */
     ctx->text.lt.top = FindGoodPosition(ctx, ctx->text.lt.top);
     ctx->text.insertPos = FindGoodPosition(ctx, ctx->text.insertPos);
     if ((ctx->text.s.left > lastPos) || (ctx->text.s.right > lastPos))
@@ -3408,6 +4483,28 @@ XawTextSearch(Widget w,
 
     return (SrcSearch(ctx->text.source, ctx->text.insertPos, dir, text));
 }
+
+/*	Function Name: XawTextSearchCompiled(w, dir, pattern, end_return).
+ *	Description: searches for a pattern from XawTextSourceCompileSearch.
+ *	Arguments: w - The text widget.
+ *                 dir - The direction to search.
+ *                 pattern - The pattern to search for.
+ * RETURNED        end_return - The end of the text found, may be NULL.
+ *	Returns: The position of the text found, or XawTextSearchError on
+ *               an error.
+ */
+
+XawTextPosition
+XawTextSearchCompiled(Widget w,
+		      XawTextScanDirection dir,
+		      XawTextSearchPattern pattern,
+		      XawTextPosition * end_return)
+{
+    TextWidget ctx = (TextWidget) w;
+
+    return (XawTextSourceSearchCompiled(ctx->text.source, ctx->text.insertPos,
+					dir, pattern, end_return));
+}
 /* *INDENT-OFF* */
 TextClassRec textClassRec = {
   { /* core fields */
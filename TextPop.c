@@ -115,6 +115,14 @@ static Widget CreateDialog(Widget /* parent */
 static Widget GetShell(Widget /* w */ );
 static void SetWMProtocolTranslations(Widget /* w */ );
 static Boolean DoSearch(struct SearchAndReplace * /* search */ );
+static Boolean GetSearchPattern(struct SearchAndReplace * /* search */
+				, XawTextBlock * /* text */
+				, XawTextSearchPattern * /* pattern_return */ );
+static XawTextPosition SearchText(struct SearchAndReplace * /* search */
+				  , XawTextScanDirection /* dir */
+				  , XawTextBlock * /* text */
+				  , XawTextSearchPattern /* pattern */
+				  , XawTextPosition * /* end_return */ );
 static Boolean SetResourceByName(Widget /* shell */
 				 , char * /* name */
 				 , char * /* res_name */
@@ -122,6 +130,14 @@ static Boolean SetResourceByName(Widget /* shell */
 static Boolean Replace(struct SearchAndReplace * /* search */
 		       , Boolean /* once_only */
 		       , Boolean /* show_current */ );
+static Boolean ReplaceAll(struct SearchAndReplace * /* search */
+			  , XawTextScanDirection /* dir */
+			  , XawTextBlock * /* find */
+			  , XawTextSearchPattern /* pattern */
+			  , XawTextBlock * /* replace */
+			  , XawTextPosition /* pos */
+			  , XawTextPosition /* end_pos */ );
+static void ReplaceFailed(struct SearchAndReplace * /* search */ );
 static char *GetString(Widget /* tw */ );
 static char *GetStringRaw(Widget /* tw */ );
 static void AddInsertFileChildren(Widget /* form */
@@ -616,6 +632,10 @@ _XawTextSearch(
 
     if (ctx->text.search == NULL) {
 	ctx->text.search = XtNew(struct SearchAndReplace);
+	ctx->text.search->pattern = NULL;
+	ctx->text.search->pattern_source = NULL;
+	ctx->text.search->pattern_options = 0;
+	ctx->text.search->pattern_text = NULL;
 	ctx->text.search->search_popup = CreateDialog(w, ptr, "search",
 						      AddSearchChildren);
 	XtRealizeWidget(ctx->text.search->search_popup);
@@ -749,6 +769,34 @@ AddSearchChildren(
     search->right_toggle = XtCreateManagedWidget("forwards", toggleWidgetClass,
 						 form, args, num_args);
 
+    num_args = 0;
+    XtSetArg(args[num_args], XtNlabel, "Ignore case");
+    num_args++;
+    XtSetArg(args[num_args], XtNfromVert, search->label2);
+    num_args++;
+    XtSetArg(args[num_args], XtNfromHoriz, search->right_toggle);
+    num_args++;
+    XtSetArg(args[num_args], XtNleft, XtChainLeft);
+    num_args++;
+    XtSetArg(args[num_args], XtNright, XtChainLeft);
+    num_args++;
+    search->case_toggle = XtCreateManagedWidget("ignoreCase", toggleWidgetClass,
+						form, args, num_args);
+
+    num_args = 0;
+    XtSetArg(args[num_args], XtNlabel, "Regular expression");
+    num_args++;
+    XtSetArg(args[num_args], XtNfromVert, search->label2);
+    num_args++;
+    XtSetArg(args[num_args], XtNfromHoriz, search->case_toggle);
+    num_args++;
+    XtSetArg(args[num_args], XtNleft, XtChainLeft);
+    num_args++;
+    XtSetArg(args[num_args], XtNright, XtChainLeft);
+    num_args++;
+    search->regex_toggle = XtCreateManagedWidget("regex", toggleWidgetClass,
+						 form, args, num_args);
+
     {
 	XtTranslations radio_translations;
 
@@ -927,9 +975,10 @@ static Boolean
 DoSearch(struct SearchAndReplace *search)
 {
     Widget tw = XtParent(search->search_popup);
-    XawTextPosition pos;
+    XawTextPosition pos, end;
     XawTextScanDirection dir;
     XawTextBlock text;
+    XawTextSearchPattern pattern;
 
     TextWidget ctx = (TextWidget) tw;
 
@@ -944,7 +993,9 @@ DoSearch(struct SearchAndReplace *search)
 				  XawToggleGetCurrent(search->left_toggle) -
 				  R_OFFSET);
 
-    pos = XawTextSearch(tw, dir, &text);
+    if (!GetSearchPattern(search, &text, &pattern))
+	return FALSE;
+    pos = SearchText(search, dir, &text, pattern, &end);
 
     /* The Raw string in find.ptr may be WC I can't use here, so I re - call
        GetString to get a tame version. */
@@ -971,15 +1022,100 @@ DoSearch(struct SearchAndReplace *search)
 	return FALSE;
     }
     if (dir == XawsdRight)
-	XawTextSetInsertionPoint(tw, pos + text.length);
+	XawTextSetInsertionPoint(tw, end);
     else
 	XawTextSetInsertionPoint(tw, pos);
 
-    XawTextSetSelection(tw, pos, pos + text.length);
+    XawTextSetSelection(tw, pos, end);
     search->selection_changed = FALSE;	/* selection is good. */
     return TRUE;
 }
 
+/*	Function Name: GetSearchPattern
+ *	Description: Compiles the search string if the Ignore case or
+ *                   Regular expression toggles are set.  The pattern is
+ *                   kept until the string, the options or the source
+ *                   change.
+ *	Arguments: search - the search structure.
+ *                 text - the string to search for.
+ * RETURNED        pattern_return - the pattern, NULL for a plain search.
+ *	Returns: FALSE if the regular expression is bad.
+ */
+
+static Boolean
+GetSearchPattern(
+		    struct SearchAndReplace *search,
+		    XawTextBlock * text,
+		    XawTextSearchPattern * pattern_return)
+{
+    Widget source = XawTextGetSource(XtParent(search->search_popup));
+    char *string = GetString(search->search_text);
+    Boolean ignore_case, regex;
+    int options = 0;
+    Arg args[1];
+
+    XtSetArg(args[0], XtNstate, &ignore_case);
+    XtGetValues(search->case_toggle, args, ONE);
+    XtSetArg(args[0], XtNstate, &regex);
+    XtGetValues(search->regex_toggle, args, ONE);
+    if (ignore_case)
+	options |= XawTextSearchIgnoreCase;
+    if (regex)
+	options |= XawTextSearchRegex;
+
+    *pattern_return = NULL;
+    if (options == 0)
+	return TRUE;
+
+    if (search->pattern == NULL || search->pattern_source != source ||
+	search->pattern_options != options ||
+	strcmp(search->pattern_text, string) != 0) {
+	XawTextSourceFreeSearch(search->pattern);
+	XtFree(search->pattern_text);
+	search->pattern_text = NULL;
+	search->pattern = XawTextSourceCompileSearch(source, text, options);
+	if (search->pattern == NULL) {
+	    XawTextUnsetSelection(XtParent(search->search_popup));
+	    SetSearchLabels(search, "Bad regular expression", "", TRUE);
+	    return FALSE;
+	}
+	search->pattern_source = source;
+	search->pattern_options = options;
+	search->pattern_text = XtNewString(string);
+    }
+    *pattern_return = search->pattern;
+    return TRUE;
+}
+
+/*	Function Name: SearchText
+ *	Description: Searches the main text widget from the insertion point.
+ *	Arguments: search - the search structure.
+ *                 dir - direction to search.
+ *                 text - the string to search for.
+ *                 pattern - the compiled string, or NULL.
+ * RETURNED        end_return - the end of the text found.
+ *	Returns: The position of the text found or XawTextSearchError.
+ */
+
+static XawTextPosition
+SearchText(
+	      struct SearchAndReplace *search,
+	      XawTextScanDirection dir,
+	      XawTextBlock * text,
+	      XawTextSearchPattern pattern,
+	      XawTextPosition * end_return)
+{
+    Widget tw = XtParent(search->search_popup);
+    XawTextPosition pos;
+
+    if (pattern != NULL)
+	return (XawTextSearchCompiled(tw, dir, pattern, end_return));
+
+    pos = XawTextSearch(tw, dir, text);
+    *end_return = pos + text->length;
+    return (pos);
+}
+
 /************************************************************
  *
  * This section of the file contains all the functions that
@@ -1072,11 +1208,11 @@ Replace(
 	   Boolean once_only,
 	   Boolean show_current)
 {
-    XawTextPosition pos, new_pos, end_pos;
+    XawTextPosition pos, end_pos;
     XawTextScanDirection dir;
     XawTextBlock find, replace;
+    XawTextSearchPattern pattern;
     Widget tw = XtParent(search->search_popup);
-    int count = 0;
 
     TextWidget ctx = (TextWidget) tw;
 
@@ -1097,86 +1233,38 @@ Replace(
     dir = (XawTextScanDirection) ((XPointer)
 				  XawToggleGetCurrent(search->left_toggle) -
 				  R_OFFSET);
-    /* CONSTCOND */
-    while (TRUE) {
-	if (count != 0) {
-	    new_pos = XawTextSearch(tw, dir, &find);
-
-	    if ((new_pos == XawTextSearchError)) {
-		if (count == 0) {
-		    char msgbuf[BUFSIZ];
-		    char *msg;
-		    int len;
-		    char *fmt = "*** Error: Could not find string \"%s\" ***";
-
-		    len = (int) (strlen(fmt) + strlen(GetString(search->search_text)));
-		    if ((size_t) len < sizeof msgbuf)
-			msg = msgbuf;
-		    else
-			msg = XtMalloc((Cardinal) (len + 1));
-		    if (msg == NULL) {
-			msg = msgbuf;
-			strcpy(msg, "*** Error: Could not find string. ***");
-		    } else
-			(void) sprintf(msg, fmt, GetString(search->search_text));
-		    SetSearchLabels(search, msg, "", TRUE);
-		    if (msg != msgbuf)
-			XtFree(msg);
-		    return FALSE;
-		} else
-		    break;
-	    }
-	    pos = new_pos;
-	    end_pos = pos + find.length;
-	} else {
-	    XawTextGetSelectionPos(tw, &pos, &end_pos);
-
-	    if (search->selection_changed) {
-		SetSearchLabels(search,
-				"Selection has been modified, aborting.",
-				"", TRUE);
-		return (FALSE);
-	    }
-	    if (pos == end_pos)
-		return (FALSE);
-	}
 
-	if (XawTextReplace(tw, pos, end_pos, &replace) != XawEditDone) {
-	    char msgbuf[BUFSIZ];
-	    char *msg;
-	    int len;
-	    char *fmt = "'%s' with '%s'. ***";
-
-	    len = (int) (strlen(fmt) + strlen(find.ptr) + strlen(replace.ptr));
-	    if ((size_t) len < sizeof msgbuf)
-		msg = msgbuf;
-	    else
-		msg = XtMalloc((Cardinal) (len + 1));
-	    if (msg == NULL) {
-		msg = msgbuf;
-		strcpy(msg, "long strings");
-	    } else
-		(void) sprintf(msg, fmt, find.ptr, replace.ptr);
-	    SetSearchLabels(search, "*** Error while replacing", msg, TRUE);
-	    if (msg != msgbuf)
-		XtFree(msg);
-	    return FALSE;
-	}
+    if (!GetSearchPattern(search, &find, &pattern))
+	return FALSE;
 
-	if (dir == XawsdRight)
-	    XawTextSetInsertionPoint(tw, pos + replace.length);
-	else
-	    XawTextSetInsertionPoint(tw, pos);
-
-	if (once_only) {
-	    if (show_current)
-		break;
-	    else {
-		DoSearch(search);
-		return (TRUE);
-	    }
-	}
-	count++;
+    XawTextGetSelectionPos(tw, &pos, &end_pos);
+
+    if (search->selection_changed) {
+	SetSearchLabels(search,
+			"Selection has been modified, aborting.",
+			"", TRUE);
+	return (FALSE);
+    }
+    if (pos == end_pos)
+	return (FALSE);
+
+    if (!once_only)
+	return (ReplaceAll(search, dir, &find, pattern, &replace,
+			   pos, end_pos));
+
+    if (XawTextReplace(tw, pos, end_pos, &replace) != XawEditDone) {
+	ReplaceFailed(search);
+	return FALSE;
+    }
+
+    if (dir == XawsdRight)
+	XawTextSetInsertionPoint(tw, pos + replace.length);
+    else
+	XawTextSetInsertionPoint(tw, pos);
+
+    if (!show_current) {
+	DoSearch(search);
+	return (TRUE);
     }
 
     if (replace.length == 0)
@@ -1187,6 +1275,121 @@ Replace(
     return TRUE;
 }
 
+/*	Function Name: ReplaceAll
+ *	Description: Replaces the selection and every instance of the
+ *                   search string after it.  The source is searched
+ *                   once and all replacements are made together with
+ *                   XawTextReplaceMany(), so that the text is only
+ *                   redisplayed once.
+ *	Arguments: search - the search structure.
+ *                 dir - direction to search.
+ *                 find - the string to search for.
+ *                 pattern - the compiled string, or NULL.
+ *                 replace - the string to replace it with.
+ *                 pos, end_pos - the selection, the first string found.
+ *	Returns: TRUE if sucessful.
+ */
+
+static Boolean
+ReplaceAll(
+	      struct SearchAndReplace *search,
+	      XawTextScanDirection dir,
+	      XawTextBlock * find,
+	      XawTextSearchPattern pattern,
+	      XawTextBlock * replace,
+	      XawTextPosition pos,
+	      XawTextPosition end_pos)
+{
+    Widget tw = XtParent(search->search_popup);
+    Widget src = XawTextGetSource(tw);
+    XawTextEdit *edits = NULL;
+    XawTextPosition from;
+    char msg[BUFSIZ];
+    int i, count = 0, size = 0;
+
+    while (pos != XawTextSearchError) {
+	if (count == size) {
+	    size = (size == 0) ? BUFSIZ : 2 * size;
+	    edits = (XawTextEdit *)
+		XtRealloc((char *) edits,
+			  (Cardinal) ((size_t) size * sizeof(XawTextEdit)));
+	}
+	edits[count].startPos = pos;
+	edits[count].endPos = end_pos;
+	edits[count].text = *replace;
+	count++;
+
+	from = (dir == XawsdRight) ? end_pos : pos;
+	if (pattern != NULL)
+	    pos = XawTextSourceSearchCompiled(src, from, dir, pattern, &end_pos);
+	else {
+	    pos = XawTextSourceSearch(src, from, dir, find);
+	    end_pos = pos + find->length;
+	}
+    }
+
+    if (XawTextReplaceMany(tw, edits, count, NULL) != XawEditDone) {
+	XtFree((char *) edits);
+	ReplaceFailed(search);
+	return FALSE;
+    }
+
+    /*
+     * Leave the selection on the last string replaced.  Searching right
+     * it has moved by the change in length of all the others.
+     */
+
+    pos = edits[count - 1].startPos;
+    if (dir == XawsdRight) {
+	for (i = 0; i < count - 1; i++)
+	    pos += replace->length - (edits[i].endPos - edits[i].startPos);
+	XawTextSetInsertionPoint(tw, pos + replace->length);
+    } else
+	XawTextSetInsertionPoint(tw, pos);
+    XtFree((char *) edits);
+
+    if (replace->length == 0)
+	XawTextUnsetSelection(tw);
+    else
+	XawTextSetSelection(tw, pos, pos + replace->length);
+
+    (void) sprintf(msg, "Replaced %d %s.", count,
+		   (count == 1) ? "occurrence" : "occurrences");
+    SetSearchLabels(search, msg, "", FALSE);
+    return TRUE;
+}
+
+/*	Function Name: ReplaceFailed
+ *	Description: Tells the user that the text could not be replaced.
+ *	Arguments: search - the search structure.
+ *	Returns: none.
+ */
+
+static void
+ReplaceFailed(struct SearchAndReplace *search)
+{
+    char msgbuf[BUFSIZ];
+    char *msg;
+    char *find = GetString(search->search_text);
+    char *replace = GetString(search->rep_text);
+    int len;
+    char *fmt = "'%s' with '%s'. ***";
+
+    len = (int) (strlen(fmt) + strlen(find) + strlen(replace));
+    if ((size_t) len < sizeof msgbuf)
+	msg = msgbuf;
+    else
+	msg = XtMalloc((Cardinal) (len + 1));
+    if (msg == NULL) {
+	msg = msgbuf;
+	strcpy(msg, "long strings");
+    } else
+	(void) sprintf(msg, fmt, find, replace);
+    SetSearchLabels(search, "*** Error while replacing", msg, TRUE);
+    if (msg != msgbuf)
+	XtFree(msg);
+}
+
 /*	Function Name: SetSearchLabels
  *	Description: Sets both the search labels, and also rings the bell
  *	Arguments: search - the search structure.
@@ -47,8 +47,15 @@ This file contains modifications for XawPlus, Roland Krause 2002
 #include <X11/IntrinsicP.h>
 #include <X11/StringDefs.h>
 #include <X11/Xutil.h>
+#include <X11/Xos.h>
+#if defined(_POSIX2_VERSION)
+#include <regex.h>
+#define USE_REGEX 1
+#endif
 #include <X11/XawPlus/XawInit.h>
 #include <X11/XawPlus/TextSrcP.h>
+#include <X11/XawPlus/AsciiSrcP.h>
+#include <X11/XawPlus/MultiSrcP.h>
 #include <X11/Xmu/Atoms.h>
 #include <X11/Xmu/CharSet.h>
 #include "XawI18n.h"
@@ -70,6 +77,8 @@ static XtResource resources[] =
 
 static void ClassInitialize(void);
 static void ClassPartInitialize(WidgetClass /* wc */ );
+static void Initialize(Widget /* request */ , Widget /* new */ ,
+		       ArgList /* args */ , Cardinal * /* num_args */ );
 static void SetSelection(Widget /* w */ , XawTextPosition	/* left */
 			 ,XawTextPosition /* right */
 			 , Atom /* selection */ );
@@ -101,6 +110,48 @@ static XawTextPosition Read(Widget /* w */
 static int Replace(Widget /* w */ , XawTextPosition	/* startPos */
 		   ,XawTextPosition /* endPos */
 		   , XawTextBlock * /* text */ );
+#ifdef USE_REGEX
+static char *QuoteRegex(char * /* str */ );
+static int ReadLine(Widget /* w */
+		    , XawTextSearchPattern /* pattern */
+		    , XawTextPosition /* from */
+		    , XawTextPosition /* to */ );
+static int CharIndex(XawTextSearchPattern /* pattern */
+		     , int /* n */
+		     , int /* offset */ );
+static Boolean MatchLine(XawTextSearchPattern /* pattern */
+			 , int /* n */
+			 , int /* from */
+			 , XawTextScanDirection /* dir */
+			 , Boolean /* noteol */
+			 , int * /* start */
+			 , int * /* end */ );
+static XawTextPosition SearchRegex(Widget /* w */
+				   , XawTextPosition /* position */
+				   , XawTextScanDirection /* dir */
+				   , XawTextSearchPattern /* pattern */
+				   , XawTextPosition * /* end_return */ );
+#endif
+
+/*
+ * A search string prepared by XawTextSourceCompileSearch().  Regular
+ * expressions are matched one line at a time; the line is converted to
+ * a multibyte string, with the offset of each character so that the
+ * match can be mapped back to text positions.
+ */
+
+struct _XawTextSearchRec {
+    int options;		/* XawTextSearchIgnoreCase, XawTextSearchRegex */
+    Boolean use_regex;		/* match with regex, not the string. */
+    XawTextBlock text;		/* the string, in the format of the source. */
+#ifdef USE_REGEX
+    regex_t regex;		/* the compiled expression. */
+    char *line;			/* the line being matched, */
+    int line_size;		/* bytes allocated for it, */
+    int *offsets;		/* start of each character in line, */
+    int offsets_size;		/* entries allocated for them. */
+#endif
+};
 
 #define SuperClass		(&objectClassRec)
 TextSrcClassRec textSrcClassRec =
@@ -113,7 +164,7 @@ TextSrcClassRec textSrcClassRec =
     /* class_initialize         */ ClassInitialize,
     /* class_part_initialize    */ ClassPartInitialize,
     /* class_inited             */ FALSE,
-    /* initialize               */ NULL,
+    /* initialize               */ Initialize,
     /* initialize_hook          */ NULL,
     /* realize                  */ NULL,
     /* actions                  */ NULL,
@@ -192,6 +243,14 @@ ClassPartInitialize(WidgetClass wc)
 	    superC->textSrc_class.ConvertSelection;
 }
 
+/* ARGSUSED */
+static void
+Initialize(Widget request GCC_UNUSED, Widget new,
+	   ArgList args GCC_UNUSED, Cardinal * num_args GCC_UNUSED)
+{
+    ((TextSrcObject) new)->textSrc.changes = 0;
+}
+
 /************************************************************
  *
  * Class specific methods.
@@ -407,6 +466,9 @@ XawTextSourceRead(Widget w, XawTextPosition pos, XawTextBlock * text,
  *                 startPos, endPos - ends of text that will be removed.
  *                 text - new text to be inserted into buffer at startPos.
  *	Returns: XawEditError or XawEditDone.
+ *
+ * The replacements are counted, so that the text widgets can tell if the
+ * source was changed by someone else.
  */
 
 /*ARGSUSED*/
@@ -415,13 +477,17 @@ XawTextSourceReplace(Widget w, XawTextPosition startPos,
 		     XawTextPosition endPos, XawTextBlock * text)
 {
     TextSrcObjectClass class = (TextSrcObjectClass) w->core.widget_class;
+    int result;
 
     if (!XtIsSubclass(w, textSrcObjectClass))
 	XtErrorMsg("bad argument", "textSource", "XawError",
 		   "XawTextSourceReplace's 1st parameter must be subclass of asciiSrc.",
 		   NULL, NULL);
 
-    return ((*class->textSrc_class.Replace) (w, startPos, endPos, text));
+    result = (*class->textSrc_class.Replace) (w, startPos, endPos, text);
+    if (result == XawEditDone)
+	((TextSrcObject) w)->textSrc.changes++;
+    return (result);
 }
 
 /*	Function Name: XawTextSourceScan
@@ -529,6 +595,468 @@ XawTextSourceSetSelection(Widget w, XawTextPosition left,
     (*class->textSrc_class.SetSelection) (w, left, right, selection);
 }
 
+/*	Function Name: XawTextSourceLineToPosition
+ *	Description: Finds the position where a line starts.
+ *	Arguments: w - the TextSrc object.
+ *                 line - the line number, counting from 0.
+ *	Returns: The position, or the end of the text if there are
+ *               fewer lines.
+ *
+ * The AsciiSrc and MultiSrc keep an index of the newlines, so that this
+ * does not depend on the size of the text.
+ */
+
+XawTextPosition
+XawTextSourceLineToPosition(Widget w, long line)
+{
+    if (!XtIsSubclass(w, textSrcObjectClass))
+	XtErrorMsg("bad argument", "textSource", "XawError",
+		   "XawTextSourceLineToPosition's 1st parameter must be subclass of asciiSrc.",
+		   NULL, NULL);
+
+    if (XtIsSubclass(w, multiSrcObjectClass))
+	return (_XawMultiSourceLineToPosition(w, line));
+    if (XtIsSubclass(w, asciiSrcObjectClass))
+	return (_XawAsciiSourceLineToPosition(w, line));
+
+    if (line <= 0)
+	return (0);
+    return (XawTextSourceScan(w, (XawTextPosition) 0, XawstEOL, XawsdRight,
+			      (int) line, TRUE));
+}
+
+/*	Function Name: XawTextSourcePositionToLine
+ *	Description: Finds the line that contains a position.
+ *	Arguments: w - the TextSrc object.
+ *                 position - the position.
+ *	Returns: The line number, counting from 0.
+ */
+
+long
+XawTextSourcePositionToLine(Widget w, XawTextPosition position)
+{
+    XawTextPosition pos = 0;
+    XawTextBlock block;
+    long line = 0;
+    int i;
+
+    if (!XtIsSubclass(w, textSrcObjectClass))
+	XtErrorMsg("bad argument", "textSource", "XawError",
+		   "XawTextSourcePositionToLine's 1st parameter must be subclass of asciiSrc.",
+		   NULL, NULL);
+
+    if (XtIsSubclass(w, multiSrcObjectClass))
+	return (_XawMultiSourcePositionToLine(w, position));
+    if (XtIsSubclass(w, asciiSrcObjectClass))
+	return (_XawAsciiSourcePositionToLine(w, position));
+
+    while (pos < position) {
+	pos = XawTextSourceRead(w, pos, &block, (int) (position - pos));
+	if (block.length <= 0)
+	    break;
+	for (i = 0; i < block.length; i++) {
+	    if (block.format == XawFmtWide) {
+		if (((wchar_t *) block.ptr)[i] == _Xaw_atowc(XawLF))
+		    line++;
+	    } else if (block.ptr[i] == XawLF)
+		line++;
+	}
+    }
+    return (line);
+}
+
+/*	Function Name: XawTextSourceCompileSearch
+ *	Description: Prepares a string for searching.
+ *	Arguments: w - the TextSrc object.
+ *                 text - the text block to search for.
+ *                 options - XawTextSearchIgnoreCase, XawTextSearchRegex.
+ *	Returns: The pattern, or NULL if the regular expression is bad
+ *               or regular expressions are not supported.
+ *
+ * The pattern keeps the string in the format of the source, so it should
+ * only be used with sources of the same format.  Regular expressions are
+ * POSIX extended expressions, they never match across a newline.
+ */
+
+XawTextSearchPattern
+XawTextSourceCompileSearch(Widget w, XawTextBlock * text, int options)
+{
+    XawTextSearchPattern pattern;
+    Display *d = XtDisplayOfObject(w);
+    XrmQuark format;
+    wchar_t *wstr = NULL;
+    char *mb;
+    int length = text->length;
+
+    if (!XtIsSubclass(w, textSrcObjectClass))
+	XtErrorMsg("bad argument", "textSource", "XawError",
+		   "XawTextSourceCompileSearch's 1st parameter must be subclass of asciiSrc.",
+		   NULL, NULL);
+    format = ((TextSrcObject) w)->textSrc.text_format;
+
+    /*
+     * Keep a multibyte copy for regcomp() and one in the format of
+     * the source for the plain search.
+     */
+
+    if (text->format == XawFmtWide) {
+	wstr = (wchar_t *) XtMalloc((Cardinal) ((length + 1) * sizeof(wchar_t)));
+	memcpy(wstr, text->ptr, (size_t) length * sizeof(wchar_t));
+	wstr[length] = 0;
+	mb = (length > 0) ? _XawTextWCToMB(d, wstr, &length) : NULL;
+	if (mb == NULL)
+	    mb = XtNewString("");
+    } else {
+	mb = XtMalloc((Cardinal) (length + 1));
+	memcpy(mb, text->ptr, (size_t) length);
+	mb[length] = '\0';
+    }
+
+    pattern = XtNew(struct _XawTextSearchRec);
+    pattern->options = options;
+    pattern->use_regex = FALSE;
+    pattern->text.firstPos = 0;
+    pattern->text.format = (unsigned long) format;
+
+    if (format == XawFmtWide) {
+	if (wstr == NULL) {
+	    wstr = (length > 0) ? _XawTextMBToWC(d, mb, &length) : NULL;
+	    if (wstr == NULL) {
+		wstr = (wchar_t *) XtMalloc(sizeof(wchar_t));
+		length = 0;
+	    }
+	} else
+	    length = text->length;
+	pattern->text.ptr = (char *) wstr;
+	pattern->text.length = length;
+    } else {
+	XtFree((char *) wstr);
+	pattern->text.ptr = mb;
+	pattern->text.length = (int) strlen(mb);
+    }
+
+    /*
+     * Only the AsciiSrc and the MultiSrc can ignore case themselves,
+     * for other sources the string is quoted and matched as an
+     * expression.
+     */
+
+    if ((options & XawTextSearchRegex) ||
+	((options & XawTextSearchIgnoreCase) &&
+	 !XtIsSubclass(w, asciiSrcObjectClass) &&
+	 !XtIsSubclass(w, multiSrcObjectClass))) {
+#ifdef USE_REGEX
+	char *expr = (options & XawTextSearchRegex) ? mb : QuoteRegex(mb);
+	int flags = REG_EXTENDED;
+	int result;
+
+	if (options & XawTextSearchIgnoreCase)
+	    flags |= REG_ICASE;
+	result = regcomp(&pattern->regex, expr, flags);
+	if (expr != mb)
+	    XtFree(expr);
+	if (result != 0) {
+	    if (pattern->text.ptr != mb)
+		XtFree(mb);
+	    XtFree(pattern->text.ptr);
+	    XtFree((char *) pattern);
+	    return (NULL);
+	}
+	pattern->use_regex = TRUE;
+	pattern->line = NULL;
+	pattern->line_size = 0;
+	pattern->offsets = NULL;
+	pattern->offsets_size = 0;
+#else
+	if (pattern->text.ptr != mb)
+	    XtFree(mb);
+	XtFree(pattern->text.ptr);
+	XtFree((char *) pattern);
+	return (NULL);
+#endif
+    }
+
+    if (pattern->text.ptr != mb)
+	XtFree(mb);
+    return (pattern);
+}
+
+/*	Function Name: XawTextSourceSearchCompiled
+ *	Description: Searches the text source for a compiled pattern.
+ *	Arguments: w - the TextSrc object.
+ *                 position - the position to start searching.
+ *                 dir - direction to search.
+ *                 pattern - the pattern to search for.
+ * RETURNED        end_return - the end of the text found, may be NULL.
+ *	Returns: The position of the text found or XawTextSearchError.
+ */
+
+XawTextPosition
+XawTextSourceSearchCompiled(Widget w, XawTextPosition position,
+			    XawTextScanDirection dir,
+			    XawTextSearchPattern pattern,
+			    XawTextPosition * end_return)
+{
+    XawTextPosition found;
+
+    if (!XtIsSubclass(w, textSrcObjectClass))
+	XtErrorMsg("bad argument", "textSource", "XawError",
+		   "XawTextSourceSearchCompiled's 1st parameter must be subclass of asciiSrc.",
+		   NULL, NULL);
+
+    if (pattern == NULL || pattern->text.length == 0)
+	return (XawTextSearchError);
+
+#ifdef USE_REGEX
+    if (pattern->use_regex)
+	return (SearchRegex(w, position, dir, pattern, end_return));
+#endif
+
+    if (!(pattern->options & XawTextSearchIgnoreCase))
+	found = XawTextSourceSearch(w, position, dir, &pattern->text);
+    else if (XtIsSubclass(w, multiSrcObjectClass))
+	found = _XawMultiSourceSearchIgnoreCase(w, position, dir, &pattern->text);
+    else
+	found = _XawAsciiSourceSearchIgnoreCase(w, position, dir, &pattern->text);
+
+    if (found != XawTextSearchError && end_return != NULL)
+	*end_return = found + pattern->text.length;
+    return (found);
+}
+
+/*	Function Name: XawTextSourceFreeSearch
+ *	Description: Frees a pattern.
+ *	Arguments: pattern - the pattern, may be NULL.
+ *	Returns: none.
+ */
+
+void
+XawTextSourceFreeSearch(XawTextSearchPattern pattern)
+{
+    if (pattern == NULL)
+	return;
+#ifdef USE_REGEX
+    if (pattern->use_regex) {
+	regfree(&pattern->regex);
+	XtFree(pattern->line);
+	XtFree((char *) pattern->offsets);
+    }
+#endif
+    XtFree(pattern->text.ptr);
+    XtFree((char *) pattern);
+}
+
+#ifdef USE_REGEX
+
+/*	Function Name: QuoteRegex
+ *	Description: Quotes the special characters of an extended
+ *                   regular expression.
+ *	Arguments: str - the string.
+ *	Returns: The quoted string, allocated with XtMalloc.
+ */
+
+static char *
+QuoteRegex(char *str)
+{
+    char *result = XtMalloc((Cardinal) (2 * strlen(str) + 1));
+    char *ptr = result;
+
+    for (; *str != '\0'; str++) {
+	if (strchr("\\.[]()*+?{}|^$", *str) != NULL)
+	    *ptr++ = '\\';
+	*ptr++ = *str;
+    }
+    *ptr = '\0';
+    return (result);
+}
+
+/*	Function Name: ReadLine
+ *	Description: Reads text into the line buffer of the pattern as
+ *                   a multibyte string.
+ *	Arguments: w - the TextSrc object.
+ *                 pattern - the pattern.
+ *                 from, to - the text to read, without newlines.
+ *	Returns: The number of characters read.
+ */
+
+static int
+ReadLine(Widget w, XawTextSearchPattern pattern,
+	 XawTextPosition from, XawTextPosition to)
+{
+    XawTextBlock block;
+    int i, n = 0, bytes = 0, size;
+
+    while (from < to) {
+	from = XawTextSourceRead(w, from, &block, (int) (to - from));
+	if (block.length <= 0)
+	    break;
+	for (i = 0; i < block.length; i++) {
+	    if (n + 1 >= pattern->offsets_size) {
+		pattern->offsets_size = 2 * (n + 1) + BUFSIZ;
+		pattern->offsets = (int *)
+		    XtRealloc((char *) pattern->offsets,
+			      (Cardinal) ((size_t) pattern->offsets_size *
+					  sizeof(int)));
+	    }
+	    size = (block.format == XawFmtWide) ? (int) MB_CUR_MAX : 1;
+	    if (bytes + size >= pattern->line_size) {
+		pattern->line_size = 2 * (bytes + size) + BUFSIZ;
+		pattern->line = XtRealloc(pattern->line,
+					  (Cardinal) pattern->line_size);
+	    }
+	    pattern->offsets[n++] = bytes;
+	    if (block.format == XawFmtWide) {
+		size = wctomb(pattern->line + bytes, ((wchar_t *) block.ptr)[i]);
+		if (size <= 0) {
+		    pattern->line[bytes] = '?';
+		    size = 1;
+		}
+		bytes += size;
+	    } else
+		pattern->line[bytes++] = block.ptr[i];
+	}
+    }
+    if (pattern->line == NULL) {
+	pattern->line_size = BUFSIZ;
+	pattern->line = XtMalloc((Cardinal) pattern->line_size);
+	pattern->offsets_size = BUFSIZ;
+	pattern->offsets = (int *) XtMalloc((Cardinal) (BUFSIZ * sizeof(int)));
+    }
+    pattern->offsets[n] = bytes;
+    pattern->line[bytes] = '\0';
+    return (n);
+}
+
+/*	Function Name: CharIndex
+ *	Description: Finds the character that starts at a byte offset of
+ *                   the line buffer.
+ *	Arguments: pattern - the pattern.
+ *                 n - the number of characters in the line.
+ *                 offset - the byte offset.
+ *	Returns: The character index.
+ */
+
+static int
+CharIndex(XawTextSearchPattern pattern, int n, int offset)
+{
+    int low = 0, high = n;
+
+    while (low < high) {
+	int mid = (low + high) / 2;
+
+	if (pattern->offsets[mid] < offset)
+	    low = mid + 1;
+	else
+	    high = mid;
+    }
+    return (low);
+}
+
+/*	Function Name: MatchLine
+ *	Description: Matches the expression against the line buffer.
+ *	Arguments: pattern - the pattern.
+ *                 n - the number of characters in the line.
+ *                 from - the character to start at.
+ *                 dir - XawsdRight for the first match, XawsdLeft
+ *                       for the last one.
+ *                 noteol - TRUE if the line buffer does not end at the
+ *                          end of the line.
+ * RETURNED        start, end - the characters matched.
+ *	Returns: TRUE if a match was found.
+ *
+ * Empty matches are skipped, they cannot be selected.
+ */
+
+static Boolean
+MatchLine(XawTextSearchPattern pattern, int n, int from,
+	  XawTextScanDirection dir, Boolean noteol, int *start, int *end)
+{
+    regmatch_t match;
+    Boolean found = FALSE;
+    int offset, first, eflags;
+
+    while (from <= n) {
+	offset = pattern->offsets[from];
+	eflags = ((from > 0) ? REG_NOTBOL : 0) | (noteol ? REG_NOTEOL : 0);
+	if (regexec(&pattern->regex, pattern->line + offset, 1, &match,
+		    eflags) != 0)
+	    break;
+	first = CharIndex(pattern, n, offset + (int) match.rm_so);
+	if (match.rm_eo > match.rm_so) {
+	    *start = first;
+	    *end = CharIndex(pattern, n, offset + (int) match.rm_eo);
+	    found = TRUE;
+	    if (dir == XawsdRight)
+		break;
+	}
+	from = first + 1;
+    }
+    return (found);
+}
+
+/*	Function Name: SearchRegex
+ *	Description: Searches the text a line at a time for a regular
+ *                   expression.
+ *	Arguments: w - the TextSrc object.
+ *                 position - the position to start searching.
+ *                 dir - direction to search.
+ *                 pattern - the pattern to search for.
+ * RETURNED        end_return - the end of the text found, may be NULL.
+ *	Returns: The position of the text found or XawTextSearchError.
+ *
+ * Searching left, the match must end before position.
+ */
+
+static XawTextPosition
+SearchRegex(Widget w, XawTextPosition position, XawTextScanDirection dir,
+	    XawTextSearchPattern pattern, XawTextPosition * end_return)
+{
+    XawTextPosition start, end, last;
+    Boolean noteol;
+    int n, first, after;
+
+    last = XawTextSourceScan(w, (XawTextPosition) 0, XawstAll, XawsdRight,
+			     1, TRUE);
+    if (position > last)
+	position = last;
+    if (position < 0)
+	position = 0;
+    start = XawTextSourceScan(w, position, XawstEOL, XawsdLeft, 1, FALSE);
+
+    if (dir == XawsdRight) {
+	for (;;) {
+	    end = XawTextSourceScan(w, start, XawstEOL, XawsdRight, 1, FALSE);
+	    n = ReadLine(w, pattern, start, end);
+	    first = (position > start) ? (int) (position - start) : 0;
+	    if (MatchLine(pattern, n, first, dir, FALSE, &first, &after))
+		break;
+	    if (end >= last)
+		return (XawTextSearchError);
+	    start = end + 1;
+	}
+    } else {
+	end = position;
+	noteol = (XawTextSourceScan(w, start, XawstEOL, XawsdRight, 1, FALSE)
+		  > end);
+	for (;;) {
+	    n = ReadLine(w, pattern, start, end);
+	    if (MatchLine(pattern, n, 0, dir, noteol, &first, &after))
+		break;
+	    if (start <= 0)
+		return (XawTextSearchError);
+	    end = start - 1;
+	    start = XawTextSourceScan(w, end, XawstEOL, XawsdLeft, 1, FALSE);
+	    noteol = FALSE;
+	}
+    }
+
+    if (end_return != NULL)
+	*end_return = start + after;
+    return (start + first);
+}
+
+#endif /* USE_REGEX */
+
 /********************************************************************
  *
  *      External Functions for Multi Text.
@@ -58,7 +58,9 @@ in this Software without prior written authorization from The Open Group.
  callback	     Callback		Callback	(none)
  dataCompression     DataCompression	Boolean		True
  length		     Length		int		(internal)
+ mmapFile	     MmapFile		Boolean		False
  pieceSize	     PieceSize		int		BUFSIZ
+ pieceTable	     PieceTable		Boolean		False
  string		     String		String		NULL
  type		     Type		XawAsciiType	XawAsciiString
  useStringInPlace    UseStringInPlace	Boolean		False
@@ -84,12 +86,16 @@ typedef struct _AsciiSrcRec      *AsciiSrcObject;
  */
 
 #define XtCDataCompression "DataCompression"
+#define XtCMmapFile "MmapFile"
 #define XtCPieceSize "PieceSize"
+#define XtCPieceTable "PieceTable"
 #define XtCType "Type"
 #define XtCUseStringInPlace "UseStringInPlace"
 
 #define XtNdataCompression "dataCompression"
+#define XtNmmapFile "mmapFile"
 #define XtNpieceSize "pieceSize"
+#define XtNpieceTable "pieceTable"
 #define XtNtype "type"
 #define XtNuseStringInPlace "useStringInPlace"
 
@@ -104,8 +104,21 @@ typedef struct _Piece {		/* Piece of the text file of BUFSIZ allocated
   XawTextPosition used;		/* The number of characters of this buffer
 				   that have been used. */
   struct _Piece *prev, *next;	/* linked list pointers. */
+  struct _Piece *parent, *left, *right;	/* position index (a treap). */
+  XawTextPosition total;	/* characters used in this subtree. */
+  XawTextPosition lines;	/* newlines in this piece. */
+  XawTextPosition line_total;	/* newlines in this subtree. */
+  unsigned long weight;		/* heap priority of the treap node. */
 } Piece;
 
+typedef struct _AddBuffer {	/* Append-only storage for the text inserted
+				   into a piece table. */
+  char * text;			/* The text in this buffer. */
+  XawTextPosition used;		/* The number of characters appended. */
+  XawTextPosition size;		/* The number of characters allocated. */
+  struct _AddBuffer *next;	/* the previously filled buffer. */
+} AddBuffer;
+
 /************************************************************
  *
  * New fields for the AsciiSrc object class record.
@@ -139,6 +152,9 @@ typedef struct _AsciiSrcPart {
 				   changed. */
   Boolean use_string_in_place;	/* Use the string passed in place. */
   int     ascii_length;		/* length field for ascii string emulation. */
+  Boolean mmap_file;		/* map read-only files instead of copying. */
+  Boolean piece_table;		/* keep edits as descriptors into the
+				   original text and an add buffer. */
 
 #ifdef ASCII_DISK
   String filename;		/* name of file for Compatability. */
@@ -152,6 +168,12 @@ typedef struct _AsciiSrcPart {
 				     string in ascii_src->string? */
   XawTextPosition length; 	/* length of file */
   Piece * first_piece;		/* first piece of the text. */
+  Piece * root_piece;		/* root of the position index. */
+  char * mapped_text;		/* file mapping the pieces point into. */
+  XawTextPosition mapped_length;	/* size of that mapping. */
+  char * original_text;		/* unchanged text of a piece table. */
+  AddBuffer * add_buffer;	/* inserted text of a piece table. */
+  Boolean lines_indexed;	/* are the newline counts valid? */
 } AsciiSrcPart;
 
 /****************************************************************
@@ -166,4 +188,9 @@ typedef struct _AsciiSrcRec {
   AsciiSrcPart	ascii_src;
 } AsciiSrcRec;
 
+extern XawTextPosition _XawAsciiSourceLineToPosition( Widget, long );
+extern long _XawAsciiSourcePositionToLine( Widget, XawTextPosition );
+extern XawTextPosition _XawAsciiSourceSearchIgnoreCase( Widget,
+		XawTextPosition, XawTextScanDirection, XawTextBlock * );
+
 #endif /* _XawAsciiSrcP_h */
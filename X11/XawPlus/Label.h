@@ -110,6 +110,10 @@ SOFTWARE.
  leftClipMask	     LeftBitmap		ClipMask	None *)
  bitmap		     Pixmap		Bitmap		None *)
  clipMask	     Pixmap		ClipMask	None *)
+ bitmapName	     BitmapName		String		NULL **)
+ leftBitmapName	     LeftBitmapName	String		NULL **)
+ placeholderWidth    PlaceholderWidth	Dimension	0
+ placeholderHeight   PlaceholderHeight	Dimension	0
 
  *)  Standard XBM bitmap with depth 1 or XPM styled pixmap with depth > 1
 
@@ -125,6 +129,11 @@ SOFTWARE.
 
 	*Label.Pixmap:			Info.xpm
 	*MenuButton.LeftBitmap:		menu12.xpm
+
+ **) XPM file loaded in the background, setting bitmap and clipMask,
+    or leftBitmap and leftClipMask, when it is ready. Until then the
+    label shows a blank area of placeholderWidth x placeholderHeight,
+    if these are set. The names are declared in StrToPmap.h.
 */
 
 #define XawTextEncoding8bit	0
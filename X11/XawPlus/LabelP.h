@@ -101,6 +101,10 @@ typedef struct {
     Pixmap      clipMask;
     Pixmap	left_bitmap;
     Pixmap	left_clipMask;
+    char	*bitmap_name;		/* pixmaps loaded in the background */
+    char	*left_bitmap_name;
+    Dimension	placeholder_width;	/* their size until they are loaded */
+    Dimension	placeholder_height;
 
     /* private state */
     char	*label_full_len;	/* saved label string if label was truncated */
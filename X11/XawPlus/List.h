@@ -116,6 +116,11 @@ in this Software without prior written authorization from The Open Group.
  iconHeight	     Height		Dimension	0
  iconWidth	     Width		Dimension	0
  iconDepth	     Depth		Dimension	1
+ fetchCallback       Callback           XtCallbackList  NULL       **8
+ longestSample       LongestSample      int             64         **8
+ caseSensitive       CaseSensitive      Boolean         False      **9
+ multiSelect         Boolean            Boolean         False      **10
+ typeAhead           Boolean            Boolean         False      **9
 
 
  **1 - If the Width or Height of the list widget is zero (0) then the value
@@ -149,6 +154,27 @@ in this Software without prior written authorization from The Open Group.
 
  **7 - This is an array of XawIconList entries with the elements of the list.
        This resource must be specified if there is no simple list.
+
+ **8 - If there are functions on the fetchCallback list, the list is
+       virtual: list and iconList are not used, numberStrings is the
+       number of items and the items are fetched with the callback when
+       they are shown. The callback gets an XawListFetchStruct as its
+       call_data. If longest is zero it is estimated from longestSample
+       items spread over the list. The window is at most 32767 pixels
+       high; inside a Viewport a longer list is mapped onto it.
+
+ **9 - If typeAhead is True, keys typed into the list are collected into
+       a prefix, and the first item in sort order that starts with it is
+       highlighted and, inside a Viewport, scrolled into view (the
+       Search() action). caseSensitive tells if the case of the letters
+       matters. Virtual lists are not searched.
+
+ **10 - In a multiSelect list any number of items may be selected: Btn1
+       selects an item, Shift-Btn1 the items from the last one clicked
+       to this one, Ctrl-Btn1 selects or deselects an item and leaves
+       the others alone. The callback is called once per click, with
+       the item clicked; XawListGetSelectedRanges() tells which items
+       are selected.
 */
 
 
@@ -163,10 +189,14 @@ in this Software without prior written authorization from The Open Group.
 #define XtCColumns 		"Columns"
 #define XtCLongest 		"Longest"
 #define XtCNumberStrings 	"NumberStrings"
+#define XtCLongestSample 	"LongestSample"
+#define XtCCaseSensitive 	"CaseSensitive"
 
+#define XtNcaseSensitive 	"caseSensitive"
 #define XtNcursor 		"cursor"
 #define XtNcolumnSpacing 	"columnSpacing"
 #define XtNdefaultColumns 	"defaultColumns"
+#define XtNfetchCallback	"fetchCallback"
 #define XtNforceColumns		"forceColumns"
 #define XtNlist			"list"
 #define XtNiconList		"iconList"
@@ -174,9 +204,12 @@ in this Software without prior written authorization from The Open Group.
 #define XtNiconHeight		"iconHeight"
 #define XtNiconDepth		"iconDepth"
 #define XtNlongest 		"longest"
+#define XtNlongestSample 	"longestSample"
+#define XtNmultiSelect 		"multiSelect"
 #define XtNnumberStrings 	"numberStrings"
 #define XtNpasteBuffer 		"pasteBuffer"
 #define XtNrowSpacing 		"rowSpacing"
+#define XtNtypeAhead 		"typeAhead"
 #define XtNverticalList 	"verticalList"
 
 #ifndef XtNfontSet
@@ -209,6 +242,24 @@ typedef struct _XawIconList {
   String string;	/* text for the list entry */
 } XawIconList;
 
+/* The structure passed to the fetchCallback of a virtual list. The callback
+   sets string, and bitmap and clipMask if the list shows icons. The string
+   has to stay valid until the next call of the callback. */
+
+typedef struct _XawListFetchStruct {
+  int list_index;	/* the item wanted */
+  String string;	/* RETURN: text for the list entry */
+  Pixmap bitmap;	/* RETURN: the icon, XtUnspecifiedPixmap if none */
+  Pixmap clipMask;	/* RETURN: drawing mask for the icon */
+} XawListFetchStruct;
+
+/* A range of selected items, see XawListGetSelectedRanges() */
+
+typedef struct _XawListRange {
+  int first;		/* the first item of the range */
+  int last;		/* the last item of the range */
+} XawListRange;
+
 /********************************************************************************
  *
  * Exported Functions
@@ -231,6 +282,8 @@ _XFUNCPROTOBEGIN
  *	Returns: none.
  *      NOTE:      If nitems of longest are <= 0 then they will be calculated.
  *                 If nitems is <= 0 then the list needs to be NULL terminated.
+ *                 A virtual list does not use list, nitems is the new
+ *                 number of items.
  */
 
 extern void XawListChange(
@@ -241,6 +294,52 @@ extern void XawListChange(
     Boolean		/* resize */
 );
 
+/*	Function Name: XawListInsertItems
+ *	Description: Shows items inserted into the LIST.
+ *	Arguments: w -		the list widget.
+ *                 list -	the list, with the new items.
+ *                 position -	the index of the first new item.
+ *                 count -	the number of new items.
+ *	Returns: none.
+ *      NOTE:      Only the new items are measured and only the items
+ *                 from position on are repainted.
+ */
+
+extern void XawListInsertItems(
+    Widget		/* w */,
+    String*		/* list */,
+    int			/* position */,
+    int			/* count */
+);
+
+/*	Function Name: XawListDeleteItems
+ *	Description: Shows that items have been deleted from the LIST.
+ *	Arguments: w -		the list widget.
+ *                 list -	the list, without the deleted items.
+ *                 position -	the index of the first deleted item.
+ *                 count -	the number of deleted items.
+ *	Returns: none.
+ */
+
+extern void XawListDeleteItems(
+    Widget		/* w */,
+    String*		/* list */,
+    int			/* position */,
+    int			/* count */
+);
+
+/*	Function Name: XawListUpdateItem
+ *	Description: Shows an item that has been changed in place.
+ *	Arguments: w -		the list widget.
+ *                 item -	the index of the item.
+ *	Returns: none.
+ */
+
+extern void XawListUpdateItem(
+    Widget		/* w */,
+    int			/* item */
+);
+
 /*	Function Name: XawListUnhighlight
  *	Description: unlights the current highlighted element.
  *	Arguments: w - the widget.
@@ -273,6 +372,80 @@ extern XawListReturnStruct * XawListShowCurrent(
     Widget		/* w */
 );
 
+/*	Function Name: XawListShowItem
+ *	Description: Scrolls an item into view, if the list is in a
+ *                   Viewport.
+ *	Arguments: w - the list widget.
+ *                 item - the item.
+ *	Returns: none.
+ *      NOTE:      This reaches every item of a virtual list, even if
+ *                 its rows do not fit into one window.
+ */
+
+extern void XawListShowItem(
+    Widget		/* w */,
+    int			/* item */
+);
+
+/*	Function Name: XawListFindPrefix
+ *	Description: Finds an item that starts with a prefix.
+ *	Arguments: w - the list widget.
+ *                 prefix - the prefix.
+ *	Returns: the first item starting with prefix in sort order, or
+ *               XAW_LIST_NONE.
+ *      NOTE:      The case of the letters matters if the resource
+ *                 caseSensitive is True. Virtual lists are not searched.
+ */
+
+extern int XawListFindPrefix(
+    Widget		/* w */,
+    String		/* prefix */
+);
+
+/*	Function Name: XawListSelectRange
+ *	Description: Selects or deselects a range of items of a multiSelect
+ *                   list.
+ *	Arguments: w -		the list widget.
+ *                 first, last -	the range of items.
+ *                 select -	TRUE to select the items.
+ *	Returns: none.
+ *      NOTE:      Only the visible items that change are repainted.
+ */
+
+extern void XawListSelectRange(
+    Widget		/* w */,
+    int			/* first */,
+    int			/* last */,
+    Boolean		/* select */
+);
+
+/*	Function Name: XawListIsSelected
+ *	Description: Tells if an item is selected.
+ *	Arguments: w -		the list widget.
+ *                 item -	the item.
+ *	Returns: TRUE if the item is selected, or highlighted if the
+ *               list is not a multiSelect list.
+ */
+
+extern Boolean XawListIsSelected(
+    Widget		/* w */,
+    int			/* item */
+);
+
+/*	Function Name: XawListGetSelectedRanges
+ *	Description: Gets the selected items as ranges of items.
+ *	Arguments: w -		the list widget.
+ *                 ranges -	the ranges ** RETURNED **, may be NULL.
+ *                 max -	the number of ranges that fit into ranges.
+ *	Returns: the number of ranges, which may be more than max.
+ */
+
+extern int XawListGetSelectedRanges(
+    Widget		/* w */,
+    XawListRange*	/* ranges */,
+    int			/* max */
+);
+
 
 /* --- Handling of a combined text / icon list -------------------------------- */
 
@@ -304,9 +477,47 @@ extern void XawIconListChange(
     Boolean		/* resize */
 );
 
+/*	Function Name: XawIconListInsertItems
+ *	Description: Shows items inserted into the ICONLIST.
+ *	Arguments: w -		the list widget.
+ *                 list -	the list, with the new items.
+ *                 position -	the index of the first new item.
+ *                 count -	the number of new items.
+ *	Returns: none.
+ */
+
+extern void XawIconListInsertItems(
+    Widget		/* w */,
+    XawIconList*	/* list */,
+    int			/* position */,
+    int			/* count */
+);
+
+/*	Function Name: XawIconListDeleteItems
+ *	Description: Shows that items have been deleted from the ICONLIST.
+ *	Arguments: w -		the list widget.
+ *                 list -	the list, without the deleted items.
+ *                 position -	the index of the first deleted item.
+ *                 count -	the number of deleted items.
+ *	Returns: none.
+ */
+
+extern void XawIconListDeleteItems(
+    Widget		/* w */,
+    XawIconList*	/* list */,
+    int			/* position */,
+    int			/* count */
+);
+
 #define XawIconListUnhighlight XawListUnhighlight
 #define XawIconListHighlight   XawListHighlight
 #define XawIconListShowCurrent XawListShowCurrent
+#define XawIconListShowItem    XawListShowItem
+#define XawIconListUpdateItem  XawListUpdateItem
+#define XawIconListFindPrefix  XawListFindPrefix
+#define XawIconListSelectRange XawListSelectRange
+#define XawIconListIsSelected  XawListIsSelected
+#define XawIconListGetSelectedRanges XawListGetSelectedRanges
 
 _XFUNCPROTOEND
 
@@ -93,6 +93,11 @@ typedef struct {
     String      *list;		/* for i18n, always in multibyte format */
     XawIconList *iconList;
     XtCallbackList callback;
+    XtCallbackList fetch_callback;	/* fetches the items of a virtual list */
+    int		longest_sample;	/* items measured to estimate longest */
+    Boolean	case_sensitive;	/* of the type-ahead search */
+    Boolean	multi_select;	/* items are selected with the bitset */
+    Boolean	type_ahead;	/* keys are searched for with Search() */
 
     /* private state */
     int         is_highlighted,	/* set to the item currently highlighted. */
@@ -108,6 +113,28 @@ typedef struct {
 
     int         freedoms;       /* flags for resizing height and width */
 
+    Boolean	is_virtual;	/* items are fetched with fetch_callback */
+    double	virtual_height;	/* height needed for all rows */
+    int		row_offset,	/* rows of a virtual list mapped away */
+		pixel_offset,	/* and pixels of the next row */
+		mapped_top;	/* visible top when they were set */
+
+    Dimension	*widths;	/* width of each item, if longest is free */
+    int		widths_size,	/* entries allocated in widths */
+		*width_count,	/* number of items of each width */
+		width_size;	/* entries allocated in width_count */
+    struct _ListAtlas *atlas;	/* icons with clip masks, see List.c */
+
+    int		*sorted;	/* items sorted by string, for Search() */
+    String	prefix;		/* typed so far by Search() */
+    int		prefix_length,
+		prefix_size;	/* bytes allocated for prefix */
+    Time	prefix_time;	/* of the last key typed */
+
+    unsigned char *selected;	/* one bit per item, if multi_select */
+    int		selected_size,	/* bytes allocated for selected */
+		anchor;		/* where Extend() starts */
+
 } ListPart;
 
 
@@ -133,6 +133,11 @@ typedef struct _MultiPiece {	/* Piece of the text file of BUFSIZ allocated
   XawTextPosition used;		/* The number of characters of this buffer
 				   that have been used. */
   struct _MultiPiece *prev, *next;	/* linked list pointers. */
+  struct _MultiPiece *parent, *left, *right;	/* position index (a treap). */
+  XawTextPosition total;	/* characters used in this subtree. */
+  XawTextPosition lines;	/* newlines in this piece. */
+  XawTextPosition line_total;	/* newlines in this subtree. */
+  unsigned long weight;		/* heap priority of the treap node. */
 } MultiPiece;
 
 /************************************************************
@@ -178,6 +183,8 @@ typedef struct _MultiSrcPart {
 				     string in multi_src->string? */
   XawTextPosition length; 	/* length of file - IN CHARACTERS, NOT BYTES. */
   MultiPiece * first_piece;	/* first piece of the text. */
+  MultiPiece * root_piece;	/* root of the position index. */
+  Boolean lines_indexed;	/* are the newline counts valid? */
 } MultiSrcPart;
 
 /****************************************************************
@@ -193,5 +200,9 @@ typedef struct _MultiSrcRec {
 } MultiSrcRec;
 
 extern void _XawMultiSourceFreeString( Widget );
+extern XawTextPosition _XawMultiSourceLineToPosition( Widget, long );
+extern long _XawMultiSourcePositionToLine( Widget, XawTextPosition );
+extern XawTextPosition _XawMultiSourceSearchIgnoreCase( Widget,
+		XawTextPosition, XawTextScanDirection, XawTextBlock * );
 
 #endif /* _XawMultiSrcP_h  --- Don't add anything after this line. */
@@ -87,6 +87,15 @@ in this Software without prior written authorization from The Open Group.
  leftClipMask	     LeftBitmap		ClipMask	None
  rightBitmap         RightBitmap        Bitmap          None
  rightClipMask	     RightBitmap	ClipMask	None
+ leftBitmapName      LeftBitmapName     String          NULL
+ rightBitmapName     RightBitmapName    String          NULL
+ placeholderWidth    PlaceholderWidth   Dimension       0
+ placeholderHeight   PlaceholderHeight  Dimension       0
+
+ The XPM files named by leftBitmapName and rightBitmapName are loaded
+ in the background and set as leftBitmap and leftClipMask, or
+ rightBitmap and rightClipMask, when they are ready. The names are
+ declared in StrToPmap.h.
 */
 
 typedef struct _SmeBSBClassRec    *SmeBSBObjectClass;
@@ -76,6 +76,10 @@ typedef struct {
 	    right_bitmap,	/* bitmaps to show */
 	    left_clipmask,	/* and their clip masks */
 	    right_clipmask;
+  char      *left_bitmap_name,	/* bitmaps loaded in the background */
+	    *right_bitmap_name;
+  Dimension placeholder_width,	/* their size until they are loaded */
+	    placeholder_height;
   Dimension left_margin,
 	    right_margin;	/* left and right margins. */
   Pixel     foreground;		/* foreground color. */
@@ -50,6 +50,35 @@
 
 #include <X11/Intrinsic.h>
 
+/* Resource naming a pixmap bundle, see XawLocatePixmapFile() */
+
+#define XtNpixmapBundle		"pixmapBundle"
+#define XtCPixmapBundle		"PixmapBundle"
+
+/* Resources of Label and SmeBSB naming pixmaps, which are loaded
+ * without blocking the main loop, and the size shown meanwhile
+ */
+
+#define XtNbitmapName		"bitmapName"
+#define XtNleftBitmapName	"leftBitmapName"
+#define XtNrightBitmapName	"rightBitmapName"
+#define XtNplaceholderWidth	"placeholderWidth"
+#define XtNplaceholderHeight	"placeholderHeight"
+#define XtCBitmapName		"BitmapName"
+#define XtCLeftBitmapName	"LeftBitmapName"
+#define XtCRightBitmapName	"RightBitmapName"
+#define XtCPlaceholderWidth	"PlaceholderWidth"
+#define XtCPlaceholderHeight	"PlaceholderHeight"
+
+/* Counters of the color cache used for pixmaps, see XawGetColorCacheStats() */
+
+typedef struct {
+	unsigned long lookups;	/* colors asked for by pixmaps		*/
+	unsigned long hits;	/* answered from the cache, without any	*/
+				/* round trip to the X server		*/
+	unsigned long misses;	/* parsed and allocated on the server	*/
+} XawColorCacheStats;
+
 void XawCvtStringToPixmap(
 	XrmValuePtr,		/* Argument list for the converter	*/
 	Cardinal *,		/* Number of arguments in the list	*/
@@ -74,5 +103,12 @@ Pixmap XawLocatePixmapFile(
 	int *,			/* heightp - RETURN */
 	Pixmap *);		/* clipmask - RETURN */
 
+void XawFlushPixmapPathCache(
+	Display *);		/* dpy, NULL for all displays */
+
+void XawGetColorCacheStats(
+	Display *,		/* dpy */
+	XawColorCacheStats *);	/* stats - RETURN */
+
 #endif
 
@@ -82,6 +82,7 @@ SOFTWARE.
  textSource	    TextSource	     Widget		NULL
  topMargin	    Margin	     Position		2
  unrealizeCallback  Callback	     Callback		NULL
+ updateRate	    UpdateRate	     Int		0
  wrap		    Wrap	     XawTextWrapMode	XawTextWrapNever
 
 */
@@ -109,6 +110,14 @@ typedef struct {
     unsigned long format;
     } XawTextBlock, *XawTextBlockPtr;
 
+typedef struct _XawTextSearchRec *XawTextSearchPattern;
+
+typedef struct {		/* one edit for XawTextReplaceMany() */
+    XawTextPosition startPos;
+    XawTextPosition endPos;
+    XawTextBlock text;
+    } XawTextEdit;
+
 #include <X11/XawPlus/TextSink.h>
 #include <X11/XawPlus/TextSrc.h>
 
@@ -137,11 +146,13 @@ typedef struct {
 #define XtNscrollHorizontal "scrollHorizontal"
 #define XtNselectTypes "selectTypes"
 #define XtNtopMargin "topMargin"
+#define XtNupdateRate "updateRate"
 #define XtNwrap "wrap"
 
 #define XtCAutoFill "AutoFill"
 #define XtCScroll "Scroll"
 #define XtCSelectTypes "SelectTypes"
+#define XtCUpdateRate "UpdateRate"
 #define XtCWrap "Wrap"
 
 #ifndef _XtStringDefs_h_
@@ -215,6 +226,13 @@ extern int XawTextReplace(
     XawTextBlock*	/* text */
 );
 
+extern int XawTextReplaceMany(
+    Widget		/* w */,
+    XawTextEdit*	/* edits */,
+    int			/* num_edits */,
+    int*		/* failed */
+);
+
 extern XawTextPosition XawTextTopPosition(
     Widget		/* w */
 );
@@ -254,6 +272,13 @@ extern XawTextPosition XawTextSearch(
     XawTextBlock*		/* text */
 );
 
+extern XawTextPosition XawTextSearchCompiled(
+    Widget			/* w */,
+    XawTextScanDirection	/* dir */,
+    XawTextSearchPattern	/* pattern */,
+    XawTextPosition*		/* end_return */
+);
+
 extern void XawTextDisplayCaret(
     Widget		/* w */,
     Boolean		/* visible */
@@ -147,6 +147,12 @@ struct SearchAndReplace {
   Widget search_text;           /* The Search text field. */
   Widget rep_one;               /* The Replace one button. */
   Widget rep_all;               /* The Replace all button. */
+  Widget case_toggle;           /* The Ignore case toggle. */
+  Widget regex_toggle;          /* The Regular expression toggle. */
+  XawTextSearchPattern pattern; /* The last compiled search pattern, */
+  Widget pattern_source;        /* the source, */
+  int pattern_options;          /* options */
+  char *pattern_text;           /* and string it was compiled for. */
 };
 
 /* Private Text Definitions */
@@ -188,11 +194,14 @@ typedef struct _TextPart {
     XawTextResizeMode   resize;              /* what to resize */
     XawTextMargin       r_margin;            /* The real margins. */
     XtCallbackList      unrealize_callbacks; /* used for scrollbars */
+    int                 update_rate;         /* XawTextReplace() redisplays
+                                                per second, 0 for all */
 
     /* private state */
 
     XawTextMargin       margin;            /* The current margins. */
     XawTextLineTable    lt;
+    XawTextLineTableEntry *old_info; /* Copy of lt.info, _BuildLineTable */
     XawTextScanDirection extendDir;
     XawTextSelection    origSel;    /* the selection being modified */
     Time            lasttime;       /* timestamp of last processed action */
@@ -205,6 +214,9 @@ typedef struct _TextPart {
     XawTextPosition  *updateTo;     /* Array of end positions for update. */
     int             numranges;      /* How many update ranges there are. */
     int             maxranges;      /* How many ranges we have space for */
+    struct _XawTextLineIndex *line_index; /* Display lines per region. */
+    XtIntervalId    update_timer;   /* Pending XawTextReplace() redisplay */
+    XawTextPosition  damage;        /* The first text it has to show. */
     XawTextPosition  lastPos;       /* Last position of source. */
     GC              gc;
     Boolean         showposition;   /* True if we need to show the position. */
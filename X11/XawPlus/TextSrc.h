@@ -92,6 +92,13 @@ typedef enum {XawactionStart, XawactionAdjust, XawactionEnd}
 #define XawTextReadError -1
 #define XawTextScanError -1
 
+/*
+ * Options for XawTextSourceCompileSearch().
+ */
+
+#define XawTextSearchIgnoreCase	(1<<0)
+#define XawTextSearchRegex	(1<<1)
+
 /************************************************************
  *
  * Public Functions.
@@ -208,6 +215,74 @@ extern void XawTextSourceSetSelection(
     Atom		/* selection */
 );
 
+/*	Function Name: XawTextSourceLineToPosition
+ *	Description: Finds the position where a line starts.
+ *	Arguments: w - the TextSrc object.
+ *                 line - the line number, counting from 0.
+ *	Returns: The position, or the end of the text if there are
+ *               fewer lines.
+ */
+
+extern XawTextPosition XawTextSourceLineToPosition(
+    Widget		/* w */,
+    long		/* line */
+);
+
+/*	Function Name: XawTextSourcePositionToLine
+ *	Description: Finds the line that contains a position.
+ *	Arguments: w - the TextSrc object.
+ *                 position - the position.
+ *	Returns: The line number, counting from 0.
+ */
+
+extern long XawTextSourcePositionToLine(
+    Widget		/* w */,
+    XawTextPosition	/* position */
+);
+
+/*	Function Name: XawTextSourceCompileSearch
+ *	Description: Prepares a string for searching.
+ *	Arguments: w - the TextSrc object.
+ *                 text - the text block to search for.
+ *                 options - XawTextSearchIgnoreCase, XawTextSearchRegex.
+ *	Returns: The pattern, or NULL if the regular expression is bad
+ *               or regular expressions are not supported.
+ */
+
+extern XawTextSearchPattern XawTextSourceCompileSearch(
+    Widget		/* w */,
+    XawTextBlock *	/* text */,
+    int			/* options */
+);
+
+/*	Function Name: XawTextSourceSearchCompiled
+ *	Description: Searches the text source for a compiled pattern.
+ *	Arguments: w - the TextSrc object.
+ *                 position - the position to start searching.
+ *                 dir - direction to search.
+ *                 pattern - the pattern to search for.
+ * RETURNED        end_return - the end of the text found, may be NULL.
+ *	Returns: The position of the text found or XawTextSearchError.
+ */
+
+extern XawTextPosition XawTextSourceSearchCompiled(
+    Widget		/* w */,
+    XawTextPosition	/* position */,
+    XawTextScanDirection /* dir */,
+    XawTextSearchPattern /* pattern */,
+    XawTextPosition *	/* end_return */
+);
+
+/*	Function Name: XawTextSourceFreeSearch
+ *	Description: Frees a pattern.
+ *	Arguments: pattern - the pattern, may be NULL.
+ *	Returns: none.
+ */
+
+extern void XawTextSourceFreeSearch(
+    XawTextSearchPattern /* pattern */
+);
+
 _XFUNCPROTOEND
 
 #endif /* _XawTextSrc_h */
@@ -126,6 +126,9 @@ typedef struct {
   XawTextEditType	edit_mode;
   XrmQuark		text_format;	/* 2 formats: FMT8BIT for Ascii */
 					/*            FMTWIDE for ISO 10646 */
+    /* private state */
+  unsigned long		changes;	/* Replacements made, see */
+					/* XawTextSourceReplace() */
 } TextSrcPart;
 
 /****************************************************************
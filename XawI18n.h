@@ -78,4 +78,7 @@ extern wchar_t _Xaw_atowc (
 #ifndef iswspace
 #define iswspace(c) (isascii(c) && isspace(toascii(c)))
 #endif
+#ifndef towlower
+#define towlower(c) (isascii(c) ? tolower(c) : (c))
+#endif
 #endif
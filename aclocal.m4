@@ -2937,6 +2937,33 @@ esac
 AC_SUBST(LIBTOOL_OPTS)
 ])dnl
 dnl ---------------------------------------------------------------------------
+dnl CF_WITH_PTHREAD version: 1 updated: 2026/10/17 21:00:00
+dnl ---------------
+dnl Check for POSIX threads, which load pixmaps in the background.  Use the C
+dnl library if it has pthread_create(), else add -lpthread.  Without threads,
+dnl the pixmaps are loaded by a work procedure.
+AC_DEFUN([CF_WITH_PTHREAD],
+[
+AC_MSG_CHECKING(if you want to load pixmaps with POSIX threads)
+AC_ARG_WITH(pthread,
+	[  --without-pthread       load pixmaps without POSIX threads],
+	[with_pthread=$withval],
+	[with_pthread=yes])
+AC_MSG_RESULT($with_pthread)
+
+if test "$with_pthread" != no ; then
+	with_pthread=no
+	AC_CHECK_HEADER(pthread.h,[
+	    AC_CHECK_FUNC(pthread_create,[with_pthread=yes],[
+		AC_CHECK_LIB(pthread, pthread_create,[
+		    with_pthread=yes
+		    CF_ADD_LIB(pthread)])])])
+	if test "$with_pthread" = yes ; then
+	    AC_DEFINE(HAVE_LIBPTHREADS,1,[Define to 1 if we have POSIX threads])
+	fi
+fi
+])dnl
+dnl ---------------------------------------------------------------------------
 dnl CF_WITH_REL_VERSION version: 2 updated: 2023/05/06 18:18:18
 dnl -------------------
 dnl Allow library's release-version to be overridden.  Generally this happens when a
@@ -0,0 +1,71 @@
+/* Virtual list test
+ *
+ * Shows a List with ten million items in a Viewport. The items are not
+ * stored anywhere: the list fetches the few items it shows with its
+ * fetchCallback, which makes up the text from the item number. The
+ * second argument scrolls to an item with XawListShowItem().
+ *
+ * Usage: test_list [number of items [item to show]]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <X11/Intrinsic.h>
+#include <X11/StringDefs.h>
+#include <X11/XawPlus/List.h>
+#include <X11/XawPlus/Viewport.h>
+
+/* --- FetchProc() -------------------------------------------------------- */
+
+/* Make up the text of an item. The string has to stay valid until the
+ * next item is fetched, so a static buffer will do.
+ */
+void FetchProc(Widget w, XtPointer client_data, XtPointer call_data)
+{
+	static char		str[40];
+	XawListFetchStruct	*item = (XawListFetchStruct *)call_data;
+
+	sprintf(str, "Item number %d", item->list_index + 1);
+	item->string = str;
+}
+
+/* --- SelectProc() ------------------------------------------------------- */
+
+void SelectProc(Widget w, XtPointer client_data, XtPointer call_data)
+{
+	XawListReturnStruct *item = (XawListReturnStruct *)call_data;
+
+	printf("Selected %d: %s\n", item->list_index, item->string);
+}
+
+/* --- main() --------------------------------------------------------------- */
+
+int main(int argc, char *argv[])
+{
+        XtAppContext	ac;
+        Widget		topLevel, viewport, list;
+	XtCallbackRec	fetch[2];
+	int		nitems;
+
+        topLevel = XtAppInitialize(&ac, "TestList", NULL, 0, &argc, argv, NULL, NULL, 0);
+	nitems = (argc > 1) ? atoi(argv[1]) : 10000000;
+
+	fetch[0].callback = FetchProc;
+	fetch[0].closure = NULL;
+	fetch[1].callback = NULL;
+	fetch[1].closure = NULL;
+
+	viewport = XtVaCreateManagedWidget("viewport", viewportWidgetClass, topLevel,
+		XtNallowVert, True, XtNforceBars, True,
+		XtNwidth, 250, XtNheight, 400, NULL);
+	list = XtVaCreateManagedWidget("list", listWidgetClass, viewport,
+		XtNfetchCallback, fetch, XtNnumberStrings, nitems,
+		XtNdefaultColumns, 1, NULL);
+	XtAddCallback(list, XtNcallback, SelectProc, NULL);
+
+	XtRealizeWidget(topLevel);
+	if (argc > 2) XawListShowItem(list, atoi(argv[2]) - 1);
+	XtAppMainLoop(ac);
+        return 0;
+}
@@ -0,0 +1,151 @@
+/* List repaint benchmark
+ *
+ * Counts the X requests that a full repaint of an icon list needs.
+ * The List widget paints the backgrounds with one request per GC,
+ * the strings of a row with one request and sets each clip mask only
+ * once. It is compared with painting item by item, as the List did
+ * before: one request for every string, and a clip mask change before
+ * every icon.
+ *
+ * Usage: test_listpaint [number of items] [columns]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <X11/Intrinsic.h>
+#include <X11/StringDefs.h>
+#include <X11/XawPlus/List.h>
+
+#define ICONS		3
+#define ICON_SIZE	16
+
+/* --- MakeIcons() -------------------------------------------------------- */
+
+/* Make some icons with round clip masks.
+ */
+void MakeIcons(Widget w, Pixmap *icons, Pixmap *masks)
+{
+	Display	*dpy = XtDisplay(w);
+	Window	root = RootWindowOfScreen(XtScreen(w));
+	GC	gc;
+	int	i;
+
+	for (i = 0; i < ICONS; i++)
+	{
+	   icons[i] = XCreatePixmap(dpy, root, ICON_SIZE, ICON_SIZE,
+				    DefaultDepthOfScreen(XtScreen(w)));
+	   masks[i] = XCreatePixmap(dpy, root, ICON_SIZE, ICON_SIZE, 1);
+
+	   gc = XCreateGC(dpy, icons[i], 0, NULL);
+	   XSetForeground(dpy, gc, (i & 1) ? BlackPixelOfScreen(XtScreen(w))
+					   : WhitePixelOfScreen(XtScreen(w)));
+	   XFillRectangle(dpy, icons[i], gc, 0, 0, ICON_SIZE, ICON_SIZE);
+	   XFreeGC(dpy, gc);
+
+	   gc = XCreateGC(dpy, masks[i], 0, NULL);
+	   XSetForeground(dpy, gc, 0);
+	   XFillRectangle(dpy, masks[i], gc, 0, 0, ICON_SIZE, ICON_SIZE);
+	   XSetForeground(dpy, gc, 1);
+	   XFillArc(dpy, masks[i], gc, i, i, ICON_SIZE - 2 * i, ICON_SIZE - 2 * i, 0, 360 * 64);
+	   XFreeGC(dpy, gc);
+	}
+}
+
+/* --- PaintItemByItem() -------------------------------------------------- */
+
+/* Paint the list the old way. The layout is taken from the widget.
+ */
+void PaintItemByItem(Widget w, XawIconList *list, int nitems, int columns)
+{
+	Display		*dpy = XtDisplay(w);
+	Window		win = XtWindow(w);
+	XFontStruct	*font;
+	Dimension	width;
+	GC		gc, icon_gc;
+	int		i, x, y, col_width, row_height = 20;
+
+	XtVaGetValues(w, XtNfont, &font, XtNwidth, &width, NULL);
+	col_width = width / columns;
+	gc = XCreateGC(dpy, win, 0, NULL);
+	icon_gc = XCreateGC(dpy, win, 0, NULL);
+	XSetFont(dpy, gc, font->fid);
+
+	for (i = 0; i < nitems; i++)
+	{
+	   x = (i % columns) * col_width;
+	   y = (i / columns) * row_height;
+	   XSetClipMask(dpy, icon_gc, list[i].clipMask);
+	   XSetClipOrigin(dpy, icon_gc, x, y);
+	   XCopyArea(dpy, list[i].bitmap, win, icon_gc, 0, 0, ICON_SIZE, ICON_SIZE, x, y);
+	   XDrawString(dpy, win, gc, x + ICON_SIZE + 4, y + font->ascent,
+		       list[i].string, strlen(list[i].string));
+	}
+	XFreeGC(dpy, gc);
+	XFreeGC(dpy, icon_gc);
+}
+
+/* --- main() --------------------------------------------------------------- */
+
+int main(int argc, char *argv[])
+{
+        XtAppContext	ac;
+        Widget		topLevel, list;
+	XawIconList	*items;
+	Pixmap		icons[ICONS], masks[ICONS];
+	XEvent		event;
+	Dimension	width, height;
+	unsigned long	start;
+	int		i, nitems, columns;
+
+        topLevel = XtAppInitialize(&ac, "TestListPaint", NULL, 0, &argc, argv, NULL, NULL, 0);
+	nitems = (argc > 1) ? atoi(argv[1]) : 200;
+	columns = (argc > 2) ? atoi(argv[2]) : 4;
+	if (nitems < 1) nitems = 1;
+	if (columns < 1) columns = 1;
+
+	MakeIcons(topLevel, icons, masks);
+	items = (XawIconList *)XtMalloc(nitems * sizeof(XawIconList));
+	for (i = 0; i < nitems; i++)
+	{
+	   char name[32];
+
+	   sprintf(name, "file%d.txt", i);
+	   items[i].string = XtNewString(name);
+	   items[i].bitmap = icons[i % ICONS];
+	   items[i].clipMask = masks[i % ICONS];
+	}
+	list = XtVaCreateManagedWidget("list", listWidgetClass, topLevel,
+		XtNiconList, items, XtNnumberStrings, nitems,
+		XtNiconWidth, ICON_SIZE, XtNiconHeight, ICON_SIZE,
+		XtNiconDepth, DefaultDepthOfScreen(XtScreen(topLevel)),
+		XtNdefaultColumns, columns, XtNforceColumns, True, NULL);
+	XtRealizeWidget(topLevel);
+	XSync(XtDisplay(list), False);
+	XtVaGetValues(list, XtNwidth, &width, XtNheight, &height, NULL);
+
+	/* The List repaints its window on an expose event */
+
+	memset(&event, 0, sizeof(event));
+	event.xexpose.type = Expose;
+	event.xexpose.display = XtDisplay(list);
+	event.xexpose.window = XtWindow(list);
+	event.xexpose.width = width;
+	event.xexpose.height = height;
+
+	printf("%d items in %d columns, %dx%d pixels\n", nitems, columns, width, height);
+
+	start = NextRequest(XtDisplay(list));
+	PaintItemByItem(list, items, nitems, columns);
+	printf("%-20s %6lu requests\n", "item by item:", NextRequest(XtDisplay(list)) - start);
+
+	start = NextRequest(XtDisplay(list));
+	XtDispatchEvent(&event);
+	printf("%-20s %6lu requests\n", "List:", NextRequest(XtDisplay(list)) - start);
+
+	XSync(XtDisplay(list), False);
+	for (i = 0; i < nitems; i++) XtFree(items[i].string);
+	XtFree((char *)items);
+        return 0;
+}
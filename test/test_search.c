@@ -0,0 +1,136 @@
+/* Search benchmark
+ *
+ * Times XawTextSourceSearch() on a large AsciiSrc against the simple
+ * character by character matcher that the AsciiSrc used before, which
+ * backs up after every partial match.  The text is made of lines that
+ * almost match: forward we search for "aa...ab", which is found only at
+ * the end, and backward for "baa...a", which is found only at the start.
+ *
+ * Usage: test_search [size in KB] [string length]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <X11/Intrinsic.h>
+#include <X11/StringDefs.h>
+#include <X11/XawPlus/AsciiSrc.h>
+
+#define ROUNDS	10
+
+/* --- NaiveSearch() ------------------------------------------------------ */
+
+/* The old matcher, working on a flat copy of the text.
+ */
+long NaiveSearch(char *text, long length, long position, int right,
+		 char *str, int len)
+{
+	int inc = right ? 1 : -1, count = 0;
+
+	if (!right)
+	{
+	   if (position == 0) return -1;
+	   position--;
+	}
+	while (position >= 0 && position < length)
+	{
+	   if (text[position] == (right ? str[count] : str[len - count - 1]))
+	   {
+	      if (count == len - 1)
+		 return right ? position - (len - 1) : position;
+	      count++;
+	   }
+	   else
+	   {
+	      position -= inc * count;
+	      count = 0;
+	   }
+	   position += inc;
+	}
+	return -1;
+}
+
+/* --- Seconds() ---------------------------------------------------------- */
+
+double Seconds(clock_t start)
+{
+	return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/* --- main() --------------------------------------------------------------- */
+
+int main(int argc, char *argv[])
+{
+        XtAppContext	ac;
+        Widget		src, topLevel;
+	XawTextBlock	block;
+	XawTextPosition	pos = 0;
+	clock_t		start;
+	long		size, i, found = 0;
+	int		len, n;
+	char		*text, *str, *rstr;
+
+        topLevel = XtAppInitialize(&ac, "TestSearch", NULL, 0, &argc, argv, NULL, NULL, 0);
+
+	size = (argc > 1) ? atol(argv[1]) * 1024 : 4096 * 1024;
+	len  = (argc > 2) ? atoi(argv[2]) : 32;
+	if (size < 2 * len) size = 2 * len;
+
+	text = XtMalloc(size + 1);
+	str  = XtMalloc(len + 1);
+	rstr = XtMalloc(len + 1);
+	for (i = 0; i < size; i++)
+	   text[i] = (i % 64 == 63) ? '\n' : 'a';
+	for (i = 0; i < len; i++)
+	{
+	   str[i]  = (i == len - 1) ? 'b' : 'a';
+	   rstr[i] = (i == 0) ? 'b' : 'a';
+	}
+	str[len] = rstr[len] = '\0';
+	memcpy(text, rstr, len);
+	memcpy(text + size - len, str, len);
+	text[size] = '\0';
+
+	src = XtVaCreateWidget("source", asciiSrcObjectClass, topLevel,
+		XtNstring, text, XtNtype, XawAsciiString, NULL);
+
+	block.firstPos = 0;
+	block.length = len;
+	block.ptr = str;
+	block.format = XawFmt8Bit;
+
+	printf("text %ld bytes, string %d bytes, %d rounds\n", size, len, ROUNDS);
+
+	start = clock();
+	for (n = 0; n < ROUNDS; n++)
+	   found += NaiveSearch(text, size, 1, 1, str, len);
+	printf("%-20s %8.3f s\n", "old, forward:", Seconds(start));
+
+	start = clock();
+	for (n = 0; n < ROUNDS; n++)
+	   pos += XawTextSourceSearch(src, 1, XawsdRight, &block);
+	printf("%-20s %8.3f s\n", "AsciiSrc, forward:", Seconds(start));
+
+	block.ptr = rstr;
+
+	start = clock();
+	for (n = 0; n < ROUNDS; n++)
+	   found += NaiveSearch(text, size, size - 1, 0, rstr, len);
+	printf("%-20s %8.3f s\n", "old, backward:", Seconds(start));
+
+	start = clock();
+	for (n = 0; n < ROUNDS; n++)
+	   pos += XawTextSourceSearch(src, size - 1, XawsdLeft, &block);
+	printf("%-20s %8.3f s\n", "AsciiSrc, backward:", Seconds(start));
+
+	if (found != pos)
+	   printf("results differ: %ld and %ld\n", found, (long)pos);
+
+	XtDestroyWidget(src);
+	XtFree(text);
+	XtFree(str);
+	XtFree(rstr);
+        return 0;
+}
@@ -0,0 +1,144 @@
+/* Text updateRate test
+ *
+ * Replaces text in an AsciiText with an updateRate while it owns the
+ * selection, as when text is selected in a log window that is still
+ * being written to. After each replacement the redisplay has to be
+ * either pending or done, and when the timer has fired the line table
+ * has to match the text and the insertion cursor has to be shown.
+ *
+ * Usage: test_textrate [rounds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <X11/IntrinsicP.h>
+#include <X11/StringDefs.h>
+#include <X11/XawPlus/AsciiText.h>
+#include <X11/XawPlus/TextP.h>
+
+#define MAX_TEXT	65536
+
+static char	text[MAX_TEXT];		/* What the widget should hold */
+static int	errors = 0;
+
+/* --- Replace() ---------------------------------------------------------- */
+
+/* Replace from start to end with str, in the widget and in our copy.
+ */
+void Replace(Widget w, long start, long end, char *str)
+{
+	TextWidget	ctx = (TextWidget)w;
+	XawTextBlock	block;
+	long		len = strlen(text), n = strlen(str);
+
+	block.firstPos = 0;
+	block.length = n;
+	block.ptr = str;
+	block.format = XawFmt8Bit;
+	if (XawTextReplace(w, start, end, &block) != XawEditDone)
+	{
+	   printf("replace %ld-%ld refused\n", start, end);
+	   errors++;
+	   return;
+	}
+	memmove(text + start + n, text + end, len - end + 1);
+	memcpy(text + start, str, n);
+
+	if (ctx->text.update_timer == 0 && ctx->text.old_insert >= 0)
+	{
+	   printf("replace %ld-%ld: no redisplay pending or done\n", start, end);
+	   errors++;
+	}
+}
+
+/* --- CheckLines() ------------------------------------------------------- */
+
+/* Wait for the redisplay and compare the line table with the text.
+ */
+void CheckLines(XtAppContext ac, Widget w, int round)
+{
+	TextWidget	ctx = (TextWidget)w;
+	XawTextPosition	pos;
+	int		i;
+
+	while (ctx->text.update_timer != 0)
+	   XtAppProcessEvent(ac, XtIMAll);
+
+	if (ctx->text.old_insert >= 0)
+	{
+	   printf("round %d: the cursor is still off\n", round);
+	   errors++;
+	}
+	pos = ctx->text.lt.top;
+	if (pos > 0 && text[pos - 1] != '\n')
+	{
+	   printf("round %d: top %ld is not at a line start\n", round, (long)pos);
+	   errors++;
+	}
+	for (i = 0; i < ctx->text.lt.lines && text[pos] != '\0'; i++)
+	{
+	   if (ctx->text.lt.info[i].position != pos)
+	   {
+	      printf("round %d: line %d at %ld, should be at %ld\n", round, i,
+		     (long)ctx->text.lt.info[i].position, (long)pos);
+	      errors++;
+	      return;
+	   }
+	   while (text[pos] != '\0' && text[pos++] != '\n') ;
+	}
+}
+
+/* --- main() --------------------------------------------------------------- */
+
+int main(int argc, char *argv[])
+{
+        XtAppContext	ac;
+        Widget		topLevel, w;
+	XawTextPosition	left, right;
+	char		line[40];
+	int		rounds, round, i;
+
+        topLevel = XtAppInitialize(&ac, "TestTextRate", NULL, 0, &argc, argv, NULL, NULL, 0);
+	rounds = (argc > 1) ? atoi(argv[1]) : 50;
+	strcpy(text, "first line\n");
+
+	w = XtVaCreateManagedWidget("text", asciiTextWidgetClass, topLevel,
+		XtNstring, text, XtNeditType, XawtextEdit, XtNwrap, XawtextWrapNever,
+		XtNupdateRate, 20, XtNwidth, 400, XtNheight, 300, NULL);
+	XtRealizeWidget(topLevel);
+
+	for (round = 0; round < rounds; round++)
+	{
+	   XawTextSetSelection(w, 0, 4);
+	   XawTextGetSelectionPos(w, &left, &right);
+	   if (left == right)
+	   {
+	      printf("round %d: no selection\n", round);
+	      errors++;
+	   }
+
+	   for (i = 0; i < 5 && strlen(text) + sizeof(line) < MAX_TEXT; i++)
+	   {
+	      sprintf(line, "line %d.%d\n", round, i);
+	      Replace(w, strlen(text), strlen(text), line);
+	   }
+	   if (strlen(text) + sizeof(line) < MAX_TEXT)
+	   {
+	      sprintf(line, "top %d\n", round);
+	      Replace(w, 0, 0, line);
+	   }
+
+	   XawTextGetSelectionPos(w, &left, &right);
+	   if (left != right)
+	   {
+	      printf("round %d: the selection was kept\n", round);
+	      errors++;
+	   }
+	   CheckLines(ac, w, round);
+	}
+
+	printf("%d rounds, %d errors\n", rounds, errors);
+        return errors != 0;
+}
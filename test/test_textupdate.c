@@ -0,0 +1,258 @@
+/* Text update test
+ *
+ * Makes random edits in a wrapped AsciiText, with XawTextReplace() and
+ * XawTextReplaceMany(), some of them while the redisplay is disabled.
+ * After each edit the update ranges have to be sorted and apart, the
+ * line table that was repaired has to equal one built from scratch at
+ * the same top, and the text has to equal our copy of it.
+ *
+ * Usage: test_textupdate [edits] [seed]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <X11/IntrinsicP.h>
+#include <X11/StringDefs.h>
+#include <X11/XawPlus/AsciiText.h>
+#include <X11/XawPlus/TextP.h>
+
+#define MAX_TEXT	32768
+#define MAX_EDITS	8
+#define Min(a, b)	((a) < (b) ? (a) : (b))
+
+static char		text[MAX_TEXT];	/* What the widget should hold */
+static unsigned long	seed = 1;
+static int		errors = 0;
+
+/* --- Random() ----------------------------------------------------------- */
+
+/* The same numbers on every system, so that a seed can be repeated.
+ */
+long Random(long n)
+{
+	seed = seed * 1103515245 + 12345;
+	return (long)((seed >> 16) & 0x7fff) % n;
+}
+
+/* Fill str with up to len random characters: words, blanks and newlines,
+ * and now and then a word that is longer than a line.
+ */
+void RandomString(char *str, long len)
+{
+	static char	chars[] = "abcdefghij  \n";
+	long		i, n = Random(len + 1);
+
+	for (i = 0; i < n; i++)
+	   str[i] = (Random(100) == 0) ? '\n' : chars[Random(sizeof(chars) - 1)];
+	if (n > 0 && Random(20) == 0)
+	   for (i = 0; i < n; i++) str[i] = 'x';
+	str[n] = '\0';
+}
+
+/* --- CheckRanges() ------------------------------------------------------ */
+
+/* The update ranges are kept sorted, and ranges that touch are merged.
+ */
+void CheckRanges(TextWidget ctx, int edit)
+{
+	int i;
+
+	for (i = 0; i < ctx->text.numranges; i++)
+	{
+	   if (ctx->text.updateFrom[i] < 0 ||
+	       ctx->text.updateFrom[i] >= ctx->text.updateTo[i] ||
+	       (i > 0 && ctx->text.updateFrom[i] <= ctx->text.updateTo[i - 1]))
+	   {
+	      printf("edit %d: update range %d is %ld-%ld after %ld\n", edit, i,
+		     (long)ctx->text.updateFrom[i], (long)ctx->text.updateTo[i],
+		     i > 0 ? (long)ctx->text.updateTo[i - 1] : -1L);
+	      errors++;
+	      return;
+	   }
+	}
+}
+
+/* --- CheckTable() ------------------------------------------------------- */
+
+/* Compare the line table with one built from scratch, and the text with
+ * our copy.
+ */
+void CheckTable(TextWidget ctx, int edit)
+{
+	static XawTextLineTableEntry	*old = NULL;
+	XawTextBlock			block;
+	XawTextPosition			pos;
+	int				i, lines = ctx->text.lt.lines;
+
+	old = (XawTextLineTableEntry *)XtRealloc((char *)old,
+			(lines + 1) * sizeof(XawTextLineTableEntry));
+	memcpy(old, ctx->text.lt.info, (lines + 1) * sizeof(XawTextLineTableEntry));
+	_XawTextBuildLineTable(ctx, ctx->text.lt.top, TRUE);
+
+	for (i = 0; i <= lines; i++)
+	{
+	   if (old[i].position != ctx->text.lt.info[i].position ||
+	       old[i].y != ctx->text.lt.info[i].y ||
+	       old[i].textWidth != ctx->text.lt.info[i].textWidth)
+	   {
+	      printf("edit %d: line %d is %ld/%d/%d, should be %ld/%d/%d\n",
+		     edit, i, (long)old[i].position, old[i].y, old[i].textWidth,
+		     (long)ctx->text.lt.info[i].position, ctx->text.lt.info[i].y,
+		     ctx->text.lt.info[i].textWidth);
+	      errors++;
+	      break;
+	   }
+	}
+
+	for (pos = 0; text[pos] != '\0'; pos += block.length)
+	{
+	   XawTextSourceRead(ctx->text.source, pos, &block, MAX_TEXT);
+	   if (block.length == 0 || strncmp(block.ptr, text + pos, block.length))
+	   {
+	      printf("edit %d: the text differs at %ld\n", edit, (long)pos);
+	      errors++;
+	      return;
+	   }
+	}
+	if (ctx->text.lastPos != pos)
+	{
+	   printf("edit %d: lastPos %ld, should be %ld\n", edit,
+		  (long)ctx->text.lastPos, (long)pos);
+	   errors++;
+	}
+}
+
+/* --- Replace() ---------------------------------------------------------- */
+
+/* Make one random edit with XawTextReplace(), in the widget and our copy.
+ */
+void Replace(Widget w)
+{
+	static char	str[80];
+	XawTextBlock	block;
+	long		len = strlen(text), start, end, n;
+
+	start = Random(len + 1);
+	end = start + Random(Min(len - start, 40) + 1);
+	RandomString(str, 40);
+	n = strlen(str);
+	if (len - (end - start) + n >= MAX_TEXT) return;
+
+	block.firstPos = 0;
+	block.length = n;
+	block.ptr = str;
+	block.format = XawFmt8Bit;
+	if (XawTextReplace(w, start, end, &block) != XawEditDone)
+	{
+	   printf("replace %ld-%ld refused\n", start, end);
+	   errors++;
+	   return;
+	}
+	memmove(text + start + n, text + end, len - end + 1);
+	memcpy(text + start, str, n);
+}
+
+/* --- ReplaceMany() ------------------------------------------------------ */
+
+/* Make a few random edits with XawTextReplaceMany().
+ */
+void ReplaceMany(Widget w)
+{
+	static char	str[MAX_EDITS][40];
+	XawTextEdit	sorted[MAX_EDITS], edits[MAX_EDITS];
+	long		len = strlen(text), pos = 0, grow = 0;
+	int		num = 1 + Random(MAX_EDITS), reverse, i, failed;
+
+	/* Sorted and apart, then passed in either order: it must not matter. */
+	for (i = 0; i < num; i++)
+	{
+	   sorted[i].startPos = pos + Random((len - pos) / (num - i) + 1);
+	   sorted[i].endPos = sorted[i].startPos + Random(Min(len - sorted[i].startPos, 20) + 1);
+	   pos = sorted[i].endPos;
+	   RandomString(str[i], sizeof(str[i]) - 1);
+	   sorted[i].text.firstPos = 0;
+	   sorted[i].text.length = strlen(str[i]);
+	   sorted[i].text.ptr = str[i];
+	   sorted[i].text.format = XawFmt8Bit;
+	   grow += sorted[i].text.length - (sorted[i].endPos - sorted[i].startPos);
+	}
+	if (len + grow >= MAX_TEXT) return;
+	reverse = Random(2);
+	for (i = 1; i < num; i++)	/* Inserts at one place go in array order */
+	   if (sorted[i].startPos == sorted[i - 1].startPos) reverse = 0;
+	for (i = 0; i < num; i++)
+	   edits[i] = sorted[reverse ? num - 1 - i : i];
+
+	if (XawTextReplaceMany(w, edits, num, &failed) != XawEditDone || failed != -1)
+	{
+	   printf("%d edits refused at %d\n", num, failed);
+	   errors++;
+	   return;
+	}
+	for (i = num - 1; i >= 0; i--)	/* From the end, as the widget does */
+	{
+	   long n = sorted[i].text.length;
+
+	   len = strlen(text);
+	   memmove(text + sorted[i].startPos + n, text + sorted[i].endPos,
+		   len - sorted[i].endPos + 1);
+	   memcpy(text + sorted[i].startPos, sorted[i].text.ptr, n);
+	}
+}
+
+/* --- main() --------------------------------------------------------------- */
+
+int main(int argc, char *argv[])
+{
+        XtAppContext	ac;
+        Widget		topLevel, w;
+	TextWidget	ctx;
+	int		edits, edit, disabled = 0;
+
+        topLevel = XtAppInitialize(&ac, "TestTextUpdate", NULL, 0, &argc, argv, NULL, NULL, 0);
+	edits = (argc > 1) ? atoi(argv[1]) : 5000;
+	seed = (argc > 2) ? strtoul(argv[2], NULL, 10) : 1;
+
+	while (strlen(text) < 4000) RandomString(text + strlen(text), 60);
+
+	w = XtVaCreateManagedWidget("text", asciiTextWidgetClass, topLevel,
+		XtNstring, text, XtNeditType, XawtextEdit, XtNwrap, XawtextWrapWord,
+		XtNscrollVertical, XawtextScrollAlways,
+		XtNwidth, 300, XtNheight, 400, NULL);
+	ctx = (TextWidget)w;
+	XtRealizeWidget(topLevel);
+
+	for (edit = 0; edit < edits; edit++)
+	{
+	   switch (Random(10))
+	   {
+	      case 0:
+		 XawTextSetInsertionPoint(w, Random(strlen(text) + 1));
+		 break;
+	      case 1:
+		 ReplaceMany(w);
+		 break;
+	      case 2:
+		 if (disabled) XawTextEnableRedisplay(w);
+		 else XawTextDisableRedisplay(w);
+		 disabled = !disabled;
+		 break;
+	      default:
+		 Replace(w);
+		 break;
+	   }
+	   CheckRanges(ctx, edit);
+	   if (!disabled && ctx->text.numranges != 0)
+	   {
+	      printf("edit %d: %d update ranges left\n", edit, ctx->text.numranges);
+	      errors++;
+	   }
+	   CheckTable(ctx, edit);
+	   while (XtAppPending(ac)) XtAppProcessEvent(ac, XtIMAll);
+	}
+
+	printf("%d edits, %d errors\n", edits, errors);
+        return errors != 0;
+}
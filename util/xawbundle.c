@@ -0,0 +1,273 @@
+/* Pixmap bundle writer
+ *
+ * Converts XPM files into one pixmap bundle (see PmapBundle.h), which
+ * XawLocatePixmapFile() uses instead of searching and parsing the XPM
+ * files when the resource pixmapBundle names it:
+ *
+ *	*pixmapBundle:	/usr/share/myapp/icons.bundle
+ *
+ * The pixmaps are named by the file names without directories, as they
+ * are given to the bitmap resources. Named colors are looked up on the
+ * display, so it must be reachable when the files use color names.
+ *
+ * Usage: xawbundle output file.xpm|directory ...
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include <X11/Xlib.h>
+#include <X11/xpm.h>
+
+#include "../PmapBundle.h"
+
+typedef struct {
+	char		*name;
+	unsigned	width, height, ncolors;
+	unsigned long	*palette;
+	unsigned char	*pixels, *mask;
+	unsigned long	offset[BUNDLE_ENTRY / 4];
+} Pixmap_;
+
+static Pixmap_	*pixmaps = NULL;
+static int	count = 0, size = 0;
+static Display	*dpy = NULL;
+
+/* --- Fail() ------------------------------------------------------------- */
+
+static void Fail(char *message, char *name)
+{
+	fprintf(stderr, "xawbundle: %s %s\n", message, name);
+	exit(1);
+}
+
+/* --- GetRGB() ----------------------------------------------------------- */
+
+/* Get the RGB value of an XPM color, return -1 for "None".
+ */
+static long GetRGB(XpmColor *color, char *file)
+{
+	char	*spec = color->c_color;
+	XColor	xcolor;
+	size_t	n;
+
+	if (spec == NULL) spec = color->g_color;
+	if (spec == NULL) spec = color->g4_color;
+	if (spec == NULL) spec = color->m_color;
+	if (spec == NULL || strcasecmp(spec, "None") == 0) return -1;
+
+	/* #RGB, #RRGGBB ... need no display */
+
+	if (spec[0] == '#' && (n = strlen(spec + 1)) % 3 == 0 && n > 0 && n <= 12 &&
+	    strspn(spec + 1, "0123456789abcdefABCDEF") == n)
+	{
+	   long	rgb = 0;
+	   int	i;
+
+	   for (i = 0; i < 3; i++)
+	   {
+	      char digits[5];
+
+	      memcpy(digits, spec + 1 + i * n / 3, n / 3);
+	      digits[n / 3] = '\0';
+	      rgb = (rgb << 8) | ((strtol(digits, NULL, 16) << (16 - 4 * n / 3)) >> 8);
+	   }
+	   return rgb;
+	}
+	if (dpy == NULL && (dpy = XOpenDisplay(NULL)) == NULL)
+	   Fail("cannot open the display for the colors of", file);
+	if (!XParseColor(dpy, DefaultColormap(dpy, DefaultScreen(dpy)), spec, &xcolor))
+	   Fail("bad color in", file);
+	return ((long)(xcolor.red >> 8) << 16) | ((xcolor.green >> 8) << 8) | (xcolor.blue >> 8);
+}
+
+/* --- AddFile() ---------------------------------------------------------- */
+
+static void AddFile(char *file)
+{
+	XpmImage	image;
+	Pixmap_		*p;
+	char		*name;
+	long		*rgb;
+	unsigned	i, n, bpl, transparent = 0;
+
+	if (XpmReadFileToXpmImage(file, &image, NULL) != XpmSuccess)
+	   Fail("cannot read", file);
+	if (count == size)
+	{
+	   size = size ? 2 * size : 64;
+	   if ((pixmaps = (Pixmap_ *)realloc(pixmaps, size * sizeof(Pixmap_))) == NULL)
+	      Fail("out of memory for", file);
+	}
+	p = &pixmaps[count++];
+	memset(p, 0, sizeof(Pixmap_));
+	name = strrchr(file, '/');
+	p->name = strdup(name ? name + 1 : file);
+	p->width = image.width;
+	p->height = image.height;
+	p->ncolors = image.ncolors;
+	n = image.width * image.height;
+	bpl = (image.width + 7) / 8;
+
+	rgb = (long *)malloc(image.ncolors * sizeof(long));
+	p->palette = (unsigned long *)malloc(image.ncolors * sizeof(unsigned long));
+	p->pixels = (unsigned char *)malloc(n * 2);
+	p->mask = (unsigned char *)calloc(bpl * image.height, 1);
+	if (!rgb || !p->palette || !p->pixels || !p->mask)
+	   Fail("out of memory for", file);
+
+	for (i = 0; i < image.ncolors; i++)
+	{
+	   rgb[i] = GetRGB(&image.colorTable[i], file);
+	   p->palette[i] = (rgb[i] < 0) ? 0 : (unsigned long)rgb[i];
+	}
+	for (i = 0; i < n; i++)
+	{
+	   unsigned index = image.data[i];
+
+	   if (index >= image.ncolors) index = 0;
+	   if (image.ncolors > 256)
+	   {
+	      p->pixels[2 * i] = (unsigned char)(index >> 8);
+	      p->pixels[2 * i + 1] = (unsigned char)index;
+	   }
+	   else p->pixels[i] = (unsigned char)index;
+
+	   if (rgb[index] < 0) transparent = 1;
+	   else p->mask[(i / image.width) * bpl + (i % image.width) / 8] |=
+		   1 << ((i % image.width) % 8);
+	}
+	if (!transparent)
+	{
+	   free(p->mask);
+	   p->mask = NULL;
+	}
+	free(rgb);
+	XpmFreeXpmImage(&image);
+}
+
+/* --- AddPath() ---------------------------------------------------------- */
+
+/* Add a file, or all XPM files in a directory.
+ */
+static void AddPath(char *path)
+{
+	struct stat	sb;
+	struct dirent	*entry;
+	DIR		*dir;
+	char		*file;
+	size_t		len;
+
+	if (stat(path, &sb) != 0) Fail("cannot find", path);
+	if (!S_ISDIR(sb.st_mode))
+	{
+	   AddFile(path);
+	   return;
+	}
+	if ((dir = opendir(path)) == NULL) Fail("cannot read", path);
+	while ((entry = readdir(dir)) != NULL)
+	{
+	   len = strlen(entry->d_name);
+	   if (len < 4 || strcmp(entry->d_name + len - 4, ".xpm") != 0) continue;
+	   if ((file = malloc(strlen(path) + len + 2)) == NULL)
+	      Fail("out of memory for", path);
+	   sprintf(file, "%s/%s", path, entry->d_name);
+	   AddFile(file);
+	   free(file);
+	}
+	closedir(dir);
+}
+
+/* --- Put() -------------------------------------------------------------- */
+
+static void Put(FILE *fp, unsigned long value)
+{
+	putc((int)(value >> 24) & 0xff, fp);
+	putc((int)(value >> 16) & 0xff, fp);
+	putc((int)(value >> 8) & 0xff, fp);
+	putc((int)value & 0xff, fp);
+}
+
+static int CompareNames(const void *a, const void *b)
+{
+	return strcmp(((Pixmap_ *)a)->name, ((Pixmap_ *)b)->name);
+}
+
+/* --- main() --------------------------------------------------------------- */
+
+int main(int argc, char *argv[])
+{
+	FILE		*fp;
+	unsigned long	offset;
+	unsigned	bytes;
+	int		i, j;
+
+	if (argc < 3)
+	{
+	   fprintf(stderr, "Usage: xawbundle output file.xpm|directory ...\n");
+	   return 1;
+	}
+	for (i = 2; i < argc; i++) AddPath(argv[i]);
+	qsort(pixmaps, count, sizeof(Pixmap_), CompareNames);
+	for (i = 1; i < count; i++)
+	   if (strcmp(pixmaps[i - 1].name, pixmaps[i].name) == 0)
+	      Fail("duplicate pixmap", pixmaps[i].name);
+
+	/* Lay out the data behind the index */
+
+	offset = BUNDLE_HEADER + (unsigned long)count * BUNDLE_ENTRY;
+	for (i = 0; i < count; i++)
+	{
+	   Pixmap_ *p = &pixmaps[i];
+
+	   p->offset[BUNDLE_NAME] = offset;
+	   offset += (strlen(p->name) + 4) & ~3UL;
+	   p->offset[BUNDLE_WIDTH] = p->width;
+	   p->offset[BUNDLE_HEIGHT] = p->height;
+	   p->offset[BUNDLE_NCOLORS] = p->ncolors;
+	   p->offset[BUNDLE_PALETTE] = offset;
+	   offset += 4 * p->ncolors;
+	   p->offset[BUNDLE_PIXELS] = offset;
+	   bytes = p->width * p->height * ((p->ncolors > 256) ? 2 : 1);
+	   offset += (bytes + 3) & ~3U;
+	   if (p->mask)
+	   {
+	      p->offset[BUNDLE_MASK] = offset;
+	      bytes = (p->width + 7) / 8 * p->height;
+	      offset += (bytes + 3) & ~3U;
+	   }
+	}
+
+	if ((fp = fopen(argv[1], "wb")) == NULL) Fail("cannot write", argv[1]);
+	Put(fp, BUNDLE_MAGIC);
+	Put(fp, BUNDLE_VERSION);
+	Put(fp, count);
+	for (i = 0; i < count; i++)
+	   for (j = 0; j < BUNDLE_ENTRY / 4; j++)
+	      Put(fp, pixmaps[i].offset[j]);
+	for (i = 0; i < count; i++)
+	{
+	   Pixmap_ *p = &pixmaps[i];
+	   size_t len = strlen(p->name);
+
+	   fwrite(p->name, 1, len, fp);
+	   for (j = len; j < (int)((len + 4) & ~3UL); j++) putc(0, fp);
+	   for (j = 0; j < (int)p->ncolors; j++) Put(fp, p->palette[j]);
+	   bytes = p->width * p->height * ((p->ncolors > 256) ? 2 : 1);
+	   fwrite(p->pixels, 1, bytes, fp);
+	   for (; bytes & 3; bytes++) putc(0, fp);
+	   if (p->mask)
+	   {
+	      bytes = (p->width + 7) / 8 * p->height;
+	      fwrite(p->mask, 1, bytes, fp);
+	      for (; bytes & 3; bytes++) putc(0, fp);
+	   }
+	}
+	if (fclose(fp) != 0) Fail("cannot write", argv[1]);
+	if (dpy) XCloseDisplay(dpy);
+	printf("%d pixmaps written to %s\n", count, argv[1]);
+	return 0;
+}